@@ -0,0 +1,212 @@
+
+#ifndef _TBT_BENCHMARK_REPORT_H
+#define _TBT_BENCHMARK_REPORT_H
+
+#include <tbt/Utility.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+//! Statistics of repeated measurements (in milliseconds).
+struct BenchmarkStatistics
+{
+	double m_min;     //!< the minimum.
+	double m_median;  //!< the median.
+	double m_mean;    //!< the arithmetic mean.
+
+	//! Computes the statistics of \a times (which must not be empty).
+	explicit BenchmarkStatistics(std::vector<double> times) {
+		std::sort(times.begin(), times.end());
+		size_t n = times.size();
+
+		m_min    = times[0];
+		m_median = (n % 2 == 1) ? times[n/2] : 0.5 * (times[n/2-1] + times[n/2]);
+
+		double sum = 0.0;
+		for(size_t i = 0; i < n; ++i)
+			sum += times[i];
+		m_mean = sum / n;
+	}
+};
+
+
+//! Collects the results of a benchmark as rows of named values and writes them as CSV or JSON.
+/**
+ * All rows should set the same columns in the same order; the columns of the first row are used for the
+ * CSV header. Values are stored as text, numeric values are written without quotes in JSON.
+ */
+class BenchmarkReport
+{
+public:
+	//! A row of the report.
+	class Row
+	{
+		friend class BenchmarkReport;
+
+		struct Value {
+			std::string m_name;
+			std::string m_text;
+			bool        m_numeric;
+		};
+
+		std::vector<Value> m_values;
+
+		void add(const std::string &name, const std::string &text, bool numeric) {
+			Value v;
+			v.m_name    = name;
+			v.m_text    = text;
+			v.m_numeric = numeric;
+			m_values.push_back(v);
+		}
+
+	public:
+		//! Sets column \a name to string \a value.
+		Row &set(const std::string &name, const std::string &value) { add(name, value, false); return *this; }
+
+		//! Sets column \a name to string \a value.
+		Row &set(const std::string &name, const char *value) { add(name, value, false); return *this; }
+
+		//! Sets column \a name to numeric \a value.
+		/**
+		 * Infinite and NaN values (e.g., a bandwidth computed from a zero time) cannot be represented in
+		 * JSON; they are written as <tt>null</tt> to JSON and as an empty field to CSV.
+		 */
+		Row &setValue(const std::string &name, double value) {
+			// value - value is NaN for infinite and NaN values
+			if(!(value - value == 0.0)) {
+				add(name, std::string(), true);
+				return *this;
+			}
+			std::ostringstream os;
+			os << std::setprecision(6) << value;
+			add(name, os.str(), true);
+			return *this;
+		}
+
+		//! Sets column \a name to integer \a value.
+		Row &setCount(const std::string &name, unsigned long long value) {
+			std::ostringstream os;
+			os << value;
+			add(name, os.str(), true);
+			return *this;
+		}
+	};
+
+private:
+	std::string      m_name;  //!< the name of the benchmark.
+	std::vector<Row> m_rows;  //!< the rows.
+
+	static void writeCSVField(std::ostream &os, const std::string &str) {
+		if(str.find_first_of(",\"\n") == std::string::npos) {
+			os << str;
+			return;
+		}
+		os << '"';
+		for(size_t i = 0; i < str.size(); ++i) {
+			if(str[i] == '"')
+				os << '"';
+			os << str[i];
+		}
+		os << '"';
+	}
+
+public:
+	//! Creates an empty report for benchmark \a name.
+	explicit BenchmarkReport(const std::string &name) : m_name(name) { }
+
+	//! Appends a new row and returns it.
+	Row &addRow() {
+		m_rows.push_back(Row());
+		return m_rows.back();
+	}
+
+	//! Returns the number of rows.
+	size_t numRows() const { return m_rows.size(); }
+
+	//! Writes the report as CSV (with header line) to \a os.
+	void writeCSV(std::ostream &os) const {
+		if(m_rows.empty())
+			return;
+
+		const Row &first = m_rows.front();
+		for(size_t j = 0; j < first.m_values.size(); ++j) {
+			if(j > 0) os << ',';
+			writeCSVField(os, first.m_values[j].m_name);
+		}
+		os << std::endl;
+
+		for(size_t i = 0; i < m_rows.size(); ++i) {
+			const Row &row = m_rows[i];
+			for(size_t j = 0; j < row.m_values.size(); ++j) {
+				if(j > 0) os << ',';
+				writeCSVField(os, row.m_values[j].m_text);
+			}
+			os << std::endl;
+		}
+	}
+
+	//! Writes the report as JSON object <tt>{"benchmark": name, "results": [...]}</tt> to \a os.
+	void writeJSON(std::ostream &os) const {
+		os << "{\"benchmark\":";
+		tbt::Utility::writeJSONString(os, m_name);
+		os << ",\"results\":[" << std::endl;
+
+		for(size_t i = 0; i < m_rows.size(); ++i) {
+			const Row &row = m_rows[i];
+			os << '{';
+			for(size_t j = 0; j < row.m_values.size(); ++j) {
+				if(j > 0) os << ',';
+				tbt::Utility::writeJSONString(os, row.m_values[j].m_name);
+				os << ':';
+				if(row.m_values[j].m_numeric)
+					os << (row.m_values[j].m_text.empty() ? "null" : row.m_values[j].m_text);
+				else
+					tbt::Utility::writeJSONString(os, row.m_values[j].m_text);
+			}
+			os << ((i+1 < m_rows.size()) ? "},\n" : "}\n");
+		}
+
+		os << "]}" << std::endl;
+	}
+
+	//! Writes the report as CSV to file \a fileName; returns false if the file cannot be written.
+	bool writeCSV(const std::string &fileName) const {
+		std::ofstream os(fileName.c_str());
+		if(!os)
+			return false;
+		writeCSV(os);
+		return true;
+	}
+
+	//! Writes the report as JSON to file \a fileName; returns false if the file cannot be written.
+	bool writeJSON(const std::string &fileName) const {
+		std::ofstream os(fileName.c_str());
+		if(!os)
+			return false;
+		writeJSON(os);
+		return true;
+	}
+
+	//! Writes the report to the files given by \a csvFile and \a jsonFile (if not empty); prints errors to std::cerr.
+	bool write(const std::string &csvFile, const std::string &jsonFile) const {
+		bool ok = true;
+		if(!csvFile.empty() && !writeCSV(csvFile)) {
+			std::cerr << "Cannot write file " << csvFile << std::endl;
+			ok = false;
+		}
+		if(!jsonFile.empty() && !writeJSON(jsonFile)) {
+			std::cerr << "Cannot write file " << jsonFile << std::endl;
+			ok = false;
+		}
+		return ok;
+	}
+};
+
+
+#endif
@@ -0,0 +1,279 @@
+
+#include <tbt/DeviceArray.h>
+#include <tbt/Global.h>
+#include <tbt/Timer.h>
+#include <tbt/Utility.h>
+
+#include <BenchmarkReport.h>
+
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+
+using namespace std;
+
+
+//! The kernels launched by the benchmark; they do (almost) nothing, so that only dispatch overhead is measured.
+static const char *launchBenchSource =
+	"__kernel void emptyKernel(__global uint *a, uint x)\n"
+	"{\n"
+	"}\n"
+	"\n"
+	"__kernel void touchKernel(__global uint *a, uint x)\n"
+	"{\n"
+	"	if(get_global_id(0) == 0)\n"
+	"		a[0] += x;\n"
+	"}\n";
+
+
+//! Options of the benchmark.
+struct Options {
+	int         m_batch;       //!< number of operations per timed batch.
+	int         m_repeat;      //!< number of timed batches.
+	size_t      m_globalWork;  //!< number of work-items per kernel launch.
+	std::string m_csvFile;     //!< CSV output file (empty = none).
+	std::string m_jsonFile;    //!< JSON output file (empty = none).
+};
+
+
+//! Runs \a batch (which performs \a ops operations) after one warm-up run and returns the times per operation in microseconds.
+/**
+ * \a untimed is called after each run of \a batch and is not included in the time.
+ */
+vector<double> measure(const Options &opt, int ops, const function<void()> &batch, const function<void()> &untimed = function<void()>())
+{
+	vector<double> times;
+
+	batch();
+	if(untimed) untimed();
+
+	for(int r = 0; r < opt.m_repeat; ++r) {
+		tbt::Timer timer;
+		batch();
+		times.push_back(1.e3 * timer.elapsed() / ops);
+
+		if(untimed) untimed();
+	}
+
+	return times;
+}
+
+
+//! Adds a result row to \a report and prints it.
+void addResult(BenchmarkReport &report, tbt::DeviceController *devCon, const string &test,
+	int ops, const vector<double> &times)
+{
+	BenchmarkStatistics stat(times);
+	const char *queue = devCon->isOutOfOrder() ? "out-of-order" : "in-order";
+
+	report.addRow()
+		.set     ("device",       devCon->getName())
+		.set     ("queue",        queue)
+		.set     ("test",         test)
+		.setCount("ops",          ops)
+		.setValue("min_us",       stat.m_min)
+		.setValue("median_us",    stat.m_median)
+		.setValue("mean_us",      stat.m_mean)
+		.setValue("ops_per_sec",  1.e6 / stat.m_median);
+
+	cout << left  << setw(28) << devCon->getName().substr(0,27)
+	     << setw(14) << queue
+	     << setw(36) << test
+	     << right << setw(8) << ops
+	     << fixed << setprecision(3)
+	     << setw(14) << stat.m_median
+	     << setprecision(0)
+	     << setw(14) << 1.e6 / stat.m_median << endl;
+}
+
+
+//! Runs all measurements on \a devCon.
+void benchmarkDevice(BenchmarkReport &report, tbt::DeviceController *devCon, const cl::Program &program, const Options &opt)
+{
+	const int n = opt.m_batch;
+
+	cl::Kernel kernel(program, "emptyKernel");
+	tbt::DeviceArray<cl_uint> a(devCon, 1);
+	kernel.setArg<cl::Buffer>(0, a);
+	kernel.setArg<cl_uint>(1, 1);
+
+	// cost of setting kernel arguments
+	addResult(report, devCon, "setArg uint", n, measure(opt, n, [&]() {
+		for(int i = 0; i < n; ++i)
+			kernel.setArg<cl_uint>(1, (cl_uint)i);
+	}));
+	addResult(report, devCon, "setArg buffer", n, measure(opt, n, [&]() {
+		for(int i = 0; i < n; ++i)
+			kernel.setArg<cl::Buffer>(0, a);
+	}));
+
+	// latency of a single launch (enqueue and wait for completion)
+	addResult(report, devCon, "launch + finish", n / 10, measure(opt, n / 10, [&]() {
+		for(int i = 0; i < n / 10; ++i) {
+			devCon->enqueue1DRangeKernel(kernel, opt.m_globalWork);
+			devCon->finish(tbt::qiCompute);
+		}
+	}));
+
+	// host-side cost of enqueueing, without and with an event object
+	auto finish = [&]() { devCon->finish(tbt::qiCompute); };
+
+	addResult(report, devCon, "enqueue (no event)", n, measure(opt, n, [&]() {
+		for(int i = 0; i < n; ++i)
+			devCon->enqueue1DRangeKernel(kernel, opt.m_globalWork);
+	}, finish));
+	addResult(report, devCon, "enqueue (event)", n, measure(opt, n, [&]() {
+		cl::Event ev;
+		for(int i = 0; i < n; ++i)
+			devCon->enqueue1DRangeKernel(kernel, opt.m_globalWork, 0, 0, &ev);
+	}, finish));
+
+	// waiting for each launch through its event instead of finishing the queue
+	addResult(report, devCon, "launch + event wait", n / 10, measure(opt, n / 10, [&]() {
+		cl::Event ev;
+		for(int i = 0; i < n / 10; ++i) {
+			devCon->enqueue1DRangeKernel(kernel, opt.m_globalWork, 0, 0, &ev);
+			ev.wait();
+		}
+	}));
+
+	// throughput of a batch, submitted once at the end (finish) or after every launch (flush)
+	addResult(report, devCon, "batch, finish at end", n, measure(opt, n, [&]() {
+		for(int i = 0; i < n; ++i)
+			devCon->enqueue1DRangeKernel(kernel, opt.m_globalWork);
+		devCon->finish(tbt::qiCompute);
+	}));
+	addResult(report, devCon, "batch, flush every launch", n, measure(opt, n, [&]() {
+		for(int i = 0; i < n; ++i) {
+			devCon->enqueue1DRangeKernel(kernel, opt.m_globalWork);
+			devCon->flush(tbt::qiCompute);
+		}
+		devCon->finish(tbt::qiCompute);
+	}));
+
+	// throughput of launches depending on their predecessor through events (as required on out-of-order queues)
+	cl::Kernel touch(program, "touchKernel");
+	touch.setArg<cl::Buffer>(0, a);
+	touch.setArg<cl_uint>(1, 1);
+
+	addResult(report, devCon, "batch, dependent launches", n, measure(opt, n, [&]() {
+		cl::vector<cl::Event> events(1);
+		devCon->enqueue1DRangeKernel(touch, opt.m_globalWork, 0, 0, &events[0]);
+		for(int i = 1; i < n; ++i)
+			devCon->enqueue1DRangeKernel(touch, opt.m_globalWork, 0, &events, &events[0]);
+		devCon->finish(tbt::qiCompute);
+	}));
+}
+
+
+int main(int argc, char *argv[])
+{
+	cl_device_type deviceType = CL_DEVICE_TYPE_CPU;
+
+	Options opt;
+	opt.m_batch      = 10000;
+	opt.m_repeat     = 5;
+	opt.m_globalWork = 64;
+
+	// parse command line arguments
+	for(int i = 1; i < argc; ++i) {
+		string cmd = argv[i];
+
+		if(cmd == "-h" || cmd == "--help") {
+			cout << "Call with: launch-bench options-list" << endl;
+			cout << "\navailable options:" << endl;
+			cout << "\n-d, --device {CPU,GPU,CPU+GPU}\n  specifies the devices used: all CPU devices, all GPU devices, or both (requires a platform with CPUs and GPUs)" << endl;
+			cout << "\n-n, --batch #operations\n  number of operations per timed batch (default 10000)" << endl;
+			cout << "\n-r, --repeat #batches\n  number of timed batches (default 5)" << endl;
+			cout << "\n-g, --global #work-items\n  number of work-items per kernel launch (default 64)" << endl;
+			cout << "\n--csv file\n  write results as CSV to file" << endl;
+			cout << "\n--json file\n  write results as JSON to file" << endl;
+			cout << "\n-h, --help\n  display this help and exit" << endl;
+			return 0;
+		}
+
+		if(++i >= argc) {
+			cerr << "Missing argument for option " << cmd << endl;
+			return 1;
+		}
+		string arg = argv[i];
+
+		if(cmd == "-d" || cmd == "--device") {
+			if(arg == "CPU" || arg == "cpu")
+				deviceType = CL_DEVICE_TYPE_CPU;
+			else if(arg == "GPU" || arg == "gpu")
+				deviceType = CL_DEVICE_TYPE_GPU;
+			else if(arg == "CPU+GPU" || arg == "cpu+gpu")
+				deviceType = CL_DEVICE_TYPE_CPU | CL_DEVICE_TYPE_GPU;
+			else {
+				cerr << "Unknown device type " << arg << endl;
+				return 1;
+			}
+
+		} else if(cmd == "-n" || cmd == "--batch") {
+			opt.m_batch = max(10, atoi(arg.c_str()));
+
+		} else if(cmd == "-r" || cmd == "--repeat") {
+			opt.m_repeat = max(1, atoi(arg.c_str()));
+
+		} else if(cmd == "-g" || cmd == "--global") {
+			opt.m_globalWork = (size_t)max(1, atoi(arg.c_str()));
+
+		} else if(cmd == "--csv") {
+			opt.m_csvFile = arg;
+
+		} else if(cmd == "--json") {
+			opt.m_jsonFile = arg;
+
+		} else {
+			cerr << "Unknown option: " << cmd << endl;
+			return 1;
+		}
+	}
+
+	BenchmarkReport report("launch");
+
+	try {
+		tbt::createContext(deviceType);
+
+		tbt::Utility::registerProgramSource("launch-bench.cl", launchBenchSource, strlen(launchBenchSource));
+
+		cout << left  << setw(28) << "device"
+		     << setw(14) << "queue"
+		     << setw(36) << "test"
+		     << right << setw(8) << "ops"
+		     << setw(14) << "median [us]"
+		     << setw(14) << "ops/s" << endl;
+
+		for(int d = 0; d < tbt::numDeviceControllers(); ++d) {
+			tbt::DeviceController *devCon = tbt::getDeviceController(d);
+
+			// kernels can only be launched on the device the program has been built for
+			cl::Program program = tbt::Utility::buildProgram(devCon, "launch-bench.cl");
+			benchmarkDevice(report, devCon, program, opt);
+
+			// the same measurements with out-of-order command queues (if supported by the device)
+			cl_command_queue_properties props = devCon->getDevice().getInfo<CL_DEVICE_QUEUE_PROPERTIES>();
+			if(props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) {
+				tbt::DeviceController devConOoo(devCon->getDevice(), devCon->getContext(), CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE);
+				benchmarkDevice(report, &devConOoo, program, opt);
+			}
+		}
+
+	} catch(cl::Error err) {
+		cerr << "ERROR: " << err.what() << "(" << err.err() << ")" << endl;
+		report.write(opt.m_csvFile, opt.m_jsonFile);
+		return 1;
+
+	} catch(tbt::Error err) {
+		cerr << "ERROR: " << err.what() << endl;
+		report.write(opt.m_csvFile, opt.m_jsonFile);
+		return 1;
+	}
+
+	return report.write(opt.m_csvFile, opt.m_jsonFile) ? 0 : 1;
+}
@@ -0,0 +1,395 @@
+
+#include <tbt/RadixSort.h>
+#include <tbt/HostRadixSort.h>
+#include <tbt/Global.h>
+#include <tbt/Timer.h>
+
+#include <BenchmarkReport.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace std;
+
+
+//! Key distributions used by the benchmark.
+enum Distribution {
+	kdUniform,     //!< uniformly distributed 32-bit keys.
+	kdZipf,        //!< Zipf-distributed keys (exponent 1) over 2^16 distinct values.
+	kdSorted,      //!< uniform keys in ascending order.
+	kdReverse,     //!< uniform keys in descending order.
+	kdFewUnique,   //!< uniform choice among 16 distinct values.
+	kdLowEntropy,  //!< bitwise AND of four uniform keys (each bit is set with probability 1/16).
+	kdNumDistributions
+};
+
+static const char *distributionNames[kdNumDistributions] = {
+	"uniform", "zipf", "sorted", "reverse", "few-unique", "low-entropy"
+};
+
+
+//! Fills \a keys with \a n keys of distribution \a dist.
+void generateKeys(vector<cl_uint> &keys, size_t n, Distribution dist, unsigned int seed)
+{
+	mt19937 rng(seed);
+	keys.resize(n);
+
+	switch(dist)
+	{
+	case kdUniform:
+	case kdSorted:
+	case kdReverse:
+		for(size_t i = 0; i < n; ++i)
+			keys[i] = rng();
+		if(dist == kdSorted)
+			sort(keys.begin(), keys.end());
+		else if(dist == kdReverse)
+			sort(keys.begin(), keys.end(), greater<cl_uint>());
+		break;
+
+	case kdZipf:
+		{
+			// inverse transform sampling; ranks are scattered over the key space by a multiplicative hash
+			const size_t numValues = 1 << 16;
+			vector<double> cdf(numValues);
+			double sum = 0.0;
+			for(size_t r = 0; r < numValues; ++r)
+				cdf[r] = (sum += 1.0 / (r+1));
+
+			uniform_real_distribution<double> u(0.0, sum);
+			for(size_t i = 0; i < n; ++i) {
+				cl_uint rank = (cl_uint)(lower_bound(cdf.begin(), cdf.end(), u(rng)) - cdf.begin());
+				keys[i] = (min(rank, (cl_uint)numValues-1) + 1) * 2654435761u;
+			}
+		}
+		break;
+
+	case kdFewUnique:
+		{
+			cl_uint values[16];
+			for(int j = 0; j < 16; ++j)
+				values[j] = rng();
+			for(size_t i = 0; i < n; ++i)
+				keys[i] = values[rng() & 15];
+		}
+		break;
+
+	case kdLowEntropy:
+		for(size_t i = 0; i < n; ++i)
+			keys[i] = rng() & rng() & rng() & rng();
+		break;
+
+	default:
+		break;
+	}
+}
+
+
+//! Sorts [\a first, \a last) with \a numThreads threads (sorts blocks, then merges pairs of blocks in parallel).
+void parallelSort(cl_uint *first, cl_uint *last, unsigned int numThreads)
+{
+	size_t n = last - first;
+	if(numThreads <= 1 || n < 65536) {
+		sort(first, last);
+		return;
+	}
+
+	vector<size_t> bounds(numThreads+1);
+	for(unsigned int t = 0; t <= numThreads; ++t)
+		bounds[t] = n * t / numThreads;
+
+	vector<thread> threads;
+	for(unsigned int t = 0; t < numThreads; ++t)
+		threads.push_back(thread([=]() { sort(first + bounds[t], first + bounds[t+1]); }));
+	for(size_t t = 0; t < threads.size(); ++t)
+		threads[t].join();
+
+	for(size_t width = 1; width < numThreads; width *= 2) {
+		threads.clear();
+		for(size_t t = 0; t + width < numThreads; t += 2*width) {
+			cl_uint *a = first + bounds[t];
+			cl_uint *m = first + bounds[t+width];
+			cl_uint *b = first + bounds[min(t+2*width, (size_t)numThreads)];
+			threads.push_back(thread([=]() { inplace_merge(a, m, b); }));
+		}
+		for(size_t t = 0; t < threads.size(); ++t)
+			threads[t].join();
+	}
+}
+
+
+//! Options of the benchmark.
+struct Options {
+	int          m_minLog;      //!< smallest array size (log2).
+	int          m_maxLog;      //!< largest array size (log2).
+	int          m_stepLog;     //!< step of array size (log2).
+	int          m_repeat;      //!< number of timed repetitions.
+	unsigned int m_numThreads;  //!< number of threads for the parallel host sorts.
+	bool         m_hostSorts;   //!< run std::sort and the parallel host sorts?
+	std::string  m_csvFile;     //!< CSV output file (empty = none).
+	std::string  m_jsonFile;    //!< JSON output file (empty = none).
+	std::vector<bool> m_distributions;  //!< selected distributions.
+};
+
+
+//! Adds a result row to \a report and prints it.
+void addResult(BenchmarkReport &report, const string &device, const string &method, Distribution dist,
+	size_t n, const BenchmarkStatistics &stat, double deviceTime, bool correct)
+{
+	// effective bandwidth counts one read and one write of each key
+	double keysPerSec = n / (1.e-3 * stat.m_median);
+	double gbPerSec   = 2.0 * n * sizeof(cl_uint) / (1.e6 * stat.m_median);
+
+	report.addRow()
+		.set     ("device",        device)
+		.set     ("method",        method)
+		.set     ("distribution",  distributionNames[dist])
+		.set     ("key_type",      "uint32")
+		.setCount("n",             n)
+		.setValue("min_ms",        stat.m_min)
+		.setValue("median_ms",     stat.m_median)
+		.setValue("mean_ms",       stat.m_mean)
+		.setValue("device_ms",     deviceTime)
+		.setValue("keys_per_sec",  keysPerSec)
+		.setValue("gb_per_sec",    gbPerSec)
+		.set     ("correct",       correct ? "true" : "false");
+
+	cout << left  << setw(28) << device.substr(0,27)
+	     << setw(20) << method
+	     << setw(13) << distributionNames[dist]
+	     << right << setw(11) << n
+	     << fixed << setprecision(3)
+	     << setw(12) << stat.m_median
+	     << setw(12) << deviceTime
+	     << setw(10) << 1.e-6 * keysPerSec
+	     << setw(9)  << gbPerSec
+	     << (correct ? "" : "  INCORRECT") << endl;
+}
+
+
+//! Benchmarks RadixSort on \a devCon for keys \a keys; \a reference are the sorted keys.
+void benchmarkDevice(BenchmarkReport &report, tbt::DeviceController *devCon, const Options &opt,
+	Distribution dist, const vector<cl_uint> &keys, const vector<cl_uint> &reference)
+{
+	size_t n = keys.size();
+	tbt::DeviceArray<cl_uint> a(devCon, n);
+	tbt::RadixSort radixSort;
+
+	vector<double> hostTimes, deviceTimes;
+	for(int r = -1; r < opt.m_repeat; ++r) {
+		// the upload is not timed; the first run is a warm-up (builds and caches the program)
+		a.loadBlocking(&keys[0]);
+		radixSort.run(a);
+
+		if(r >= 0) {
+			hostTimes  .push_back(radixSort.hostTime());
+			deviceTimes.push_back(radixSort.totalTime());
+		}
+	}
+
+	vector<cl_uint> result(n);
+	a.storeBlocking(&result[0]);
+
+	addResult(report, devCon->getName(), "tbt::RadixSort", dist, n,
+		BenchmarkStatistics(hostTimes), BenchmarkStatistics(deviceTimes).m_median, result == reference);
+}
+
+
+//! Benchmarks \a method (0 = std::sort, 1 = parallel host sort, 2 = tbt::HostRadixSort) for keys \a keys.
+void benchmarkHost(BenchmarkReport &report, int method, const Options &opt,
+	Distribution dist, const vector<cl_uint> &keys, const vector<cl_uint> &reference)
+{
+	static const char *methodNames[] = { "std::sort", "parallel-sort", "tbt::HostRadixSort" };
+
+	tbt::ThreadPool pool(opt.m_numThreads);
+	tbt::HostRadixSort hostRadixSort(&pool);
+
+	vector<cl_uint> a;
+	vector<double> times;
+
+	for(int r = 0; r < opt.m_repeat; ++r) {
+		a = keys;
+
+		tbt::Timer timer;
+		if(method == 0)
+			sort(a.begin(), a.end());
+		else if(method == 1)
+			parallelSort(&a[0], &a[0] + a.size(), opt.m_numThreads);
+		else
+			hostRadixSort.run(&a[0], a.size());
+		times.push_back(timer.elapsed());
+	}
+
+	addResult(report, "host", methodNames[method], dist, keys.size(),
+		BenchmarkStatistics(times), 0.0, a == reference);
+}
+
+
+int main(int argc, char *argv[])
+{
+	cl_device_type deviceType = CL_DEVICE_TYPE_CPU;
+
+	Options opt;
+	opt.m_minLog     = 10;
+	opt.m_maxLog     = 28;
+	opt.m_stepLog    = 2;
+	opt.m_repeat     = 5;
+	opt.m_numThreads = max(1u, thread::hardware_concurrency());
+	opt.m_hostSorts  = true;
+	opt.m_distributions.assign(kdNumDistributions, true);
+
+	// parse command line arguments
+	for(int i = 1; i < argc; ++i) {
+		string cmd = argv[i];
+
+		if(cmd == "-h" || cmd == "--help") {
+			cout << "Call with: radix-sort-bench options-list" << endl;
+			cout << "\navailable options:" << endl;
+			cout << "\n-d, --device {CPU,GPU,CPU+GPU}\n  specifies the device(s) used: CPU, GPU, or both (requires a platform with CPUs and GPUs)" << endl;
+			cout << "\n--min-log k\n  smallest array size is 2^k (default 10, at least 10)" << endl;
+			cout << "\n--max-log k\n  largest array size is 2^k (default 28, at most 28)" << endl;
+			cout << "\n--step-log k\n  array sizes grow by factor 2^k (default 2)" << endl;
+			cout << "\n--dist name[,name...]\n  key distributions: uniform, zipf, sorted, reverse, few-unique, low-entropy (default all)" << endl;
+			cout << "\n-r, --repeat #runs\n  number of timed runs per configuration (default 5)" << endl;
+			cout << "\n-t, --threads #threads\n  number of threads used by the parallel host sorts (default: number of cores)" << endl;
+			cout << "\n--no-host\n  do not run std::sort and the parallel host sorts" << endl;
+			cout << "\n--csv file\n  write results as CSV to file" << endl;
+			cout << "\n--json file\n  write results as JSON to file" << endl;
+			cout << "\n-h, --help\n  display this help and exit" << endl;
+			return 0;
+
+		} else if(cmd == "--no-host") {
+			opt.m_hostSorts = false;
+
+		} else {
+			if(++i >= argc) {
+				cerr << "Missing argument for option " << cmd << endl;
+				return 1;
+			}
+			string arg = argv[i];
+
+			if(cmd == "-d" || cmd == "--device") {
+				if(arg == "CPU" || arg == "cpu")
+					deviceType = CL_DEVICE_TYPE_CPU;
+				else if(arg == "GPU" || arg == "gpu")
+					deviceType = CL_DEVICE_TYPE_GPU;
+				else if(arg == "CPU+GPU" || arg == "cpu+gpu")
+					deviceType = CL_DEVICE_TYPE_CPU | CL_DEVICE_TYPE_GPU;
+				else {
+					cerr << "Unknown device type " << arg << endl;
+					return 1;
+				}
+
+			} else if(cmd == "--min-log") {
+				opt.m_minLog = max(10, atoi(arg.c_str()));
+
+			} else if(cmd == "--max-log") {
+				opt.m_maxLog = min(28, atoi(arg.c_str()));
+
+			} else if(cmd == "--step-log") {
+				opt.m_stepLog = max(1, atoi(arg.c_str()));
+
+			} else if(cmd == "-r" || cmd == "--repeat") {
+				opt.m_repeat = max(1, atoi(arg.c_str()));
+
+			} else if(cmd == "-t" || cmd == "--threads") {
+				opt.m_numThreads = (unsigned int)max(1, atoi(arg.c_str()));
+
+			} else if(cmd == "--dist") {
+				opt.m_distributions.assign(kdNumDistributions, false);
+				size_t pos = 0;
+				while(pos <= arg.size()) {
+					size_t end = arg.find(',', pos);
+					if(end == string::npos) end = arg.size();
+					string name = arg.substr(pos, end-pos);
+
+					int d = 0;
+					while(d < kdNumDistributions && name != distributionNames[d])
+						++d;
+					if(d == kdNumDistributions) {
+						cerr << "Unknown distribution " << name << endl;
+						return 1;
+					}
+					opt.m_distributions[d] = true;
+					pos = end+1;
+				}
+
+			} else if(cmd == "--csv") {
+				opt.m_csvFile = arg;
+
+			} else if(cmd == "--json") {
+				opt.m_jsonFile = arg;
+
+			} else {
+				cerr << "Unknown option: " << cmd << endl;
+				return 1;
+			}
+		}
+	}
+
+	BenchmarkReport report("radix-sort");
+
+	try {
+		// the number of prescan groups is chosen from the device characteristics
+		tbt::globalConfig.setCharacterizeDevices(true);
+		tbt::createContext(deviceType, CL_QUEUE_PROFILING_ENABLE);
+
+		vector<tbt::DeviceController*> devCons;
+		if(deviceType & CL_DEVICE_TYPE_CPU && tbt::getCPUDeviceController() != 0)
+			devCons.push_back(tbt::getCPUDeviceController());
+		if(deviceType & CL_DEVICE_TYPE_GPU && tbt::getGPUDeviceController() != 0)
+			devCons.push_back(tbt::getGPUDeviceController());
+
+		cout << left  << setw(28) << "device"
+		     << setw(20) << "method"
+		     << setw(13) << "distribution"
+		     << right << setw(11) << "n"
+		     << setw(12) << "median [ms]"
+		     << setw(12) << "device [ms]"
+		     << setw(10) << "Mkeys/s"
+		     << setw(9)  << "GB/s" << endl;
+
+		vector<cl_uint> keys, reference;
+		for(int k = opt.m_minLog; k <= opt.m_maxLog; k += opt.m_stepLog) {
+			size_t n = (size_t)1 << k;
+
+			for(int d = 0; d < kdNumDistributions; ++d) {
+				if(!opt.m_distributions[d])
+					continue;
+				Distribution dist = (Distribution)d;
+
+				generateKeys(keys, n, dist, 4711 + k);
+				reference = keys;
+				sort(reference.begin(), reference.end());
+
+				for(size_t i = 0; i < devCons.size(); ++i)
+					benchmarkDevice(report, devCons[i], opt, dist, keys, reference);
+
+				if(opt.m_hostSorts) {
+					benchmarkHost(report, 0, opt, dist, keys, reference);
+					benchmarkHost(report, 1, opt, dist, keys, reference);
+					benchmarkHost(report, 2, opt, dist, keys, reference);
+				}
+			}
+		}
+
+	} catch(cl::Error err) {
+		cerr << "ERROR: " << err.what() << "(" << err.err() << ")" << endl;
+		report.write(opt.m_csvFile, opt.m_jsonFile);
+		return 1;
+
+	} catch(tbt::Error err) {
+		cerr << "ERROR: " << err.what() << endl;
+		report.write(opt.m_csvFile, opt.m_jsonFile);
+		return 1;
+	}
+
+	return report.write(opt.m_csvFile, opt.m_jsonFile) ? 0 : 1;
+}
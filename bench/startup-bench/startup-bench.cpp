@@ -0,0 +1,237 @@
+
+#include <tbt/Global.h>
+#include <tbt/Timer.h>
+#include <tbt/Utility.h>
+
+#include <BenchmarkReport.h>
+
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+
+using namespace std;
+
+
+//! Options of the benchmark.
+struct Options {
+	int                      m_repeat;    //!< number of timed repetitions per phase.
+	std::string              m_cacheDir;  //!< directory for the on-disk program cache.
+	std::vector<std::string> m_programs;  //!< the programs to build.
+	std::string              m_csvFile;   //!< CSV output file (empty = none).
+	std::string              m_jsonFile;  //!< JSON output file (empty = none).
+};
+
+
+//! Runs \a phase opt.m_repeat times and returns the times in ms.
+vector<double> measure(const Options &opt, const function<void()> &phase)
+{
+	vector<double> times;
+	for(int r = 0; r < opt.m_repeat; ++r) {
+		tbt::Timer timer;
+		phase();
+		times.push_back(timer.elapsed());
+	}
+	return times;
+}
+
+
+//! Characterizes opt.m_repeat new device controllers for the device of \a devCon and returns the times in ms.
+vector<double> measureCharacterize(const Options &opt, tbt::DeviceController *devCon)
+{
+	vector<double> times;
+	for(int r = 0; r < opt.m_repeat; ++r) {
+		// characterize() has an effect only once per device controller
+		tbt::DeviceController devConTmp(devCon->getDevice(), devCon->getContext());
+
+		tbt::Timer timer;
+		devConTmp.characterize();
+		times.push_back(timer.elapsed());
+	}
+	return times;
+}
+
+
+//! Adds a result row to \a report and prints it.
+void addResult(BenchmarkReport &report, const string &device, const string &phase, const string &program,
+	const vector<double> &times)
+{
+	BenchmarkStatistics stat(times);
+
+	report.addRow()
+		.set     ("device",     device)
+		.set     ("phase",      phase)
+		.set     ("program",    program)
+		.setCount("runs",       times.size())
+		.setValue("min_ms",     stat.m_min)
+		.setValue("median_ms",  stat.m_median)
+		.setValue("mean_ms",    stat.m_mean);
+
+	cout << left  << setw(28) << device.substr(0,27)
+	     << setw(24) << phase
+	     << setw(16) << program
+	     << right << setw(6) << times.size()
+	     << fixed << setprecision(3)
+	     << setw(12) << stat.m_min
+	     << setw(12) << stat.m_median << endl;
+}
+
+
+int main(int argc, char *argv[])
+{
+	cl_device_type deviceType = CL_DEVICE_TYPE_CPU;
+
+	Options opt;
+	opt.m_repeat = 5;
+
+	// parse command line arguments
+	for(int i = 1; i < argc; ++i) {
+		string cmd = argv[i];
+
+		if(cmd == "-h" || cmd == "--help") {
+			cout << "Call with: startup-bench options-list" << endl;
+			cout << "\nMeasures the phases of starting an application: creating the context (once per process)," << endl;
+			cout << "constructing device controllers, characterizing devices by measuring and from the on-disk cache," << endl;
+			cout << "and building programs from source, from the on-disk binary cache, and from an in-memory registered" << endl;
+			cout << "binary. Note that some OpenCL drivers maintain a cache of their own, which may also speed up builds" << endl;
+			cout << "from source." << endl;
+			cout << "\navailable options:" << endl;
+			cout << "\n-d, --device {CPU,GPU}\n  specifies the device used: CPU or GPU" << endl;
+			cout << "\n-p, --program file\n  builds program file (can be given several times; default radix.cl and fill.cl)" << endl;
+			cout << "\n-r, --repeat #runs\n  number of timed runs per phase (default 5)" << endl;
+			cout << "\n--cache-dir dir\n  directory for the on-disk program cache (default \"startup-bench-cache\" beside the executable)" << endl;
+			cout << "\n--csv file\n  write results as CSV to file" << endl;
+			cout << "\n--json file\n  write results as JSON to file" << endl;
+			cout << "\n-h, --help\n  display this help and exit" << endl;
+			return 0;
+		}
+
+		if(++i >= argc) {
+			cerr << "Missing argument for option " << cmd << endl;
+			return 1;
+		}
+		string arg = argv[i];
+
+		if(cmd == "-d" || cmd == "--device") {
+			if(arg == "CPU" || arg == "cpu")
+				deviceType = CL_DEVICE_TYPE_CPU;
+			else if(arg == "GPU" || arg == "gpu")
+				deviceType = CL_DEVICE_TYPE_GPU;
+			else {
+				cerr << "Unknown device type " << arg << endl;
+				return 1;
+			}
+
+		} else if(cmd == "-p" || cmd == "--program") {
+			opt.m_programs.push_back(arg);
+
+		} else if(cmd == "-r" || cmd == "--repeat") {
+			opt.m_repeat = max(1, atoi(arg.c_str()));
+
+		} else if(cmd == "--cache-dir") {
+			opt.m_cacheDir = arg;
+
+		} else if(cmd == "--csv") {
+			opt.m_csvFile = arg;
+
+		} else if(cmd == "--json") {
+			opt.m_jsonFile = arg;
+
+		} else {
+			cerr << "Unknown option: " << cmd << endl;
+			return 1;
+		}
+	}
+
+	if(opt.m_programs.empty()) {
+		opt.m_programs.push_back("radix.cl");
+		opt.m_programs.push_back("fill.cl");
+	}
+	if(opt.m_cacheDir.empty())
+		opt.m_cacheDir = tbt::Utility::getExePath() + "startup-bench-cache";
+
+	BenchmarkReport report("startup");
+
+	try {
+		cout << left  << setw(28) << "device"
+		     << setw(24) << "phase"
+		     << setw(16) << "program"
+		     << right << setw(6) << "runs"
+		     << setw(12) << "min [ms]"
+		     << setw(12) << "median [ms]" << endl;
+
+		// creating the context can only be measured once per process (it includes loading the OpenCL runtime);
+		// devices are characterized in a phase of their own
+		tbt::globalConfig.setProgramCacheDir(opt.m_cacheDir);
+		tbt::globalConfig.setCharacterizeDevices(false);
+
+		tbt::Timer timer;
+		tbt::createContext(deviceType);
+		vector<double> contextTime(1, timer.elapsed());
+
+		tbt::DeviceController *devCon = tbt::getDeviceController();
+		string device = devCon->getName();
+
+		addResult(report, device, "createContext", "", contextTime);
+
+		// constructing further device controllers (creates command queues and queries device properties)
+		addResult(report, device, "DeviceController", "", measure(opt, [&]() {
+			tbt::DeviceController devConTmp(devCon->getDevice(), devCon->getContext());
+		}));
+
+		// characterizing a device runs micro-benchmarks unless the results are cached; the first uncontended
+		// measurement with caching enabled writes the cache (not timed)
+		tbt::globalConfig.setCacheProgramBinaries(false);
+		addResult(report, device, "characterize", "", measureCharacterize(opt, devCon));
+
+		tbt::globalConfig.setCacheProgramBinaries(true);
+		tbt::DeviceController(devCon->getDevice(), devCon->getContext()).characterize();
+		addResult(report, device, "characterize from cache", "", measureCharacterize(opt, devCon));
+
+		// the phases must be run in this order, since registered binaries take precedence over the other sources
+		for(size_t p = 0; p < opt.m_programs.size(); ++p) {
+			const char *progName = opt.m_programs[p].c_str();
+
+			tbt::globalConfig.setCacheProgramBinaries(false);
+			addResult(report, device, "build from source", progName, measure(opt, [&]() {
+				tbt::Utility::buildProgram(progName);
+			}));
+
+			// the first build writes the cache (if not yet present) and is not timed
+			tbt::globalConfig.setCacheProgramBinaries(true);
+			tbt::Utility::buildProgram(progName);
+
+			addResult(report, device, "build from disk cache", progName, measure(opt, [&]() {
+				tbt::Utility::buildProgram(progName);
+			}));
+		}
+
+		// binaries registered in memory require neither disk access nor compilation
+		vector<string> binaries(opt.m_programs.size());
+		for(size_t p = 0; p < opt.m_programs.size(); ++p) {
+			const char *progName = opt.m_programs[p].c_str();
+
+			binaries[p] = tbt::Utility::getProgramBinary(tbt::Utility::buildProgram(progName));
+			tbt::Utility::registerProgramBinary(progName, device.c_str(), devCon->getDriverVersion().c_str(), 0,
+				(const unsigned char *)binaries[p].data(), binaries[p].size());
+
+			addResult(report, device, "build from memory", progName, measure(opt, [&]() {
+				tbt::Utility::buildProgram(progName);
+			}));
+		}
+
+	} catch(cl::Error err) {
+		cerr << "ERROR: " << err.what() << "(" << err.err() << ")" << endl;
+		report.write(opt.m_csvFile, opt.m_jsonFile);
+		return 1;
+
+	} catch(tbt::Error err) {
+		cerr << "ERROR: " << err.what() << endl;
+		report.write(opt.m_csvFile, opt.m_jsonFile);
+		return 1;
+	}
+
+	return report.write(opt.m_csvFile, opt.m_jsonFile) ? 0 : 1;
+}
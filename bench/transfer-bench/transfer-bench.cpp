@@ -0,0 +1,281 @@
+
+#include <tbt/DeviceArray.h>
+#include <tbt/DeviceStruct.h>
+#include <tbt/MappedArray.h>
+#include <tbt/HostArray.h>
+#include <tbt/Global.h>
+#include <tbt/Timer.h>
+
+#include <BenchmarkReport.h>
+
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+
+using namespace std;
+
+
+//! Options of the benchmark.
+struct Options {
+	int         m_minLog;     //!< smallest transfer size in bytes (log2).
+	int         m_maxLog;     //!< largest transfer size in bytes (log2).
+	int         m_stepLog;    //!< step of transfer size (log2).
+	int         m_minRepeat;  //!< minimal number of timed repetitions.
+	double      m_minTime;    //!< minimal total time of the timed repetitions (in ms).
+	std::string m_csvFile;    //!< CSV output file (empty = none).
+	std::string m_jsonFile;   //!< JSON output file (empty = none).
+};
+
+
+//! Runs \a transfer repeatedly (after one warm-up run) and returns the times of the runs in ms.
+/**
+ * The transfer is repeated at least opt.m_minRepeat times and until opt.m_minTime ms have passed
+ * (at most 10000 times). \a prepare is called before each run and is not timed.
+ */
+vector<double> measure(const Options &opt, const function<void()> &prepare, const function<void()> &transfer)
+{
+	vector<double> times;
+	double total = 0.0;
+
+	prepare();
+	transfer();
+
+	while((int)times.size() < opt.m_minRepeat || (total < opt.m_minTime && times.size() < 10000)) {
+		prepare();
+
+		tbt::Timer timer;
+		transfer();
+		double t = timer.elapsed();
+
+		times.push_back(t);
+		total += t;
+	}
+
+	return times;
+}
+
+
+//! Adds a result row to \a report and prints it.
+void addResult(BenchmarkReport &report, tbt::DeviceController *devCon, const string &path,
+	size_t bytes, const vector<double> &times)
+{
+	BenchmarkStatistics stat(times);
+	double gbPerSec = bytes / (1.e6 * stat.m_median);
+
+	report.addRow()
+		.set     ("device",      devCon->getName())
+		.set     ("path",        path)
+		.setCount("bytes",       bytes)
+		.setCount("runs",        times.size())
+		.setValue("min_ms",      stat.m_min)
+		.setValue("median_ms",   stat.m_median)
+		.setValue("mean_ms",     stat.m_mean)
+		.setValue("latency_us",  1.e3 * stat.m_median)
+		.setValue("gb_per_sec",  gbPerSec);
+
+	cout << left  << setw(28) << devCon->getName().substr(0,27)
+	     << setw(24) << path
+	     << right << setw(11) << bytes
+	     << setw(8)  << times.size()
+	     << fixed << setprecision(2)
+	     << setw(14) << 1.e3 * stat.m_median
+	     << setprecision(3)
+	     << setw(10) << gbPerSec << endl;
+}
+
+
+//! Measures all bulk transfer paths for \a bytes bytes on \a devCon.
+void benchmarkBulk(BenchmarkReport &report, tbt::DeviceController *devCon, const Options &opt, size_t bytes)
+{
+	size_t n = bytes / sizeof(cl_uint);
+	auto nothing = []() { };
+
+	tbt::DeviceArray<cl_uint> a(devCon, n);
+
+	// DeviceArray from / to host arrays with cache-aligned and page-aligned memory
+	{
+		tbt::HostArray<cl_uint> h(n);
+		h.fill(1);
+		addResult(report, devCon, "load host-array", bytes, measure(opt, nothing, [&]() { a.loadBlocking(h); }));
+		addResult(report, devCon, "store host-array", bytes, measure(opt, nothing, [&]() { a.storeBlocking(h); }));
+	}
+	{
+		tbt::HostArray<cl_uint> h(n, tbt::HostAllocPolicy(tbt::hmPageAligned));
+		h.fill(1);
+		addResult(report, devCon, "load page-aligned", bytes, measure(opt, nothing, [&]() { a.loadBlocking(h); }));
+		addResult(report, devCon, "store page-aligned", bytes, measure(opt, nothing, [&]() { a.storeBlocking(h); }));
+	}
+
+	// DeviceArray from / to ordinary heap memory
+	{
+		vector<cl_uint> v(n, 1);
+		addResult(report, devCon, "load heap", bytes, measure(opt, nothing, [&]() { a.loadBlocking(&v[0]); }));
+		addResult(report, devCon, "store heap", bytes, measure(opt, nothing, [&]() { a.storeBlocking(&v[0]); }));
+	}
+
+	// DeviceArray from / to a mapped array (pinned staging memory)
+	{
+		tbt::MappedArray<cl_uint> m(devCon, n, CL_MEM_READ_WRITE, tbt::msAllocHostPtr);
+		addResult(report, devCon, "load mapped-array", bytes, measure(opt, nothing, [&]() { a.loadBlocking(m); }));
+		addResult(report, devCon, "store mapped-array", bytes, measure(opt, nothing, [&]() { a.storeBlocking(m); }));
+	}
+
+	// mapping and unmapping mapped arrays with both allocation strategies
+	const tbt::MappingStrategy strategies[2] = { tbt::msUseHostPtr, tbt::msAllocHostPtr };
+	const char *strategyNames[2] = { "use-host-ptr", "alloc-host-ptr" };
+
+	for(int s = 0; s < 2; ++s) {
+		tbt::MappedArray<cl_uint> m(devCon, n, CL_MEM_READ_WRITE, strategies[s]);
+		addResult(report, devCon, string("unmap ") + strategyNames[s], bytes,
+			measure(opt, [&]() { m.mapDeviceToHostBlocking(tbt::mmReadWrite); }, [&]() { m.mapHostToDeviceBlocking(); }));
+		addResult(report, devCon, string("map ") + strategyNames[s], bytes,
+			measure(opt, [&]() { m.mapHostToDeviceBlocking(); }, [&]() { m.mapDeviceToHostBlocking(tbt::mmReadWrite); }));
+	}
+}
+
+
+//! Payload of \a N bytes for small transfers with device structs.
+template<int N>
+struct Payload {
+	cl_uchar m_data[N];
+};
+
+
+//! Measures loading and storing a device struct of \a N bytes on \a devCon.
+template<int N>
+void benchmarkStruct(BenchmarkReport &report, tbt::DeviceController *devCon, const Options &opt)
+{
+	auto nothing = []() { };
+
+	Payload<N> x;
+	for(int i = 0; i < N; ++i)
+		x.m_data[i] = (cl_uchar)i;
+
+	tbt::DeviceStruct<Payload<N> > s(devCon);
+	addResult(report, devCon, "load device-struct", N, measure(opt, nothing, [&]() { s.loadBlocking(x); }));
+	addResult(report, devCon, "store device-struct", N, measure(opt, nothing, [&]() { s.storeBlocking(x); }));
+}
+
+
+int main(int argc, char *argv[])
+{
+	cl_device_type deviceType = CL_DEVICE_TYPE_CPU;
+
+	Options opt;
+	opt.m_minLog    = 2;
+	opt.m_maxLog    = 28;
+	opt.m_stepLog   = 2;
+	opt.m_minRepeat = 5;
+	opt.m_minTime   = 100.0;
+
+	// parse command line arguments
+	for(int i = 1; i < argc; ++i) {
+		string cmd = argv[i];
+
+		if(cmd == "-h" || cmd == "--help") {
+			cout << "Call with: transfer-bench options-list" << endl;
+			cout << "\navailable options:" << endl;
+			cout << "\n-d, --device {CPU,GPU,CPU+GPU}\n  specifies the devices used: all CPU devices, all GPU devices, or both (requires a platform with CPUs and GPUs)" << endl;
+			cout << "\n--min-log k\n  smallest transfer size is 2^k bytes (default 2, at least 2)" << endl;
+			cout << "\n--max-log k\n  largest transfer size is 2^k bytes (default 28)" << endl;
+			cout << "\n--step-log k\n  transfer sizes grow by factor 2^k (default 2)" << endl;
+			cout << "\n-r, --repeat #runs\n  minimal number of timed runs per transfer (default 5)" << endl;
+			cout << "\n--min-time ms\n  minimal total time of the timed runs per transfer (default 100)" << endl;
+			cout << "\n--csv file\n  write results as CSV to file" << endl;
+			cout << "\n--json file\n  write results as JSON to file" << endl;
+			cout << "\n-h, --help\n  display this help and exit" << endl;
+			return 0;
+		}
+
+		if(++i >= argc) {
+			cerr << "Missing argument for option " << cmd << endl;
+			return 1;
+		}
+		string arg = argv[i];
+
+		if(cmd == "-d" || cmd == "--device") {
+			if(arg == "CPU" || arg == "cpu")
+				deviceType = CL_DEVICE_TYPE_CPU;
+			else if(arg == "GPU" || arg == "gpu")
+				deviceType = CL_DEVICE_TYPE_GPU;
+			else if(arg == "CPU+GPU" || arg == "cpu+gpu")
+				deviceType = CL_DEVICE_TYPE_CPU | CL_DEVICE_TYPE_GPU;
+			else {
+				cerr << "Unknown device type " << arg << endl;
+				return 1;
+			}
+
+		} else if(cmd == "--min-log") {
+			opt.m_minLog = max(2, atoi(arg.c_str()));
+
+		} else if(cmd == "--max-log") {
+			opt.m_maxLog = atoi(arg.c_str());
+
+		} else if(cmd == "--step-log") {
+			opt.m_stepLog = max(1, atoi(arg.c_str()));
+
+		} else if(cmd == "-r" || cmd == "--repeat") {
+			opt.m_minRepeat = max(1, atoi(arg.c_str()));
+
+		} else if(cmd == "--min-time") {
+			opt.m_minTime = atof(arg.c_str());
+
+		} else if(cmd == "--csv") {
+			opt.m_csvFile = arg;
+
+		} else if(cmd == "--json") {
+			opt.m_jsonFile = arg;
+
+		} else {
+			cerr << "Unknown option: " << cmd << endl;
+			return 1;
+		}
+	}
+
+	BenchmarkReport report("transfer");
+
+	try {
+		tbt::createContext(deviceType);
+
+		cout << left  << setw(28) << "device"
+		     << setw(24) << "path"
+		     << right << setw(11) << "bytes"
+		     << setw(8)  << "runs"
+		     << setw(14) << "median [us]"
+		     << setw(10) << "GB/s" << endl;
+
+		for(int d = 0; d < tbt::numDeviceControllers(); ++d) {
+			tbt::DeviceController *devCon = tbt::getDeviceController(d);
+
+			// latency of small transfers
+			benchmarkStruct<4>   (report, devCon, opt);
+			benchmarkStruct<64>  (report, devCon, opt);
+			benchmarkStruct<256> (report, devCon, opt);
+			benchmarkStruct<1024>(report, devCon, opt);
+			benchmarkStruct<4096>(report, devCon, opt);
+
+			// throughput versus transfer size
+			for(int k = opt.m_minLog; k <= opt.m_maxLog; k += opt.m_stepLog) {
+				size_t bytes = (size_t)1 << k;
+				if(bytes > devCon->getMaxMemAllocSize())
+					break;
+				benchmarkBulk(report, devCon, opt, bytes);
+			}
+		}
+
+	} catch(cl::Error err) {
+		cerr << "ERROR: " << err.what() << "(" << err.err() << ")" << endl;
+		report.write(opt.m_csvFile, opt.m_jsonFile);
+		return 1;
+
+	} catch(tbt::Error err) {
+		cerr << "ERROR: " << err.what() << endl;
+		report.write(opt.m_csvFile, opt.m_jsonFile);
+		return 1;
+	}
+
+	return report.write(opt.m_csvFile, opt.m_jsonFile) ? 0 : 1;
+}
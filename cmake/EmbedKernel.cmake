@@ -0,0 +1,9 @@
+# Converts the OpenCL source file INPUT into the comma-separated list of bytes OUTPUT,
+# which is included by src/EmbeddedPrograms.cpp if TBT_EMBED_KERNELS is defined.
+#
+# usage: cmake -DINPUT=kernels/radix.cl -DOUTPUT=radix.cl.inc -P EmbedKernel.cmake
+
+file(READ "${INPUT}" hex HEX)
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${hex}")
+string(REGEX REPLACE ",$" "" bytes "${bytes}")
+file(WRITE "${OUTPUT}" "${bytes}")
@@ -0,0 +1,74 @@
+
+/*---------------------------------------------------------
+                        copyUInt4
+  ---------------------------------------------------------*/
+
+  // copies src[0 .. n) to tgt[0 .. n) with a grid-stride loop,
+  // so that any number of work-items can be used
+
+__kernel
+void copyUInt4(
+	__global const uint4 * restrict src,
+	__global uint4 * restrict tgt,
+	uint n)
+{
+	size_t stride = get_global_size(0);
+	for(size_t i = get_global_id(0); i < n; i += stride)
+		tgt[i] = src[i];
+}
+
+
+/*---------------------------------------------------------
+                      readLocalMemory
+  ---------------------------------------------------------*/
+
+  // reads 'iterations' values from local memory per work-item;
+  // consecutive work-items access consecutive words (no bank conflicts)
+
+__kernel
+void readLocalMemory(
+	__global uint *result,
+	uint iterations)
+{
+	__local uint buf[256];
+
+	uint l = get_local_id(0);
+	for(uint j = l; j < 256; j += get_local_size(0))
+		buf[j] = j;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	uint sum = 0;
+	for(uint i = 0; i < iterations; ++i)
+		sum += buf[(l + i) & 255];
+
+	result[get_global_id(0)] = sum;
+}
+
+
+/*---------------------------------------------------------
+                       atomicAddUInt
+  ---------------------------------------------------------*/
+
+  // performs 'iterations' atomic additions per work-item on one
+  // of 64 counters
+
+__kernel
+void atomicAddUInt(
+	__global uint *counters,
+	uint iterations)
+{
+	__global uint *c = counters + (get_global_id(0) & 63);
+	for(uint i = 0; i < iterations; ++i)
+		atomic_add(c, 1);
+}
+
+
+/*---------------------------------------------------------
+                        emptyKernel
+  ---------------------------------------------------------*/
+
+__kernel
+void emptyKernel(
+	__global uint *a)
+{
+}
@@ -0,0 +1,51 @@
+
+/*---------------------------------------------------------
+                          fillUInt
+  ---------------------------------------------------------*/
+
+  // fills buf[offset .. offset+n) (in units of uint) with a pattern of
+  // patternLen uints (patternLen <= 16)
+
+__kernel
+void fillUInt(
+	__global uint * restrict buf,
+	uint offset,
+	uint n,
+	uint16 pattern,
+	uint patternLen)
+{
+	size_t i = get_global_id(0);
+	if(i >= n)
+		return;
+
+	uint p[16];
+	vstore16(pattern, 0, p);
+
+	buf[offset + i] = p[i % patternLen];
+}
+
+
+/*---------------------------------------------------------
+                          fillUChar
+  ---------------------------------------------------------*/
+
+  // fills buf[offset .. offset+n) (in bytes) with a pattern of
+  // patternLen bytes (patternLen <= 64)
+
+__kernel
+void fillUChar(
+	__global uchar * restrict buf,
+	uint offset,
+	uint n,
+	uint16 pattern,
+	uint patternLen)
+{
+	size_t i = get_global_id(0);
+	if(i >= n)
+		return;
+
+	uint p[16];
+	vstore16(pattern, 0, p);
+
+	buf[offset + i] = ((uchar *)p)[i % patternLen];
+}
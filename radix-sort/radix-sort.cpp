@@ -169,6 +169,7 @@ int main(int argc, char *argv[])
 		cout << "total kernel time:          " << radixSort.totalTimeKernels() << " ms" << endl;
 		cout << endl;
 		cout << "total time:                 " << radixSort.totalTime() << " ms" << endl;
+		cout << "host time:                  " << radixSort.hostTime() << " ms" << endl;
 
 		cout << "Checking results..." << flush;
 		sort(&c[0],&c[n]);
@@ -0,0 +1,268 @@
+
+#include <tbt/CommandGraph.h>
+#include <tbt/Profiler.h>
+
+using namespace std;
+
+
+// Types and entry points of cl_khr_command_buffer (revision 0.9.5), which are not declared by the
+// OpenCL headers used by TBT. The entry points are queried at runtime.
+#ifndef cl_khr_command_buffer
+typedef struct _cl_command_buffer_khr *cl_command_buffer_khr;
+typedef struct _cl_mutable_command_khr *cl_mutable_command_khr;
+typedef cl_uint  cl_sync_point_khr;
+typedef cl_ulong cl_command_buffer_properties_khr;
+typedef cl_ulong cl_command_properties_khr;
+#endif
+
+#define TBT_CL_DEVICE_EXTENSIONS_WITH_VERSION   0x1060
+#define TBT_CL_COMMAND_BUFFER_FLAGS_KHR         0x1293
+#define TBT_CL_COMMAND_BUFFER_SIMULTANEOUS_USE  (1 << 0)
+
+#define TBT_CL_MAKE_VERSION(major,minor,patch)  (((major) << 22) | ((minor) << 12) | (patch))
+#define TBT_COMMAND_BUFFER_VERSION              TBT_CL_MAKE_VERSION(0,9,5)
+
+extern "C" {
+	typedef cl_command_buffer_khr (CL_API_CALL *tbtCreateCommandBufferKHR)(cl_uint numQueues, const cl_command_queue *queues,
+		const cl_command_buffer_properties_khr *properties, cl_int *errcode);
+	typedef cl_int (CL_API_CALL *tbtFinalizeCommandBufferKHR)(cl_command_buffer_khr commandBuffer);
+	typedef cl_int (CL_API_CALL *tbtReleaseCommandBufferKHR)(cl_command_buffer_khr commandBuffer);
+	typedef cl_int (CL_API_CALL *tbtCommandNDRangeKernelKHR)(cl_command_buffer_khr commandBuffer, cl_command_queue queue,
+		const cl_command_properties_khr *properties, cl_kernel kernel, cl_uint workDim, const size_t *globalWorkOffset,
+		const size_t *globalWorkSize, const size_t *localWorkSize, cl_uint numSyncPoints, const cl_sync_point_khr *syncPointWaitList,
+		cl_sync_point_khr *syncPoint, cl_mutable_command_khr *mutableHandle);
+	typedef cl_int (CL_API_CALL *tbtEnqueueCommandBufferKHR)(cl_uint numQueues, cl_command_queue *queues, cl_command_buffer_khr commandBuffer,
+		cl_uint numEvents, const cl_event *eventWaitList, cl_event *event);
+}
+
+
+namespace tbt
+{
+
+	//! A command buffer of cl_khr_command_buffer together with the entry points of the extension.
+	struct CommandGraph::CommandBufferKHR {
+		tbtCreateCommandBufferKHR   m_create;
+		tbtFinalizeCommandBufferKHR m_finalize;
+		tbtReleaseCommandBufferKHR  m_release;
+		tbtCommandNDRangeKernelKHR  m_commandNDRangeKernel;
+		tbtEnqueueCommandBufferKHR  m_enqueue;
+
+		cl_command_buffer_khr m_handle;        //!< the command buffer.
+		bool                  m_simultaneous;  //!< may the command buffer be enqueued while a previous replay is pending?
+		cl::Event             m_evLast;        //!< completion of the last replay.
+
+		CommandBufferKHR() : m_handle(0), m_simultaneous(false) { }
+		~CommandBufferKHR() {
+			if(m_handle != 0)
+				m_release(m_handle);
+		}
+	};
+
+
+	//! Returns the address of extension function \a name for the platform of \a device.
+	static void *getExtensionFunction(const cl::Device &device, const char *name)
+	{
+#ifdef CL_VERSION_1_2
+		cl_platform_id platform = device.getInfo<CL_DEVICE_PLATFORM>();
+		return clGetExtensionFunctionAddressForPlatform(platform, name);
+#else
+		return clGetExtensionFunctionAddress(name);
+#endif
+	}
+
+
+	bool CommandGraph::isCommandBufferSupported(DeviceController *devCon)
+	{
+		// the extension version can only be queried on OpenCL 3.0 devices
+		if(devCon->getVersionNumber() < 300)
+			return false;
+
+		cl_device_id device = devCon->getDevice()();
+
+		struct NameVersion {
+			cl_uint m_version;
+			char    m_name[64];
+		};
+
+		size_t size = 0;
+		if(clGetDeviceInfo(device, TBT_CL_DEVICE_EXTENSIONS_WITH_VERSION, 0, 0, &size) != CL_SUCCESS || size == 0)
+			return false;
+
+		vector<NameVersion> extensions(size / sizeof(NameVersion));
+		if(clGetDeviceInfo(device, TBT_CL_DEVICE_EXTENSIONS_WITH_VERSION, extensions.size()*sizeof(NameVersion), &extensions[0], 0) != CL_SUCCESS)
+			return false;
+
+		// the extension is provisional and its API changes between revisions, hence only the revision
+		// whose entry points are declared above is accepted
+		for(size_t i = 0; i < extensions.size(); ++i)
+			if(string(extensions[i].m_name) == "cl_khr_command_buffer")
+				return extensions[i].m_version == TBT_COMMAND_BUFFER_VERSION;
+
+		return false;
+	}
+
+
+	CommandGraph::CommandGraph(DeviceController *devCon, QueueId queue)
+		: m_devCon(devCon), m_queue(queue), m_finalized(false), m_commandBuffer(0)
+	{
+	}
+
+
+	CommandGraph::~CommandGraph()
+	{
+		delete m_commandBuffer;
+	}
+
+
+	cl::Kernel CommandGraph::addKernel(const cl::Program &program, const char *kernelName, size_t globalWork, size_t localWork)
+	{
+		if(m_finalized)
+			throw Error("CommandGraph: cannot add kernels to a finalized command graph!", Error::ecUnknown);
+
+		Node node;
+		node.m_kernel     = cl::Kernel(program, kernelName);
+		node.m_globalWork = globalWork;
+		node.m_localWork  = localWork;
+
+		m_nodes.push_back(node);
+		return node.m_kernel;
+	}
+
+
+	cl::Kernel CommandGraph::addKernel(const cl::Kernel &kernel, size_t globalWork, size_t localWork)
+	{
+		cl::Program program    = kernel.getInfo<CL_KERNEL_PROGRAM>();
+		std::string kernelName = kernel.getInfo<CL_KERNEL_FUNCTION_NAME>();
+
+		return addKernel(program, kernelName.c_str(), globalWork, localWork);
+	}
+
+
+	void CommandGraph::finalize()
+	{
+		if(m_finalized)
+			return;
+		m_finalized = true;
+
+		if(m_nodes.empty() || !isCommandBufferSupported(m_devCon))
+			return;
+
+		cl::Device device = m_devCon->getDevice();
+		CommandBufferKHR *cb = new CommandBufferKHR;
+
+		cb->m_create               = (tbtCreateCommandBufferKHR)   getExtensionFunction(device, "clCreateCommandBufferKHR");
+		cb->m_finalize             = (tbtFinalizeCommandBufferKHR) getExtensionFunction(device, "clFinalizeCommandBufferKHR");
+		cb->m_release              = (tbtReleaseCommandBufferKHR)  getExtensionFunction(device, "clReleaseCommandBufferKHR");
+		cb->m_commandNDRangeKernel = (tbtCommandNDRangeKernelKHR)  getExtensionFunction(device, "clCommandNDRangeKernelKHR");
+		cb->m_enqueue              = (tbtEnqueueCommandBufferKHR)  getExtensionFunction(device, "clEnqueueCommandBufferKHR");
+
+		if(cb->m_create == 0 || cb->m_finalize == 0 || cb->m_release == 0 || cb->m_commandNDRangeKernel == 0 || cb->m_enqueue == 0) {
+			delete cb;
+			return;
+		}
+
+		// prefer a command buffer that can be enqueued again while a previous replay is pending
+		cl_command_queue queue = m_devCon->getCommandQueue(m_queue)();
+		cl_command_buffer_properties_khr properties[] = { TBT_CL_COMMAND_BUFFER_FLAGS_KHR, TBT_CL_COMMAND_BUFFER_SIMULTANEOUS_USE, 0 };
+
+		cl_int err;
+		cb->m_handle = cb->m_create(1, &queue, properties, &err);
+		cb->m_simultaneous = (err == CL_SUCCESS);
+		if(err != CL_SUCCESS)
+			cb->m_handle = cb->m_create(1, &queue, 0, &err);
+
+		// the launches are chained by sync points, since commands in a command buffer are not ordered otherwise
+		cl_sync_point_khr syncPoint = 0;
+		for(size_t i = 0; i < m_nodes.size() && err == CL_SUCCESS; ++i) {
+			const Node &node = m_nodes[i];
+			err = cb->m_commandNDRangeKernel(cb->m_handle, 0, 0, node.m_kernel(), 1, 0,
+				&node.m_globalWork, (node.m_localWork > 0) ? &node.m_localWork : 0,
+				(i > 0) ? 1 : 0, (i > 0) ? &syncPoint : 0, &syncPoint, 0);
+		}
+
+		if(err == CL_SUCCESS)
+			err = cb->m_finalize(cb->m_handle);
+
+		// fall back to replaying the pre-bound kernels if the device cannot record the graph
+		if(err != CL_SUCCESS)
+			delete cb;
+		else
+			m_commandBuffer = cb;
+	}
+
+
+	void CommandGraph::replay(const cl::vector<cl::Event> *events, cl::Event *ev)
+	{
+		if(!m_finalized)
+			finalize();
+
+		cl::CommandQueue commandQueue = m_devCon->getCommandQueue(m_queue);
+		cl_command_queue queue = commandQueue();
+
+		cl_uint         numEvents = (events != 0) ? (cl_uint)events->size() : 0;
+		const cl_event *waitList  = (numEvents > 0) ? (const cl_event *) &events->front() : 0;
+
+		if(m_nodes.empty()) {
+			if(numEvents > 0)
+				commandQueue.enqueueWaitForEvents(*events);
+			if(ev != 0)
+				commandQueue.enqueueMarker(ev);
+			return;
+		}
+
+		Profiler *profiler = m_devCon->getProfiler();
+
+		cl_event tmp;
+		cl_int err;
+
+		if(m_commandBuffer != 0) {
+			// without simultaneous use, the previous replay must have completed
+			if(!m_commandBuffer->m_simultaneous && m_commandBuffer->m_evLast() != 0)
+				m_commandBuffer->m_evLast.wait();
+
+			err = m_commandBuffer->m_enqueue(1, &queue, m_commandBuffer->m_handle, numEvents, waitList, &tmp);
+			if(err != CL_SUCCESS)
+				throw cl::Error(err, "clEnqueueCommandBufferKHR");
+
+			m_commandBuffer->m_evLast = tmp;
+			m_devCon->getCounters().addKernels(m_nodes.size());
+			if(profiler != 0)
+				profiler->record(m_devCon, pcKernel, "command graph", m_queue, 0, m_commandBuffer->m_evLast);
+			if(ev != 0)
+				*ev = m_commandBuffer->m_evLast;
+			return;
+		}
+
+		// launches in out-of-order queues are ordered by barriers
+		const bool outOfOrder = m_devCon->isOutOfOrder();
+		const size_t last = m_nodes.size() - 1;
+
+		for(size_t i = 0; i <= last; ++i) {
+			const Node &node = m_nodes[i];
+
+			// events are only created for the last launch, or for every launch if a profiler is attached
+			const bool needEvent = (i == last && ev != 0) || profiler != 0;
+
+			err = clEnqueueNDRangeKernel(queue, node.m_kernel(), 1, 0,
+				&node.m_globalWork, (node.m_localWork > 0) ? &node.m_localWork : 0,
+				(i == 0) ? numEvents : 0, (i == 0) ? waitList : 0,
+				needEvent ? &tmp : 0);
+			if(err != CL_SUCCESS)
+				throw cl::Error(err, "clEnqueueNDRangeKernel");
+
+			if(needEvent) {
+				cl::Event evLaunch(tmp);
+				if(profiler != 0)
+					profiler->record(m_devCon, pcKernel, node.m_kernel.getInfo<CL_KERNEL_FUNCTION_NAME>(), m_queue, 0, evLaunch);
+				if(i == last && ev != 0)
+					*ev = evLaunch;
+			}
+
+			if(outOfOrder && i < last)
+				clEnqueueBarrier(queue);
+		}
+
+		m_devCon->getCounters().addKernels(m_nodes.size());
+	}
+
+}
@@ -0,0 +1,221 @@
+#include <tbt/DeviceCharacteristics.h>
+#include <tbt/DeviceController.h>
+#include <tbt/Utility.h>
+#include <tbt/Timer.h>
+
+#include <fstream>
+#include <functional>
+#include <vector>
+#include <stdlib.h>
+
+using namespace std;
+
+
+namespace tbt
+{
+
+	//! Runs \a run once for warm-up, then \a rounds times and returns the minimal time in ms.
+	static double bestTime(int rounds, cl::CommandQueue &queue, const function<void()> &run)
+	{
+		run();
+		queue.finish();
+
+		double best = 0;
+		for(int r = 0; r < rounds; ++r) {
+			Timer timer;
+			run();
+			queue.finish();
+			double t = timer.elapsed();
+
+			if(r == 0 || t < best)
+				best = t;
+		}
+
+		return best;
+	}
+
+
+	DeviceCharacteristics DeviceCharacteristics::measure(DeviceController *devCon)
+	{
+		DeviceCharacteristics c;
+
+		// build the program for this device only; the programs built with Utility::buildProgram()
+		// are built for the default device
+		string source = Utility::getProgramSource("characterize.cl");
+
+		cl::vector<cl::Device> devices(1, devCon->getDevice());
+		cl::Program::Sources sources(1, make_pair(source.c_str(), source.length()));
+		cl::Program program(devCon->getContext(), sources);
+		try {
+			program.build(devices);
+		} catch(cl::Error) {
+			string msg = "DeviceCharacteristics::measure: Error while building program!\nBuild-Log:\n";
+			msg += program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(devCon->getDevice());
+			throw Error(msg.c_str(), Error::ecKernelCompileError);
+		}
+
+		// a private queue, so that pending commands of the device controller are not waited for
+		cl::Context context = devCon->getContext();
+		cl::CommandQueue queue(context, devCon->getDevice());
+
+		size_t maxLocal = min(devCon->getMaxWorkGroupSize(), (size_t)64);
+		size_t numCUs   = devCon->getMaxComputeUnits();
+
+		// launch latency
+		cl::Buffer bufferSmall(context, CL_MEM_READ_WRITE, 64*sizeof(cl_uint));
+		cl::Kernel kernelEmpty(program, "emptyKernel");
+		kernelEmpty.setArg<cl::Buffer>(0, bufferSmall);
+
+		const int numLaunches = 100;
+		c.m_launchLatency = 1.e3 / numLaunches * bestTime(3, queue, [&]() {
+			for(int i = 0; i < numLaunches; ++i) {
+				queue.enqueueNDRangeKernel(kernelEmpty, cl::NullRange, cl::NDRange(1), cl::NullRange);
+				queue.finish();
+			}
+		});
+		double latencyMs = 1.e-3 * c.m_launchLatency;
+
+		// global memory bandwidth versus number of work-items
+		size_t bytes = 32*1024*1024;
+		bytes = (size_t)min<cl_ulong>(bytes, devCon->getMaxMemAllocSize());
+		bytes = (size_t)min<cl_ulong>(bytes, devCon->getGlobalMemSize() / 8);
+		bytes &= ~(size_t)15;
+		cl_uint n = (cl_uint)(bytes / 16);
+
+		cl::Buffer bufferSrc(context, CL_MEM_READ_ONLY,  bytes);
+		cl::Buffer bufferTgt(context, CL_MEM_WRITE_ONLY, bytes);
+		cl::Kernel kernelCopy(program, "copyUInt4");
+		kernelCopy.setArg<cl::Buffer>(0, bufferSrc);
+		kernelCopy.setArg<cl::Buffer>(1, bufferTgt);
+		kernelCopy.setArg<cl_uint>   (2, n);
+
+		vector<pair<size_t,double> > sweep;
+		for(size_t g = maxLocal; ; g *= 2) {
+			size_t workItems = min(g, (size_t)n);
+			double t = bestTime(3, queue, [&]() {
+				queue.enqueueNDRangeKernel(kernelCopy, cl::NullRange, cl::NDRange(workItems), cl::NullRange);
+			});
+			t = max(t - latencyMs, 1.e-3);
+
+			double bandwidth = 2.0 * bytes / (1.e6 * t);
+			sweep.push_back(make_pair(workItems, bandwidth));
+			c.m_globalBandwidth = max(c.m_globalBandwidth, bandwidth);
+
+			if(workItems == n || g >= (1 << 20))
+				break;
+		}
+
+		for(size_t i = 0; i < sweep.size(); ++i) {
+			if(sweep[i].second >= 0.8 * c.m_globalBandwidth) {
+				c.m_saturationWorkItems = (cl_uint)sweep[i].first;
+				break;
+			}
+		}
+
+		// local memory bandwidth
+		size_t globalLocal = 4 * numCUs * maxLocal;
+		const cl_uint localIterations = 4096;
+
+		cl::Buffer bufferResult(context, CL_MEM_WRITE_ONLY, globalLocal*sizeof(cl_uint));
+		cl::Kernel kernelLocal(program, "readLocalMemory");
+		kernelLocal.setArg<cl::Buffer>(0, bufferResult);
+		kernelLocal.setArg<cl_uint>   (1, localIterations);
+
+		double tLocal = bestTime(3, queue, [&]() {
+			queue.enqueueNDRangeKernel(kernelLocal, cl::NullRange, cl::NDRange(globalLocal), cl::NDRange(maxLocal));
+		});
+		tLocal = max(tLocal - latencyMs, 1.e-3);
+		c.m_localBandwidth = (double)globalLocal * localIterations * sizeof(cl_uint) / (1.e6 * tLocal);
+
+		// throughput of global atomics
+		size_t globalAtomics = 4 * numCUs * maxLocal;
+		const cl_uint atomicIterations = 256;
+
+		cl::Kernel kernelAtomics(program, "atomicAddUInt");
+		kernelAtomics.setArg<cl::Buffer>(0, bufferSmall);
+		kernelAtomics.setArg<cl_uint>   (1, atomicIterations);
+
+		double tAtomics = bestTime(3, queue, [&]() {
+			queue.enqueueNDRangeKernel(kernelAtomics, cl::NullRange, cl::NDRange(globalAtomics), cl::NullRange);
+		});
+		tAtomics = max(tAtomics - latencyMs, 1.e-3);
+		c.m_atomicsThroughput = (double)globalAtomics * atomicIterations / (1.e3 * tAtomics);
+
+		return c;
+	}
+
+
+	bool DeviceCharacteristics::load(const char *fileName, const DeviceController *devCon)
+	{
+		ifstream is(fileName);
+		if(!is) return false;
+
+		DeviceCharacteristics c;
+		bool checkedName   = false;
+		bool checkedDriver = false;
+
+		string line;
+		while(getline(is, line))
+		{
+			size_t tabPos = line.find('\t');
+			if(tabPos == string::npos) continue;
+
+			string name  = line.substr(0, tabPos);
+			string value = line.substr(tabPos+1);
+
+			if(name == "CL_DEVICE_NAME") {
+				if(devCon->getName() != value) return false;
+				checkedName = true;
+
+			} else if(name == "CL_DRIVER_VERSION") {
+				if(devCon->getDriverVersion() != value) return false;
+				checkedDriver = true;
+
+			} else if(name == "TBT_GLOBAL_BANDWIDTH")
+				c.m_globalBandwidth = atof(value.c_str());
+			else if(name == "TBT_SATURATION_WORK_ITEMS")
+				c.m_saturationWorkItems = (cl_uint)strtoul(value.c_str(), 0, 10);
+			else if(name == "TBT_LOCAL_BANDWIDTH")
+				c.m_localBandwidth = atof(value.c_str());
+			else if(name == "TBT_ATOMICS_THROUGHPUT")
+				c.m_atomicsThroughput = atof(value.c_str());
+			else if(name == "TBT_LAUNCH_LATENCY")
+				c.m_launchLatency = atof(value.c_str());
+		}
+
+		if(!checkedName || !checkedDriver || !c.isValid())
+			return false;
+
+		*this = c;
+		return true;
+	}
+
+
+	bool DeviceCharacteristics::save(const char *fileName, const DeviceController *devCon) const
+	{
+		ofstream os(fileName);
+		if(!os) return false;
+
+		os << "CL_DEVICE_NAME\t"            << devCon->getName()          << "\n";
+		os << "CL_DRIVER_VERSION\t"         << devCon->getDriverVersion() << "\n";
+		os << "TBT_GLOBAL_BANDWIDTH\t"      << m_globalBandwidth          << "\n";
+		os << "TBT_SATURATION_WORK_ITEMS\t" << m_saturationWorkItems      << "\n";
+		os << "TBT_LOCAL_BANDWIDTH\t"       << m_localBandwidth           << "\n";
+		os << "TBT_ATOMICS_THROUGHPUT\t"    << m_atomicsThroughput        << "\n";
+		os << "TBT_LAUNCH_LATENCY\t"        << m_launchLatency            << "\n";
+
+		return true;
+	}
+
+
+	std::ostream &DeviceCharacteristics::displayInfo(std::ostream &os) const
+	{
+		os << "    global bandwidth:       " << m_globalBandwidth << " GB/s (saturated with " << m_saturationWorkItems << " work-items)" << endl;
+		os << "    local bandwidth:        " << m_localBandwidth << " GB/s" << endl;
+		os << "    atomics throughput:     " << m_atomicsThroughput << " Mops/s" << endl;
+		os << "    launch latency:         " << m_launchLatency << " us" << endl;
+
+		return os;
+	}
+
+}
@@ -2,6 +2,14 @@
 #include <tbt/DeviceController.h>
 #include <tbt/Global.h>
 #include <tbt/Utility.h>
+#include <tbt/KernelPool.h>
+#include <tbt/Profiler.h>
+#include <tbt/Timer.h>
+
+#include <thread>
+
+#include <stdio.h>
+#include <string.h>
 
 using namespace std;
 
@@ -42,9 +50,15 @@ namespace tbt
 
 
 	DeviceController::DeviceController(cl::Device device, cl::Context context, cl_command_queue_properties properties)
-		: m_device(device), m_context(context)
+		: m_device(device), m_context(context), m_queueProperties(properties),
+		  m_counters(make_shared<DeviceCounters>()),
+		  m_profiler(0),
+		  m_forceFillKernel(false), m_characterized(false)
 	{
-		m_queue = cl::CommandQueue(m_context, m_device, properties);
+		for(int i = 0; i < TBT_NUM_QUEUES; ++i)
+			m_queue[i] = cl::CommandQueue(m_context, m_device, properties);
+
+		m_memoryPool = make_shared<MemoryPool>(context, (size_t)device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>(), m_counters.get(), m_queue, TBT_NUM_QUEUES);
 
 		device.getInfo(CL_DEVICE_TYPE,                      &m_deviceType);
 		device.getInfo(CL_DEVICE_MAX_COMPUTE_UNITS,         &m_maxComputeUnits);
@@ -75,6 +89,22 @@ namespace tbt
 				m_supportedExtensions |= val;
 			}
 		}
+
+		// the version string has the form "OpenCL <major>.<minor> <vendor-specific information>"
+		int major = 1, minor = 0;
+		sscanf(getVersion().c_str(), "OpenCL %d.%d", &major, &minor);
+		m_versionNumber = 100*major + 10*minor;
+#ifndef CL_VERSION_1_2
+		if(m_versionNumber > 110)
+			m_versionNumber = 110;
+#endif
+	}
+
+
+	DeviceController::~DeviceController()
+	{
+		// the pool lives on while device arrays refer to it; release cached buffers and do not cache more
+		m_memoryPool->setEnabled(false);
 	}
 
 
@@ -85,15 +115,14 @@ namespace tbt
 
 		cl_uint allExt = requiredExt | optionalExt;
 		std::string openclHeader;
-		char buffer[256];
 
 		cl_uint ext = 1;
 		for(int i = 0; i < TBT_NUM_EXT; i++, ext <<= 1) {
 			if(allExt & ext) {
 				int j = m_extString[i];
 				if(j != -1) {
-					sprintf_s(buffer, 256, "#pragma OPENCL EXTENSION %s : enable\n#define %s\n", s_strExtension[j], s_defineExtension[i]);
-					openclHeader += buffer;
+					openclHeader += string("#pragma OPENCL EXTENSION ") + s_strExtension[j] + " : enable\n";
+					openclHeader += string("#define ") + s_defineExtension[i] + "\n";
 				}
 			}
 		}
@@ -191,6 +220,79 @@ namespace tbt
 	}
 
 	
+	//! Returns true if all \a events complete within \a timeout milliseconds; polls without waiting on the events.
+	static bool completeWithin(const cl::vector<cl::Event> &events, double timeout)
+	{
+		Timer timer;
+		for(;;) {
+			bool complete = true;
+			for(size_t i = 0; i < events.size(); ++i)
+				if(events[i].getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() > CL_COMPLETE)
+					complete = false;
+
+			if(complete)
+				return true;
+			if(timer.elapsed() > timeout)
+				return false;
+			this_thread::yield();
+		}
+	}
+
+
+	void DeviceController::characterize()
+	{
+		call_once(m_characteristicsFlag, [this]() {
+			string dir, fileName;
+			bool cache = globalConfig.getCacheProgramBinaries() && Utility::getDeviceCacheDir(this, dir);
+			if(cache)
+				fileName = dir + Utility::getPathSeparator() + "characteristics.info";
+
+			if(cache && m_characteristics.load(fileName.c_str(), this)) {
+				m_characterized = true;
+				return;
+			}
+
+			// commands pending in the queues or enqueued during the measurement compete for the device; markers
+			// reveal pending commands (without blocking on commands that wait for user events), and the counters
+			// reveal commands enqueued meanwhile
+			cl::vector<cl::Event> markers(TBT_NUM_QUEUES);
+			for(int q = 0; q < TBT_NUM_QUEUES; ++q) {
+				m_queue[q].enqueueMarker(&markers[q]);
+				m_queue[q].flush();
+			}
+			bool contended = !completeWithin(markers, 100.0);
+			DeviceCounters::Values before = m_counters->getValues();
+
+			// the characteristics remain invalid if they cannot be measured
+			DeviceCharacteristics c;
+			try {
+				c = DeviceCharacteristics::measure(this);
+			} catch(cl::Error) {
+			} catch(Error) {
+			}
+
+			DeviceCounters::Values after = m_counters->getValues();
+			contended = contended || after.m_numKernels != before.m_numKernels || after.m_bytesLoaded != before.m_bytesLoaded
+				|| after.m_bytesStored != before.m_bytesStored || after.m_bytesMapped != before.m_bytesMapped;
+
+			m_characteristics = c;
+			m_characterized = true;
+
+			if(cache && !contended && c.isValid())
+				c.save(fileName.c_str(), this);
+		});
+	}
+
+
+	//! Returned by getCharacteristics() before the characteristics have been determined.
+	static const DeviceCharacteristics s_invalidCharacteristics;
+
+	const DeviceCharacteristics &DeviceController::getCharacteristics() const
+	{
+		return m_characterized ? m_characteristics : s_invalidCharacteristics;
+	}
+
+
 	std::ostream &DeviceController::displayInfo(std::ostream &os)
 	{
 		os << "    name:   " << getName() << endl;
@@ -237,7 +339,7 @@ namespace tbt
 	cl_command_queue_properties DeviceController::getCommandQueueProperties() const
 	{
 		cl_command_queue_properties props;
-		m_queue.getInfo(CL_QUEUE_PROPERTIES, &props);
+		m_queue[qiCompute].getInfo(CL_QUEUE_PROPERTIES, &props);
 		return props;
 	}
 
@@ -322,15 +424,258 @@ namespace tbt
 	}
 
 
+	//! Returns \a ev, or \a evProfile if no event is requested but a profiler needs one.
+	static cl::Event *profilingEvent(Profiler *profiler, cl::Event *ev, cl::Event &evProfile)
+	{
+		return (ev == 0 && profiler != 0) ? &evProfile : ev;
+	}
+
+
 	void DeviceController::enqueue1DRangeKernel(
 		const cl::Kernel &kernel,
 		size_t globalWork,
 		size_t localWork,
 		const cl::vector<cl::Event> *events,
-		cl::Event *ev)
+		cl::Event *ev,
+		QueueId queue)
 	{
+		Profiler  *profiler = m_profiler;
+		cl::Event  evProfile;
+		cl::Event *pev = profilingEvent(profiler, ev, evProfile);
+
 		cl::NDRange localWorkRange = (localWork > 0) ? cl::NDRange(localWork) : cl::NullRange;
-		m_queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(globalWork), localWorkRange, events, ev);
+		m_queue[queue].enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(globalWork), localWorkRange, events, pev);
+		m_counters->addKernels();
+
+		if(profiler != 0)
+			profiler->record(this, pcKernel, kernel.getInfo<CL_KERNEL_FUNCTION_NAME>(), queue, 0, *pev);
+	}
+
+
+	void DeviceController::enqueueTask(
+		const cl::Kernel &kernel,
+		const cl::vector<cl::Event> *events,
+		cl::Event *ev,
+		QueueId queue)
+	{
+		Profiler  *profiler = m_profiler;
+		cl::Event  evProfile;
+		cl::Event *pev = profilingEvent(profiler, ev, evProfile);
+
+		m_queue[queue].enqueueTask(kernel, events, pev);
+		m_counters->addKernels();
+
+		if(profiler != 0)
+			profiler->record(this, pcKernel, kernel.getInfo<CL_KERNEL_FUNCTION_NAME>(), queue, 0, *pev);
+	}
+
+
+	void DeviceController::enqueueCopyBuffer(
+		const cl::Buffer &src,
+		const cl::Buffer &dst,
+		size_t srcOffset,
+		size_t dstOffset,
+		size_t size,
+		const cl::vector<cl::Event> *events,
+		cl::Event *ev,
+		QueueId queue)
+	{
+		Profiler  *profiler = m_profiler;
+		cl::Event  evProfile;
+		cl::Event *pev = profilingEvent(profiler, ev, evProfile);
+
+		m_queue[queue].enqueueCopyBuffer(src, dst, srcOffset, dstOffset, size, events, pev);
+
+		if(profiler != 0)
+			profiler->record(this, pcCopy, "copy buffer", queue, size, *pev);
+	}
+
+
+	void DeviceController::enqueueWriteBuffer(
+		const cl::Buffer &buffer,
+		bool blocking,
+		size_t offset,
+		size_t size,
+		const void *ptr,
+		const cl::vector<cl::Event> *events,
+		cl::Event *ev,
+		QueueId queue)
+	{
+		Profiler  *profiler = m_profiler;
+		cl::Event  evProfile;
+		cl::Event *pev = profilingEvent(profiler, ev, evProfile);
+
+		m_queue[queue].enqueueWriteBuffer(buffer, blocking ? CL_TRUE : CL_FALSE, offset, size, ptr, events, pev);
+		m_counters->addBytesLoaded(size);
+
+		if(profiler != 0)
+			profiler->record(this, pcUpload, "write buffer", queue, size, *pev);
+	}
+
+
+	void DeviceController::enqueueReadBuffer(
+		const cl::Buffer &buffer,
+		bool blocking,
+		size_t offset,
+		size_t size,
+		void *ptr,
+		const cl::vector<cl::Event> *events,
+		cl::Event *ev,
+		QueueId queue)
+	{
+		Profiler  *profiler = m_profiler;
+		cl::Event  evProfile;
+		cl::Event *pev = profilingEvent(profiler, ev, evProfile);
+
+		m_queue[queue].enqueueReadBuffer(buffer, blocking ? CL_TRUE : CL_FALSE, offset, size, ptr, events, pev);
+		m_counters->addBytesStored(size);
+
+		if(profiler != 0)
+			profiler->record(this, pcDownload, "read buffer", queue, size, *pev);
+	}
+
+
+	void *DeviceController::enqueueMapBuffer(
+		const cl::Buffer &buffer,
+		bool blocking,
+		cl_map_flags flags,
+		size_t offset,
+		size_t size,
+		const cl::vector<cl::Event> *events,
+		cl::Event *ev,
+		QueueId queue)
+	{
+		Profiler  *profiler = m_profiler;
+		cl::Event  evProfile;
+		cl::Event *pev = profilingEvent(profiler, ev, evProfile);
+
+		void *ptr = m_queue[queue].enqueueMapBuffer(buffer, blocking ? CL_TRUE : CL_FALSE, flags, offset, size, events, pev);
+		m_counters->addBytesMapped(size);
+
+		if(profiler != 0)
+			profiler->record(this, pcMap, "map buffer", queue, size, *pev);
+
+		return ptr;
+	}
+
+
+	void DeviceController::enqueueUnmapMemObject(
+		const cl::Memory &memObject,
+		void *ptr,
+		size_t size,
+		const cl::vector<cl::Event> *events,
+		cl::Event *ev,
+		QueueId queue)
+	{
+		Profiler  *profiler = m_profiler;
+		cl::Event  evProfile;
+		cl::Event *pev = profilingEvent(profiler, ev, evProfile);
+
+		m_queue[queue].enqueueUnmapMemObject(memObject, ptr, events, pev);
+
+		if(profiler != 0)
+			profiler->record(this, pcUnmap, "unmap buffer", queue, size, *pev);
+	}
+
+
+	//! Kernels used by DeviceController::enqueueFillBuffer() if clEnqueueFillBuffer is not available (built per device).
+	struct FillKernels {
+		cl::Kernel m_kernelFillUInt;
+		cl::Kernel m_kernelFillUChar;
+
+		FillKernels(const cl::Program &program)
+			: m_kernelFillUInt(program, "fillUInt"), m_kernelFillUChar(program, "fillUChar") { }
+	};
+
+	static KernelPool<FillKernels> s_fillKernels("fill.cl");
+
+
+	void DeviceController::enqueueFillBuffer(
+		const cl::Buffer &buffer,
+		const void *pattern,
+		size_t patternSize,
+		size_t offset,
+		size_t size,
+		const cl::vector<cl::Event> *events,
+		cl::Event *ev,
+		QueueId queue)
+	{
+		Profiler  *profiler = m_profiler;
+		cl::Event  evProfile;
+		cl::Event *pev = profilingEvent(profiler, ev, evProfile);
+
+		enqueueFill(buffer, pattern, patternSize, offset, size, events, pev, queue);
+
+		if(profiler != 0)
+			profiler->record(this, pcFill, "fill buffer", queue, size, *pev);
+	}
+
+
+	void DeviceController::enqueueFill(const cl::Buffer &buffer, const void *pattern, size_t patternSize, size_t offset, size_t size,
+		const cl::vector<cl::Event> *events, cl::Event *ev, QueueId queue)
+	{
+		if(size == 0) {
+			if(events != 0 && events->size() > 0)
+				m_queue[queue].enqueueWaitForEvents(*events);
+			if(ev != 0)
+				m_queue[queue].enqueueMarker(ev);
+			return;
+		}
+
+#ifdef CL_VERSION_1_2
+		if(m_versionNumber >= 120 && !m_forceFillKernel && patternSize <= 128 && (patternSize & (patternSize-1)) == 0) {
+			cl_uint  numEvents = (events != 0) ? (cl_uint)events->size() : 0;
+			cl_event tmp;
+
+			cl_int err = clEnqueueFillBuffer(m_queue[queue](), buffer(), pattern, patternSize, offset, size,
+				numEvents, (numEvents > 0) ? (cl_event *)&events->front() : 0, (ev != 0) ? &tmp : 0);
+			if(err != CL_SUCCESS)
+				throw cl::Error(err, "clEnqueueFillBuffer");
+
+			if(ev != 0)
+				*ev = tmp;
+			return;
+		}
+#endif
+
+		if(patternSize == 0 || patternSize > 64 || offset % patternSize != 0 || size % patternSize != 0)
+			throw Error("DeviceController::enqueueFillBuffer: pattern size not supported.", Error::ecDataTypeNotSupported);
+
+		cl_uint p[16];
+		memset(p, 0, sizeof(p));
+		memcpy(p, pattern, patternSize);
+
+		// 1- and 2-byte patterns can be filled by words if the range is aligned
+		size_t patternLen = patternSize;
+		if(patternSize < 4 && offset % 4 == 0 && size % 4 == 0) {
+			unsigned char *pb = (unsigned char *)p;
+			for(size_t i = patternSize; i < 4; ++i)
+				pb[i] = pb[i % patternSize];
+			patternLen = 4;
+		}
+
+		cl_uint16 vecPattern;
+		memcpy(&vecPattern, p, sizeof(p));
+
+		KernelPool<FillKernels>::Handle k = s_fillKernels.acquire(this);
+
+		if(patternLen % 4 == 0 && offset % 4 == 0 && size % 4 == 0) {
+			k->m_kernelFillUInt.setArg<cl::Buffer>(0, buffer);
+			k->m_kernelFillUInt.setArg<cl_uint>   (1, (cl_uint)(offset/4));
+			k->m_kernelFillUInt.setArg<cl_uint>   (2, (cl_uint)(size/4));
+			k->m_kernelFillUInt.setArg<cl_uint16> (3, vecPattern);
+			k->m_kernelFillUInt.setArg<cl_uint>   (4, (cl_uint)(patternLen/4));
+			m_queue[queue].enqueueNDRangeKernel(k->m_kernelFillUInt, cl::NullRange, cl::NDRange(size/4), cl::NullRange, events, ev);
+
+		} else {
+			k->m_kernelFillUChar.setArg<cl::Buffer>(0, buffer);
+			k->m_kernelFillUChar.setArg<cl_uint>   (1, (cl_uint)offset);
+			k->m_kernelFillUChar.setArg<cl_uint>   (2, (cl_uint)size);
+			k->m_kernelFillUChar.setArg<cl_uint16> (3, vecPattern);
+			k->m_kernelFillUChar.setArg<cl_uint>   (4, (cl_uint)patternLen);
+			m_queue[queue].enqueueNDRangeKernel(k->m_kernelFillUChar, cl::NullRange, cl::NDRange(size), cl::NullRange, events, ev);
+		}
+		m_counters->addKernels();
 	}
 
 
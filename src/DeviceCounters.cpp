@@ -0,0 +1,72 @@
+
+#include <tbt/DeviceCounters.h>
+
+using namespace std;
+
+
+namespace tbt
+{
+
+	//! Data passed to the destructor callback of a tracked buffer.
+	struct TrackedBuffer {
+		shared_ptr<DeviceCounters> m_counters;  //!< keeps the counters alive until the buffer is destroyed.
+		cl_ulong                   m_size;      //!< the tracked size in bytes.
+	};
+
+
+	DeviceCounters::DeviceCounters()
+		: m_bytesLoaded(0), m_bytesStored(0), m_bytesMapped(0), m_numKernels(0), m_liveBufferBytes(0), m_highWaterMark(0)
+	{
+	}
+
+
+	void CL_CALLBACK DeviceCounters::bufferDestroyed(cl_mem /*memObject*/, void *userData)
+	{
+		TrackedBuffer *tb = (TrackedBuffer *)userData;
+		tb->m_counters->releaseBuffer(tb->m_size);
+		delete tb;
+	}
+
+
+	void DeviceCounters::trackBuffer(const cl::Buffer &buffer, size_t size)
+	{
+		TrackedBuffer *tb = new TrackedBuffer;
+		tb->m_counters = shared_from_this();
+		tb->m_size     = size;
+
+		if(clSetMemObjectDestructorCallback(buffer(), bufferDestroyed, tb) != CL_SUCCESS) {
+			delete tb;
+			return;
+		}
+
+		cl_ulong live = m_liveBufferBytes.fetch_add(size, memory_order_relaxed) + size;
+
+		cl_ulong mark = m_highWaterMark.load(memory_order_relaxed);
+		while(live > mark && !m_highWaterMark.compare_exchange_weak(mark, live, memory_order_relaxed))
+			;
+	}
+
+
+	DeviceCounters::Values DeviceCounters::getValues() const
+	{
+		Values v;
+		v.m_bytesLoaded     = m_bytesLoaded    .load(memory_order_relaxed);
+		v.m_bytesStored     = m_bytesStored    .load(memory_order_relaxed);
+		v.m_bytesMapped     = m_bytesMapped    .load(memory_order_relaxed);
+		v.m_numKernels      = m_numKernels     .load(memory_order_relaxed);
+		v.m_liveBufferBytes = m_liveBufferBytes.load(memory_order_relaxed);
+		v.m_highWaterMark   = m_highWaterMark  .load(memory_order_relaxed);
+		return v;
+	}
+
+
+	void DeviceCounters::reset()
+	{
+		m_bytesLoaded.store(0, memory_order_relaxed);
+		m_bytesStored.store(0, memory_order_relaxed);
+		m_bytesMapped.store(0, memory_order_relaxed);
+		m_numKernels .store(0, memory_order_relaxed);
+		m_highWaterMark.store(m_liveBufferBytes.load(memory_order_relaxed), memory_order_relaxed);
+	}
+
+}
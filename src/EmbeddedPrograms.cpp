@@ -0,0 +1,38 @@
+
+#include <tbt/Utility.h>
+
+
+namespace tbt {
+
+#ifdef TBT_EMBED_KERNELS
+	// The included files are generated from kernels/*.cl during the build (see project files).
+	static const char s_sourceRadix[] = {
+#include "radix.cl.inc"
+		, 0
+	};
+
+	static const char s_sourceFill[] = {
+#include "fill.cl.inc"
+		, 0
+	};
+
+	static const char s_sourceCharacterize[] = {
+#include "characterize.cl.inc"
+		, 0
+	};
+#endif
+
+
+	void Utility::registerEmbeddedPrograms()
+	{
+#ifdef TBT_EMBED_KERNELS
+		if(findProgramSource("radix.cl") == 0)
+			registerProgramSource("radix.cl", s_sourceRadix, sizeof(s_sourceRadix)-1);
+		if(findProgramSource("fill.cl") == 0)
+			registerProgramSource("fill.cl", s_sourceFill, sizeof(s_sourceFill)-1);
+		if(findProgramSource("characterize.cl") == 0)
+			registerProgramSource("characterize.cl", s_sourceCharacterize, sizeof(s_sourceCharacterize)-1);
+#endif
+	}
+
+}
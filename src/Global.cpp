@@ -42,14 +42,35 @@ namespace tbt
 	}
 
 
+	//! Returns true if \a platform provides devices of type \a deviceType; CPUs and GPUs must both be present if both are requested.
+	static bool hasDevices(const cl::Platform &platform, cl_device_type deviceType)
+	{
+		const cl_device_type cpuGpu = CL_DEVICE_TYPE_CPU | CL_DEVICE_TYPE_GPU;
+
+		cl_device_type types[3] = { deviceType & CL_DEVICE_TYPE_CPU, deviceType & CL_DEVICE_TYPE_GPU, deviceType & ~cpuGpu };
+		if((deviceType & cpuGpu) == 0)
+			types[2] = deviceType;
+
+		for(int t = 0; t < 3; ++t) {
+			cl_uint numDevices = 0;
+			if(types[t] != 0 && (clGetDeviceIDs(platform(), types[t], 0, 0, &numDevices) != CL_SUCCESS || numDevices == 0))
+				return false;
+		}
+
+		return true;
+	}
+
+
 	cl::Platform getStdPlatform(cl_device_type deviceType)
 	{
-		// Get a AMD/GPU and Intel/CPU platform and context.
 		cl::vector< cl::Platform > platformList;
 		cl::Platform::get(&platformList);
 
-		int indexAMD = -1, indexIntel = -1, indexNvidia = -1;
+		int indexAMD = -1, indexIntel = -1, indexNvidia = -1, indexOther = -1;
 		for(int i = 0; i < (int)platformList.size(); ++i) {
+			if(!hasDevices(platformList[i], deviceType))
+				continue;
+
 			string platformName;
 			platformList[i].getInfo((cl_platform_info)CL_PLATFORM_NAME, &platformName);
 			if(platformName == "AMD Accelerated Parallel Processing")
@@ -58,23 +79,33 @@ namespace tbt
 				indexIntel = i;
 			else if(platformName == "NVIDIA CUDA")
 				indexNvidia = i;
+			else if(indexOther == -1)
+				indexOther = i;  // e.g., Portable Computing Language (pocl)
 		}
 
-		if((deviceType & (CL_DEVICE_TYPE_CPU | CL_DEVICE_TYPE_GPU)) == (CL_DEVICE_TYPE_CPU | CL_DEVICE_TYPE_GPU) && indexAMD == -1)
+		// prefer the vendor platforms, then take the first other platform with matching devices
+		if((deviceType & (CL_DEVICE_TYPE_CPU | CL_DEVICE_TYPE_GPU)) == (CL_DEVICE_TYPE_CPU | CL_DEVICE_TYPE_GPU)) {
+			if(indexAMD != -1)    return platformList[indexAMD];
+			if(indexOther != -1)  return platformList[indexOther];
 			throw Error("No OpenCL platform for CPUs and GPUs found!", Error::ecNoOpenCLPlatformFound);
-		
-		if(deviceType & CL_DEVICE_TYPE_GPU && indexAMD == -1 && indexNvidia == -1)
+
+		} else if(deviceType == CL_DEVICE_TYPE_GPU) {
+			if(indexAMD != -1)    return platformList[indexAMD];
+			if(indexNvidia != -1) return platformList[indexNvidia];
+			if(indexOther != -1)  return platformList[indexOther];
 			throw Error("No OpenCL platform for GPUs found!", Error::ecNoOpenCLPlatformFound);
-		
-		if(deviceType & CL_DEVICE_TYPE_CPU && indexAMD == -1 && indexIntel == -1)
+
+		} else if(deviceType == CL_DEVICE_TYPE_CPU) {
+			if(indexIntel != -1)  return platformList[indexIntel];
+			if(indexAMD != -1)    return platformList[indexAMD];
+			if(indexOther != -1)  return platformList[indexOther];
 			throw Error("No OpenCL platform for CPUs found!", Error::ecNoOpenCLPlatformFound);
+		}
 
-		if((deviceType & (CL_DEVICE_TYPE_CPU | CL_DEVICE_TYPE_GPU)) == (CL_DEVICE_TYPE_CPU | CL_DEVICE_TYPE_GPU))
-			return platformList[indexAMD];
-		else if(deviceType == CL_DEVICE_TYPE_GPU)
-			return platformList[(indexAMD != -1) ? indexAMD : indexNvidia];
-		else
-			return (indexIntel != -1) ? platformList[indexIntel] : platformList[indexAMD];
+		for(int i = 0; i < (int)platformList.size(); ++i)
+			if(hasDevices(platformList[i], deviceType))
+				return platformList[i];
+		throw Error("No OpenCL platform with devices of the requested type found!", Error::ecNoOpenCLPlatformFound);
 	}
 
 
@@ -124,10 +155,17 @@ namespace tbt
 			{
 			case CL_DEVICE_TYPE_CPU:
 				m_cpuDeviceIndex = i;
+				break;
 			case CL_DEVICE_TYPE_GPU:
 				m_gpuDeviceIndex = i;
+				break;
 			}
 		}
+
+		// measure while no commands compete for the devices
+		if(m_characterizeDevices)
+			for(int i = 0; i < m_devCons.numDevices(); ++i)
+				m_devCons[i]->characterize();
 	}
 
 
@@ -0,0 +1,228 @@
+
+#include <tbt/HostAllocator.h>
+#include <tbt/Utility.h>
+
+#include <new>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+
+using namespace std;
+
+
+namespace tbt
+{
+
+	//! Sets the memory [\a ptr, \a ptr + \a size) to zero using \a numThreads threads, each touching a contiguous part.
+	static void firstTouch(void *ptr, size_t size, int numThreads)
+	{
+		const size_t pageSize = Utility::getPageSize();
+		size_t chunk = (size / numThreads + pageSize - 1) / pageSize * pageSize;
+
+		vector<thread> threads;
+		for(int i = 1; i < numThreads && i*chunk < size; ++i) {
+			char *p = (char *)ptr + i*chunk;
+			size_t n = (size - i*chunk < chunk) ? size - i*chunk : chunk;
+			threads.push_back(thread([p,n]() { memset(p, 0, n); }));
+		}
+
+		memset(ptr, 0, (chunk < size) ? chunk : size);
+
+		for(size_t i = 0; i < threads.size(); ++i)
+			threads[i].join();
+	}
+
+
+	//! Returns the number of bytes actually mapped for an allocation of \a size bytes with \a policy.
+	static size_t mappedSize(size_t size, const HostAllocPolicy &policy)
+	{
+		size_t pageSize = Utility::getPageSize();
+		if(policy.m_kind == hmHugePages && HostAllocator::getHugePageSize() > 0)
+			pageSize = HostAllocator::getHugePageSize();
+
+		return (size + pageSize - 1) / pageSize * pageSize;
+	}
+
+
+#ifdef _WIN32
+
+	size_t HostAllocator::getHugePageSize()
+	{
+		return GetLargePageMinimum();
+	}
+
+
+	int HostAllocator::getNumNumaNodes()
+	{
+		ULONG highestNode;
+		if(!GetNumaHighestNodeNumber(&highestNode))
+			return 1;
+		return (int)highestNode + 1;
+	}
+
+
+	//! Allocates \a size bytes (a multiple of the page size) with VirtualAlloc.
+	static void *allocatePages(size_t size, DWORD flags, int numaNode)
+	{
+		if(numaNode >= 0)
+			return VirtualAllocExNuma(GetCurrentProcess(), 0, size, flags, PAGE_READWRITE, (DWORD)numaNode);
+		else
+			return VirtualAlloc(0, size, flags, PAGE_READWRITE);
+	}
+
+
+	void *HostAllocator::allocate(size_t size, const HostAllocPolicy &policy)
+	{
+		if(size == 0)
+			return 0;
+
+		void *ptr = 0;
+		if(!policy.usesPages()) {
+			ptr = Utility::alignedMalloc(size, 64);
+
+		} else {
+			size_t n = mappedSize(size, policy);
+
+			// large pages require the SeLockMemoryPrivilege; fall back to normal pages
+			if(policy.m_kind == hmHugePages && getHugePageSize() > 0)
+				ptr = allocatePages(n, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, policy.m_numaNode);
+			if(ptr == 0)
+				ptr = allocatePages(n, MEM_RESERVE | MEM_COMMIT, policy.m_numaNode);
+		}
+
+		if(ptr == 0)
+			throw bad_alloc();
+
+		if(policy.m_firstTouchThreads > 0)
+			firstTouch(ptr, size, policy.m_firstTouchThreads);
+
+		return ptr;
+	}
+
+
+	void HostAllocator::deallocate(void *ptr, size_t size, const HostAllocPolicy &policy)
+	{
+		if(ptr == 0)
+			return;
+
+		if(!policy.usesPages())
+			Utility::alignedFree(ptr);
+		else
+			VirtualFree(ptr, 0, MEM_RELEASE);
+	}
+
+#else
+
+	size_t HostAllocator::getHugePageSize()
+	{
+		static size_t hugePageSize = (size_t)-1;
+
+		if(hugePageSize == (size_t)-1) {
+			hugePageSize = 0;
+#ifdef __linux__
+			ifstream is("/proc/meminfo");
+			string key;
+			while(is >> key) {
+				if(key == "Hugepagesize:") {
+					size_t kb;
+					if(is >> kb)
+						hugePageSize = 1024*kb;
+					break;
+				}
+				is.ignore(256, '\n');
+			}
+#endif
+		}
+
+		return hugePageSize;
+	}
+
+
+	int HostAllocator::getNumNumaNodes()
+	{
+#ifdef __linux__
+		// the file contains the range of possible nodes, e.g. "0-1"
+		ifstream is("/sys/devices/system/node/possible");
+		string range;
+		if(is >> range) {
+			size_t pos = range.find_last_of("-,");
+			return atoi(range.c_str() + ((pos == string::npos) ? 0 : pos+1)) + 1;
+		}
+#endif
+		return 1;
+	}
+
+
+	void *HostAllocator::allocate(size_t size, const HostAllocPolicy &policy)
+	{
+		if(size == 0)
+			return 0;
+
+		void *ptr = 0;
+		if(!policy.usesPages()) {
+			ptr = Utility::alignedMalloc(size, 64);
+			if(ptr == 0)
+				throw bad_alloc();
+
+		} else {
+			size_t n = mappedSize(size, policy);
+			ptr = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+			if(policy.m_kind == hmHugePages && getHugePageSize() > 0)
+				ptr = mmap(0, n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+			if(ptr == MAP_FAILED) {
+				// no reserved huge pages; fall back to normal pages, possibly promoted to transparent huge pages
+				ptr = mmap(0, n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+				if(ptr == MAP_FAILED)
+					throw bad_alloc();
+#ifdef MADV_HUGEPAGE
+				if(policy.m_kind == hmHugePages)
+					madvise(ptr, n, MADV_HUGEPAGE);
+#endif
+			}
+
+#if defined(__linux__) && defined(SYS_mbind)
+			if(policy.m_numaNode >= 0 && policy.m_numaNode < 8*(int)sizeof(unsigned long)) {
+				// bind pages to the node (MPOL_BIND); binding is a hint, hence failures are ignored
+				const int mpolBind = 2;
+				unsigned long nodeMask = 1UL << policy.m_numaNode;
+				syscall(SYS_mbind, ptr, n, mpolBind, &nodeMask, 8*sizeof(nodeMask)+1, 0);
+			}
+#endif
+		}
+
+		if(policy.m_firstTouchThreads > 0)
+			firstTouch(ptr, size, policy.m_firstTouchThreads);
+
+		return ptr;
+	}
+
+
+	void HostAllocator::deallocate(void *ptr, size_t size, const HostAllocPolicy &policy)
+	{
+		if(ptr == 0)
+			return;
+
+		if(!policy.usesPages())
+			Utility::alignedFree(ptr);
+		else
+			munmap(ptr, mappedSize(size, policy));
+	}
+
+#endif
+
+}
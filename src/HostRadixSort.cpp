@@ -0,0 +1,140 @@
+#include <tbt/HostRadixSort.h>
+#include <tbt/Timer.h>
+
+#include <algorithm>
+#include <string.h>
+
+
+#define RADIX 8
+#define BASE (1 << RADIX)
+#define MASK (BASE - 1)
+
+#define MIN_BLOCK_SIZE (1 << 14)   // smallest number of keys per thread
+#define STAGING_SIZE   16          // keys staged per digit before writing (one 64-byte cache line)
+
+
+using namespace std;
+
+
+namespace tbt
+{
+
+	//! Adds the counts of the digits at \a shift of the \a n keys starting at \a src to \a count.
+	/**
+	 * Four separate histograms are used for consecutive keys, so that increments of the same counter do
+	 * not depend on each other and the loop can be pipelined.
+	 */
+	static void countDigits(const cl_uint *src, size_t n, cl_uint shift, size_t *count)
+	{
+		size_t c[4][BASE];
+		memset(c, 0, sizeof(c));
+
+		size_t i = 0;
+		for(; i + 4 <= n; i += 4) {
+			++c[0][(src[i  ] >> shift) & MASK];
+			++c[1][(src[i+1] >> shift) & MASK];
+			++c[2][(src[i+2] >> shift) & MASK];
+			++c[3][(src[i+3] >> shift) & MASK];
+		}
+		for(; i < n; ++i)
+			++c[0][(src[i] >> shift) & MASK];
+
+		for(int d = 0; d < BASE; ++d)
+			count[d] = c[0][d] + c[1][d] + c[2][d] + c[3][d];
+	}
+
+
+	//! Moves the \a n keys starting at \a src to \a tgt at the positions \a pos of their digits at \a shift (stable).
+	/**
+	 * Keys are staged per digit and written in chunks of a cache line, which avoids scattered single writes.
+	 */
+	static void scatterKeys(const cl_uint *src, size_t n, cl_uint shift, size_t *pos, cl_uint *tgt)
+	{
+		cl_uint staged[BASE][STAGING_SIZE];
+		int     numStaged[BASE];
+		memset(numStaged, 0, sizeof(numStaged));
+
+		for(size_t i = 0; i < n; ++i) {
+			cl_uint key = src[i];
+			cl_uint d = (key >> shift) & MASK;
+
+			staged[d][numStaged[d]++] = key;
+			if(numStaged[d] == STAGING_SIZE) {
+				memcpy(tgt + pos[d], staged[d], STAGING_SIZE*sizeof(cl_uint));
+				pos[d] += STAGING_SIZE;
+				numStaged[d] = 0;
+			}
+		}
+
+		for(int d = 0; d < BASE; ++d) {
+			memcpy(tgt + pos[d], staged[d], numStaged[d]*sizeof(cl_uint));
+			pos[d] += numStaged[d];
+		}
+	}
+
+
+	void HostRadixSort::run(cl_uint *data, size_t n)
+	{
+		Timer timer;
+
+		if(n <= 1) {
+			m_hostTime = timer.elapsed();
+			return;
+		}
+
+		const size_t numBlocks = max((size_t)1, min(n / MIN_BLOCK_SIZE, (size_t)m_pool->numThreads()));
+		const size_t blockSize = (n + numBlocks - 1) / numBlocks;
+
+		if(m_buffer.size() < n)
+			m_buffer.resize(n);
+		m_counts.resize(numBlocks * BASE);
+
+		cl_uint *src = data;
+		cl_uint *tgt = &m_buffer[0];
+
+		for(cl_uint shift = 0; shift < 32; shift += RADIX)
+		{
+			m_pool->parallelFor(numBlocks, [&](size_t b) {
+				size_t first = min(b * blockSize, n);
+				size_t last  = min(first + blockSize, n);
+				countDigits(src + first, last - first, shift, &m_counts[b * BASE]);
+			});
+
+			// exclusive prefix sum in digit-major order gives the target position of each block's first key per digit
+			size_t sum = 0;
+			bool skipPass = false;
+			for(int d = 0; d < BASE && !skipPass; ++d) {
+				size_t digitSum = 0;
+				for(size_t b = 0; b < numBlocks; ++b) {
+					size_t c = m_counts[b * BASE + d];
+					m_counts[b * BASE + d] = sum + digitSum;
+					digitSum += c;
+				}
+				skipPass = (digitSum == n);  // all keys have digit d, so the pass would not change the order
+				sum += digitSum;
+			}
+			if(skipPass)
+				continue;
+
+			m_pool->parallelFor(numBlocks, [&](size_t b) {
+				size_t first = min(b * blockSize, n);
+				size_t last  = min(first + blockSize, n);
+				scatterKeys(src + first, last - first, shift, &m_counts[b * BASE], tgt);
+			});
+
+			std::swap(src, tgt);
+		}
+
+		// an odd number of passes leaves the result in the temporary array
+		if(src != data) {
+			m_pool->parallelFor(numBlocks, [&](size_t b) {
+				size_t first = min(b * blockSize, n);
+				size_t last  = min(first + blockSize, n);
+				memcpy(data + first, src + first, (last - first)*sizeof(cl_uint));
+			});
+		}
+
+		m_hostTime = timer.elapsed();
+	}
+
+}
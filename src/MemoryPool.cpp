@@ -0,0 +1,240 @@
+
+#include <tbt/MemoryPool.h>
+#include <tbt/DeviceCounters.h>
+
+using namespace std;
+
+
+namespace tbt
+{
+
+	//! Returns true if all events in \a events have completed (or terminated abnormally).
+	static bool isComplete(const cl::vector<cl::Event> &events)
+	{
+		for(size_t i = 0; i < events.size(); ++i)
+			if(events[i].getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() > CL_COMPLETE)
+				return false;
+
+		return true;
+	}
+
+
+	MemoryPool::MemoryPool(const cl::Context &context, size_t maxBufferSize, DeviceCounters *counters,
+		const cl::CommandQueue *queues, size_t numQueues)
+		: m_context(context), m_counters(counters),
+		  m_maxBufferSize(maxBufferSize), m_enabled(true), m_maxCachedBytes(~(cl_ulong)0), m_numUnfenced(0)
+	{
+		for(size_t i = 0; i < numQueues; ++i)
+			if(queues[i]() != 0)
+				m_queues.push_back(queues[i]);
+
+		m_stats.m_numHits = m_stats.m_numMisses = 0;
+		m_stats.m_numCachedBuffers = m_stats.m_numBuffersInUse = 0;
+		m_stats.m_bytesCached = m_stats.m_bytesInUse = 0;
+	}
+
+
+	size_t MemoryPool::sizeClass(size_t size)
+	{
+		const size_t minSize = 256;
+		if(size <= minSize)
+			return minSize;
+
+		// four size classes per power of two
+		size_t highBit = 1;
+		while((highBit << 1) <= size-1)
+			highBit <<= 1;
+
+		size_t step = highBit >> 2;
+		return (size + step - 1) & ~(step - 1);
+	}
+
+
+	MemoryPool::CacheIterator MemoryPool::findReusable(const Key &key)
+	{
+		pair<CacheIterator,CacheIterator> range = m_cache.equal_range(key);
+
+		// only buffers whose markers have completed are no longer used by any command
+		bool unfenced = false;
+		for(CacheIterator it = range.first; it != range.second; ++it) {
+			if(!it->second.m_fenced)
+				unfenced = true;
+			else if(isComplete(it->second.m_fences))
+				return it;
+		}
+
+		// markers enqueued now also cover the buffers released before; the queues may be idle already
+		if(unfenced) {
+			fenceReleased();
+			for(CacheIterator it = range.first; it != range.second; ++it)
+				if(isComplete(it->second.m_fences))
+					return it;
+		}
+
+		return m_cache.end();
+	}
+
+
+	void MemoryPool::fenceReleased()
+	{
+		// a marker completes when all commands enqueued to its queue before have completed (also for
+		// out-of-order queues); the queues are flushed, so that the markers are eventually executed
+		cl::vector<cl::Event> fences;
+		for(size_t i = 0; i < m_queues.size(); ++i) {
+			cl::Event ev;
+			m_queues[i].enqueueMarker(&ev);
+			m_queues[i].flush();
+			fences.push_back(ev);
+		}
+
+		for(CacheIterator it = m_cache.begin(); it != m_cache.end() && m_numUnfenced > 0; ++it) {
+			if(!it->second.m_fenced) {
+				it->second.m_fences = fences;
+				it->second.m_fenced = true;
+				m_numUnfenced--;
+			}
+		}
+	}
+
+
+	void MemoryPool::fence()
+	{
+		lock_guard<mutex> lock(m_mutex);
+		if(m_numUnfenced > 0)
+			fenceReleased();
+	}
+
+
+	shared_ptr<MemoryPool::Lease> MemoryPool::allocate(size_t size, cl_mem_flags flags)
+	{
+		size_t bufferSize = sizeClass(size);
+		if(bufferSize > m_maxBufferSize)
+			bufferSize = size;
+
+		cl::Buffer buffer;
+		{
+			lock_guard<mutex> lock(m_mutex);
+
+			CacheIterator it = findReusable(Key(flags,bufferSize));
+			if(it != m_cache.end()) {
+				buffer = it->second.m_buffer;
+				m_cache.erase(it);
+
+				m_stats.m_numHits++;
+				m_stats.m_numCachedBuffers--;
+				m_stats.m_bytesCached -= bufferSize;
+
+			} else
+				m_stats.m_numMisses++;
+
+			m_stats.m_numBuffersInUse++;
+			m_stats.m_bytesInUse += bufferSize;
+		}
+
+		if(buffer() == 0) {
+			try {
+				buffer = cl::Buffer(m_context, flags, bufferSize);
+
+			} catch(cl::Error) {
+				// allocation may fail because of cached buffers; release them and try again
+				trim();
+				try {
+					buffer = cl::Buffer(m_context, flags, bufferSize);
+				} catch(...) {
+					lock_guard<mutex> lock(m_mutex);
+					m_stats.m_numBuffersInUse--;
+					m_stats.m_bytesInUse -= bufferSize;
+					throw;
+				}
+			}
+
+			if(m_counters != 0)
+				m_counters->trackBuffer(buffer, bufferSize);
+		}
+
+		return shared_ptr<Lease>(new Lease(shared_from_this(), buffer, flags, bufferSize));
+	}
+
+
+	void MemoryPool::release(const cl::Buffer &buffer, cl_mem_flags flags, size_t size)
+	{
+		lock_guard<mutex> lock(m_mutex);
+
+		m_stats.m_numBuffersInUse--;
+		m_stats.m_bytesInUse -= size;
+
+		// the buffer itself is released by the OpenCL runtime when no pending command uses it anymore
+		if(!m_enabled || m_stats.m_bytesCached + size > m_maxCachedBytes)
+			return;
+
+		// called by destructors, so a buffer that cannot be cached is just released
+		try {
+			CachedBuffer cached;
+			cached.m_buffer = buffer;
+			cached.m_fenced = m_queues.empty();
+
+			m_cache.insert(make_pair(Key(flags,size), cached));
+			if(!cached.m_fenced)
+				m_numUnfenced++;
+			m_stats.m_numCachedBuffers++;
+			m_stats.m_bytesCached += size;
+
+		} catch(...) { }
+	}
+
+
+	void MemoryPool::trim(cl_ulong maxCachedBytes)
+	{
+		lock_guard<mutex> lock(m_mutex);
+
+		// release largest buffers first
+		while(m_stats.m_bytesCached > maxCachedBytes) {
+			multimap<Key,CachedBuffer>::iterator itLargest = m_cache.begin();
+			for(multimap<Key,CachedBuffer>::iterator it = m_cache.begin(); it != m_cache.end(); ++it)
+				if(it->first.second > itLargest->first.second)
+					itLargest = it;
+
+			if(!itLargest->second.m_fenced)
+				m_numUnfenced--;
+			m_stats.m_numCachedBuffers--;
+			m_stats.m_bytesCached -= itLargest->first.second;
+			m_cache.erase(itLargest);
+		}
+	}
+
+
+	MemoryPool::Statistics MemoryPool::getStatistics() const
+	{
+		lock_guard<mutex> lock(m_mutex);
+		return m_stats;
+	}
+
+
+	void MemoryPool::resetStatistics()
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stats.m_numHits = m_stats.m_numMisses = 0;
+	}
+
+
+	void MemoryPool::setEnabled(bool b)
+	{
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_enabled = b;
+		}
+		if(!b)
+			trim();
+	}
+
+
+	void MemoryPool::setMaxCachedBytes(cl_ulong maxBytes)
+	{
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_maxCachedBytes = maxBytes;
+		}
+		trim(maxBytes);
+	}
+
+}
@@ -22,22 +22,6 @@ namespace tbt {
 	}
 
 
-	void Module::startTimer()
-	{
-		QueryPerformanceCounter(&m_timer);
-	}
-
-
-	double Module::readTimer()
-	{
-		LARGE_INTEGER curTimer, frequeny;
-		QueryPerformanceCounter(&curTimer);
-		QueryPerformanceFrequency(&frequeny);
-
-		return 1e3 * double(curTimer.QuadPart - m_timer.QuadPart) / frequeny.QuadPart;
-	}
-
-
 	void Module::buildProgramFromSourceRel(const char *progName, cl_uint requiredExt, cl_uint optionalExt)
 	{
 		s_program = Utility::buildProgram(progName, requiredExt, optionalExt);
@@ -0,0 +1,257 @@
+
+#include <tbt/Profiler.h>
+#include <tbt/Utility.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+
+using namespace std;
+
+
+namespace tbt
+{
+
+	const char *Profiler::getCategoryName(ProfileCategory category)
+	{
+		switch(category) {
+		case pcKernel:   return "kernel";
+		case pcUpload:   return "upload";
+		case pcDownload: return "download";
+		case pcCopy:     return "copy";
+		case pcFill:     return "fill";
+		case pcMap:      return "map";
+		case pcUnmap:    return "unmap";
+		default:
+			return "unknown";
+		}
+	}
+
+
+	void Profiler::record(const DeviceController *devCon, ProfileCategory category, const std::string &name,
+		QueueId queue, cl_ulong bytes, const cl::Event &ev)
+	{
+		Pending p;
+		p.m_record.m_name     = name;
+		p.m_record.m_category = category;
+		p.m_record.m_device   = devCon->getDevice();
+		p.m_record.m_queue    = queue;
+		p.m_record.m_bytes    = bytes;
+		p.m_record.m_queued = p.m_record.m_submit = p.m_record.m_start = p.m_record.m_end = 0;
+		p.m_event = ev;
+
+		lock_guard<mutex> lock(m_mutex);
+		m_pending.push_back(p);
+
+		if(m_pending.size() >= m_drainAt) {
+			resolveCompleted();
+			m_drainAt = max<size_t>(1024, 2*m_pending.size());
+		}
+	}
+
+
+	void Profiler::resolve(Pending &p)
+	{
+		try {
+			p.m_event.wait();
+			p.m_record.m_queued = p.m_event.getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>();
+			p.m_record.m_submit = p.m_event.getProfilingInfo<CL_PROFILING_COMMAND_SUBMIT>();
+			p.m_record.m_start  = p.m_event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+			p.m_record.m_end    = p.m_event.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+
+		} catch(cl::Error) {
+			// profiling not enabled for the command queue
+			++m_numDropped;
+			return;
+		}
+
+		m_records.push_back(p.m_record);
+	}
+
+
+	void Profiler::resolve()
+	{
+		for(size_t i = 0; i < m_pending.size(); ++i)
+			resolve(m_pending[i]);
+
+		m_pending.clear();
+	}
+
+
+	void Profiler::resolveCompleted()
+	{
+		// only a completed prefix is resolved, which keeps the records in recording order
+		size_t numCompleted = 0;
+		for(; numCompleted < m_pending.size(); ++numCompleted) {
+			cl_int status;
+			try {
+				status = m_pending[numCompleted].m_event.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>();
+			} catch(cl::Error) {
+				status = CL_COMPLETE;
+			}
+
+			if(status > CL_COMPLETE)
+				break;
+			resolve(m_pending[numCompleted]);
+		}
+
+		m_pending.erase(m_pending.begin(), m_pending.begin() + numCompleted);
+	}
+
+
+	vector<Profiler::Record> Profiler::getRecords()
+	{
+		lock_guard<mutex> lock(m_mutex);
+		resolve();
+		return m_records;
+	}
+
+
+	size_t Profiler::numDropped()
+	{
+		lock_guard<mutex> lock(m_mutex);
+		resolve();
+		return m_numDropped;
+	}
+
+
+	void Profiler::clear()
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_pending.clear();
+		m_records.clear();
+		m_numDropped = 0;
+		m_drainAt = 1024;
+	}
+
+
+	ostream &Profiler::printSummary(ostream &os)
+	{
+		struct Summary {
+			size_t   m_count;
+			double   m_time;
+			cl_ulong m_bytes;
+		};
+
+		map<string,Summary> summary;
+		{
+			lock_guard<mutex> lock(m_mutex);
+			resolve();
+
+			for(size_t i = 0; i < m_records.size(); ++i) {
+				const Record &r = m_records[i];
+				string key = string(getCategoryName(r.m_category)) + " " + r.m_name;
+
+				map<string,Summary>::iterator it = summary.find(key);
+				if(it == summary.end()) {
+					Summary s = { 0, 0.0, 0 };
+					it = summary.insert(make_pair(key, s)).first;
+				}
+				it->second.m_count++;
+				it->second.m_time  += r.time();
+				it->second.m_bytes += r.m_bytes;
+			}
+		}
+
+		ios_base::fmtflags flags = os.flags();
+		streamsize precision = os.precision();
+
+		os << left  << setw(40) << "command"
+		   << right << setw(8)  << "calls"
+		   << setw(14) << "total [ms]"
+		   << setw(14) << "avg [ms]"
+		   << setw(14) << "GB/s" << endl;
+
+		for(map<string,Summary>::const_iterator it = summary.begin(); it != summary.end(); ++it) {
+			const Summary &s = it->second;
+			os << left  << setw(40) << it->first
+			   << right << setw(8)  << s.m_count
+			   << fixed << setprecision(3)
+			   << setw(14) << s.m_time
+			   << setw(14) << s.m_time / s.m_count;
+			if(s.m_bytes > 0 && s.m_time > 0.0)
+				os << setw(14) << 1.e-6 * s.m_bytes / s.m_time;
+			os << endl;
+		}
+
+		os.flags(flags);
+		os.precision(precision);
+		return os;
+	}
+
+
+	void Profiler::writeChromeTrace(ostream &os)
+	{
+		static const char *queueNames[TBT_NUM_QUEUES] = { "compute", "upload", "download" };
+
+		lock_guard<mutex> lock(m_mutex);
+		resolve();
+
+		// each device is a process; timestamps are relative to the earliest command
+		vector<cl::Device> devices;
+		vector<size_t> pids(m_records.size());
+		cl_ulong base = ~(cl_ulong)0;
+		for(size_t i = 0; i < m_records.size(); ++i) {
+			const Record &r = m_records[i];
+			size_t pid = 0;
+			while(pid < devices.size() && devices[pid]() != r.m_device())
+				++pid;
+			if(pid == devices.size())
+				devices.push_back(r.m_device);
+			pids[i] = pid;
+			base = min(base, r.m_queued);
+		}
+
+		ios_base::fmtflags flags = os.flags();
+		streamsize precision = os.precision();
+
+		os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" << endl;
+		os << fixed << setprecision(3);
+
+		bool first = true;
+		for(size_t pid = 0; pid < devices.size(); ++pid) {
+			os << (first ? "" : ",\n") << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"args\":{\"name\":";
+			string name;
+			devices[pid].getInfo(CL_DEVICE_NAME, &name);
+			Utility::writeJSONString(os, name);
+			os << "}}";
+			first = false;
+
+			for(int q = 0; q < TBT_NUM_QUEUES; ++q)
+				os << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << q
+				   << ",\"args\":{\"name\":\"" << queueNames[q] << "\"}}";
+		}
+
+		for(size_t i = 0; i < m_records.size(); ++i) {
+			const Record &r = m_records[i];
+
+			os << (first ? "" : ",\n") << "{\"name\":";
+			Utility::writeJSONString(os, r.m_name);
+			os << ",\"cat\":\"" << getCategoryName(r.m_category) << "\",\"ph\":\"X\""
+			   << ",\"pid\":" << pids[i] << ",\"tid\":" << (int)r.m_queue
+			   << ",\"ts\":"  << 1.e-3 * (r.m_start - base)
+			   << ",\"dur\":" << 1.e-3 * (r.m_end - r.m_start)
+			   << ",\"args\":{\"bytes\":" << r.m_bytes
+			   << ",\"queued\":" << 1.e-3 * (r.m_queued - base)
+			   << ",\"submit\":" << 1.e-3 * (r.m_submit - base) << "}}";
+			first = false;
+		}
+
+		os << endl << "]}" << endl;
+
+		os.flags(flags);
+		os.precision(precision);
+	}
+
+
+	void Profiler::writeChromeTrace(const std::string &fileName)
+	{
+		ofstream os(fileName.c_str());
+		if(!os)
+			throw Error("Profiler::writeChromeTrace: cannot open file " + fileName, Error::ecUnknown);
+
+		writeChromeTrace(os);
+	}
+
+}
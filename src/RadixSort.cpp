@@ -24,46 +24,36 @@ using namespace std;
 namespace tbt
 {
 	
-	cl::Kernel RadixSort::m_kernelCounting;
-	cl::Kernel RadixSort::m_kernelPermute;
-	
-	cl::Kernel RadixSort::m_kernelPrescanSum;
-	cl::Kernel RadixSort::m_kernelPrescan;
-	cl::Kernel RadixSort::m_kernelPrescanWithOffset;
+	KernelPool<RadixSort::Kernels> RadixSort::s_kernelPool("radix.cl"/*, TBT_EXT_PRINTF*/);
 
-	cl::Kernel RadixSort::m_kernelPrescanUpSweep;
-	cl::Kernel RadixSort::m_kernelPrescanDownSweep;
 
-	cl::Kernel RadixSort::m_kernelPrescanReduce;
-	cl::Kernel RadixSort::m_kernelPrescanLocal;
-	cl::Kernel RadixSort::m_kernelPrescanLocal64;
-	cl::Kernel RadixSort::m_kernelPrescanBottom;
-	cl::Kernel RadixSort::m_kernelTester;
+	//! Sets \a waitList to the single event \a ev and returns a pointer to it (for passing as event wait list).
+	static const cl::vector<cl::Event> *waitFor(cl::vector<cl::Event> &waitList, const cl::Event &ev)
+	{
+		waitList.clear();
+		waitList.push_back(ev);
+		return &waitList;
+	}
 
-	
-	void RadixSort::assureKernelsLoaded()
+
+	RadixSort::Kernels::Kernels(const cl::Program &program)
 	{
-		if(!isProgramLoaded()) {
-			buildProgramFromSourceRel("radix.cl"/*, TBT_EXT_PRINTF*/);
-
-			// create kernels
-			m_kernelPrescanReduce = createKernel("prescanReduce");
-			m_kernelPrescanLocal = createKernel("prescanLocal");
-			m_kernelPrescanLocal64 = createKernel("prescanLocal64");
-			m_kernelPrescanBottom = createKernel("prescanBottom");
-			m_kernelTester = createKernel("tester");
-
-			m_kernelCounting = createKernel("radixCounting_gpu");
-			//m_kernelCounting = createKernel("radixCounting_gpu_atomic");
-			m_kernelPermute  = createKernel("radixPermute_gpu");
-
-			m_kernelPrescanSum        = createKernel("prescanSum4");
-			m_kernelPrescan           = createKernel("prescan_gpu");
-			m_kernelPrescanWithOffset = createKernel("prescanWithOffset");
-
-			m_kernelPrescanUpSweep   = createKernel("prescanUpSweep_gpu");
-			m_kernelPrescanDownSweep = createKernel("prescanDownSweep_gpu");
-		}
+		m_kernelPrescanReduce = cl::Kernel(program, "prescanReduce");
+		m_kernelPrescanLocal = cl::Kernel(program, "prescanLocal");
+		m_kernelPrescanLocal64 = cl::Kernel(program, "prescanLocal64");
+		m_kernelPrescanBottom = cl::Kernel(program, "prescanBottom");
+		m_kernelTester = cl::Kernel(program, "tester");
+
+		m_kernelCounting = cl::Kernel(program, "radixCounting_gpu");
+		//m_kernelCounting = cl::Kernel(program, "radixCounting_gpu_atomic");
+		m_kernelPermute  = cl::Kernel(program, "radixPermute_gpu");
+
+		m_kernelPrescanSum        = cl::Kernel(program, "prescanSum4");
+		m_kernelPrescan           = cl::Kernel(program, "prescan_gpu");
+		m_kernelPrescanWithOffset = cl::Kernel(program, "prescanWithOffset");
+
+		m_kernelPrescanUpSweep   = cl::Kernel(program, "prescanUpSweep_gpu");
+		m_kernelPrescanDownSweep = cl::Kernel(program, "prescanDownSweep_gpu");
 	}
 
 
@@ -72,17 +62,17 @@ namespace tbt
 		const cl_uint m = n / C;
 		const cl_uint s = 256;
 
-		assureKernelsLoaded();
+		KernelPool<Kernels>::Handle k = s_kernelPool.acquire(a.getDeviceController());
 
-		m_kernelPrescanReduce.setArg<cl::Buffer>(0, a);
-		m_kernelPrescanReduce.setArg<cl::Buffer>(1, sum);
-		m_kernelPrescanReduce.setArg<cl_uint>   (2, m);
-		m_kernelPrescanReduce.setArg<cl_uint>   (3, n);
+		k->m_kernelPrescanReduce.setArg<cl::Buffer>(0, a);
+		k->m_kernelPrescanReduce.setArg<cl::Buffer>(1, sum);
+		k->m_kernelPrescanReduce.setArg<cl_uint>   (2, m);
+		k->m_kernelPrescanReduce.setArg<cl_uint>   (3, n);
 
 		DeviceController *devCon = a.getDeviceController();
 		cl::Event ev;
 
-		devCon->enqueue1DRangeKernel(m_kernelPrescanReduce, C*s, s, 0, &ev);
+		devCon->enqueue1DRangeKernel(k->m_kernelPrescanReduce, C*s, s, 0, &ev);
 		ev.wait();
 
 		return getEventTime(ev);
@@ -91,20 +81,20 @@ namespace tbt
 	
 	double RadixSort::testKernelPrescanLocal(DeviceArray<cl_uint> &sum, cl_uint C)
 	{
-		assureKernelsLoaded();
-		
+		KernelPool<Kernels>::Handle k = s_kernelPool.acquire(sum.getDeviceController());
+
 		DeviceController *devCon = sum.getDeviceController();
 		cl::Event ev;
 
-		bool simd64 = ( devCon->getType() == CL_DEVICE_TYPE_GPU ) && ( devCon->getWGSizeMultiple1D(m_kernelPrescanLocal) >= 64 );
+		bool simd64 = ( devCon->getType() == CL_DEVICE_TYPE_GPU ) && ( devCon->getWGSizeMultiple1D(k->m_kernelPrescanLocal) >= 64 );
 		size_t lw = C/4;
 
 		if(lw == 64 && simd64) {
-			m_kernelPrescanLocal64.setArg<cl::Buffer>(0, sum);
-			devCon->enqueue1DRangeKernel(m_kernelPrescanLocal64, lw, lw, 0, &ev);
+			k->m_kernelPrescanLocal64.setArg<cl::Buffer>(0, sum);
+			devCon->enqueue1DRangeKernel(k->m_kernelPrescanLocal64, lw, lw, 0, &ev);
 		} else {
-			m_kernelPrescanLocal.setArg<cl::Buffer>(0, sum);
-			devCon->enqueue1DRangeKernel(m_kernelPrescanLocal, lw, lw, 0, &ev);
+			k->m_kernelPrescanLocal.setArg<cl::Buffer>(0, sum);
+			devCon->enqueue1DRangeKernel(k->m_kernelPrescanLocal, lw, lw, 0, &ev);
 		}
 		ev.wait();
 
@@ -117,17 +107,17 @@ namespace tbt
 		const cl_uint m = n / C;
 		const cl_uint s = 256;
 
-		assureKernelsLoaded();
+		KernelPool<Kernels>::Handle k = s_kernelPool.acquire(a.getDeviceController());
 
-		m_kernelPrescanBottom.setArg<cl::Buffer>(0, a);
-		m_kernelPrescanBottom.setArg<cl::Buffer>(1, sum);
-		m_kernelPrescanBottom.setArg<cl_uint>   (2, m);
-		m_kernelPrescanBottom.setArg<cl_uint>   (3, n);
+		k->m_kernelPrescanBottom.setArg<cl::Buffer>(0, a);
+		k->m_kernelPrescanBottom.setArg<cl::Buffer>(1, sum);
+		k->m_kernelPrescanBottom.setArg<cl_uint>   (2, m);
+		k->m_kernelPrescanBottom.setArg<cl_uint>   (3, n);
 
 		DeviceController *devCon = a.getDeviceController();
 		cl::Event ev;
 
-		devCon->enqueue1DRangeKernel(m_kernelPrescanBottom, C*s, s, 0, &ev);
+		devCon->enqueue1DRangeKernel(k->m_kernelPrescanBottom, C*s, s, 0, &ev);
 		ev.wait();
 
 		return getEventTime(ev);
@@ -139,187 +129,235 @@ namespace tbt
 		const cl_uint m = n / C;
 		const cl_uint s = 256;
 
-		//buildProgramFromSourceRel("radix.cl"/*, TBT_EXT_PRINTF*/);
-		//cl::Kernel kernel = createKernel("prescanReduce");
-		assureKernelsLoaded();
+		KernelPool<Kernels>::Handle k = s_kernelPool.acquire(a.getDeviceController());
 
-		m_kernelTester.setArg<cl::Buffer>(0, a);
-		m_kernelTester.setArg<cl::Buffer>(1, sum);
-		m_kernelTester.setArg<cl_uint>   (2, m);
-		m_kernelTester.setArg<cl_uint>   (3, n);
+		k->m_kernelTester.setArg<cl::Buffer>(0, a);
+		k->m_kernelTester.setArg<cl::Buffer>(1, sum);
+		k->m_kernelTester.setArg<cl_uint>   (2, m);
+		k->m_kernelTester.setArg<cl_uint>   (3, n);
 
 		DeviceController *devCon = a.getDeviceController();
 		cl::Event ev;
 
-		devCon->enqueue1DRangeKernel(m_kernelTester, C*s, s, 0, &ev);
+		devCon->enqueue1DRangeKernel(k->m_kernelTester, C*s, s, 0, &ev);
 		ev.wait();
 
 		return getEventTime(ev);
 	}
 
 
-	void RadixSort::run(DeviceArray<cl_uint>::iterator first, DeviceArray<cl_uint>::iterator last)
+	void RadixSort::run(DeviceArray<cl_uint>::iterator first, DeviceArray<cl_uint>::iterator last, const cl::vector<cl::Event> *events)
+	{
+		Timer timer;
+		runAsync(first, last, events);
+		wait();
+		m_hostTime = timer.elapsed();
+	}
+
+
+	void RadixSort::run(DeviceArray<cl_uint> &array_a, const cl::vector<cl::Event> *events)
+	{
+		Timer timer;
+		runAsync(array_a, events);
+		wait();
+		m_hostTime = timer.elapsed();
+	}
+
+
+	cl::Event RadixSort::runAsync(DeviceArray<cl_uint>::iterator first, DeviceArray<cl_uint>::iterator last, const cl::vector<cl::Event> *events)
 	{
 		assert(first.getDeviceArray() == last.getDeviceArray());
 
+		DeviceArray<cl_uint> subArray = first.getDeviceArray()->slice(first, last);
+		if(subArray.getOffset() != 0)
+			throw Error("RadixSort: subarray does not start at an address aligned to the device's base address alignment.",
+				Error::ecMisalignedSubArray);
+
+		return runAsync(subArray, events);
 	}
 
 
-	void RadixSort::run(DeviceArray<cl_uint> &array_a)
+	void RadixSort::wait()
 	{
+		if(m_evDone() != 0)
+			m_evDone.wait();
+		m_array_a = DeviceArray<cl_uint>();
+	}
+
+
+	cl_uint RadixSort::choosePrescanGroups(DeviceController *devCon, cl_uint numCounts)
+	{
+		// 65536 prescan groups require an interval of at least 4 counts
+		if(numCounts < 4*256*256)
+			return 256;
+
+		const DeviceCharacteristics &c = devCon->getCharacteristics();
+		if(!c.isValid())
+			return 256*256;
+
+		// the prescan kernels read the counts twice and write them once; 65536 groups need two more launches
+		// (up- and down-sweep), which read and write the 65536 partial sums
+		double bytes = 3.0 * sizeof(cl_uint) * numCounts;
+		double time256   = c.estimateTransferTime(bytes, 256);
+		double time65536 = c.estimateTransferTime(bytes, 256*256)
+			+ 2 * c.m_launchLatency + c.estimateTransferTime(4.0 * sizeof(cl_uint) * 256*256, 256*256/4);
+
+		return (time65536 < time256) ? 256*256 : 256;
+	}
+
+
+	cl::Event RadixSort::runAsync(DeviceArray<cl_uint> &array_a, const cl::vector<cl::Event> *events)
+	{
+		// the temporary arrays may still be in use by a pending sort
+		wait();
+
+		Timer timer;
+
 		m_devCon = array_a.getDeviceController();
 		cl_uint n = (cl_uint)array_a.size();
 
-		assureKernelsLoaded();
-
-		startTimer();
+		KernelPool<Kernels>::Handle k = s_kernelPool.acquire(m_devCon);
 
 		m_nElements = n;
 		m_numGroups = n / (TOTAL_GROUP_ELEMENTS);
 
-		//m_numPrescanGroups = min(256,m_maxWorkGroupSize);
-		m_numPrescanGroups = (m_numGroups*BASE >= 4*256*256) ? 256*256 : 256;
+		m_numPrescanGroups = choosePrescanGroups(m_devCon, m_numGroups*BASE);
 		m_prescanInterval = (m_numGroups*BASE + m_numPrescanGroups-1) / m_numPrescanGroups;
 		cl_uint rem = m_prescanInterval % 4;
 		if(rem > 0) m_prescanInterval += 4-rem;
 
-		cout << "n = " << m_nElements << endl;
-		cout << "m = " << m_prescanInterval << endl;
-		cout << "num groups         = " << m_numGroups << endl;
-		cout << "num prescan groups = " << m_numPrescanGroups << endl;
+		// create device arrays; they are released when the next sort is enqueued or the module is destroyed
+		if(m_array_b.size() != n || m_array_b.getDeviceController() != m_devCon)
+			m_array_b = DeviceArray<cl_uint>(m_devCon, n);
+		if(m_array_gcount.size() != m_numGroups*BASE || m_array_gcount.getDeviceController() != m_devCon)
+			m_array_gcount = DeviceArray<cl_uint>(m_devCon, m_numGroups*BASE);
 
-		// create device arrays
-		DeviceArray<cl_uint> array_b(m_devCon, n);
-		m_array_gcount = new DeviceArray<cl_uint>(m_devCon, m_numGroups*BASE);
-
-		if(m_numPrescanGroups > 256)
-			m_array_psum = new DeviceArray<cl_uint>(m_devCon, 256);
+		if(m_numPrescanGroups > 256) {
+			if(m_array_psum.getDeviceController() != m_devCon)
+				m_array_psum = DeviceArray<cl_uint>(m_devCon, 256);
+		} else
+			m_array_psum = DeviceArray<cl_uint>();
 
 		// set kernel args (which do not change)
-		m_kernelCounting.setArg<cl::Buffer>(1, *m_array_gcount);
-		m_kernelPermute .setArg<cl::Buffer>(2, *m_array_gcount);
+		k->m_kernelCounting.setArg<cl::Buffer>(1, m_array_gcount);
+		k->m_kernelPermute .setArg<cl::Buffer>(2, m_array_gcount);
 
-		m_kernelPrescanSum.setArg<cl::Buffer>(0, *m_array_gcount);
-		m_kernelPrescanSum.setArg<cl_uint>   (2, m_prescanInterval);
-		m_kernelPrescanSum.setArg<cl_uint>   (3, m_numGroups*BASE);
+		k->m_kernelPrescanSum.setArg<cl::Buffer>(0, m_array_gcount);
+		k->m_kernelPrescanSum.setArg<cl_uint>   (2, m_prescanInterval);
+		k->m_kernelPrescanSum.setArg<cl_uint>   (3, m_numGroups*BASE);
 
-		m_kernelPrescanWithOffset.setArg<cl::Buffer>(0, *m_array_gcount);
-		m_kernelPrescanWithOffset.setArg<cl_uint>   (2, m_prescanInterval);
-		m_kernelPrescanWithOffset.setArg<cl_uint>   (3, m_numGroups*BASE);
+		k->m_kernelPrescanWithOffset.setArg<cl::Buffer>(0, m_array_gcount);
+		k->m_kernelPrescanWithOffset.setArg<cl_uint>   (2, m_prescanInterval);
+		k->m_kernelPrescanWithOffset.setArg<cl_uint>   (3, m_numGroups*BASE);
 
 		if(m_numPrescanGroups > 256) {
-			m_kernelPrescan         .setArg<cl::Buffer>(0, *m_array_psum);
-			m_kernelPrescanUpSweep  .setArg<cl::Buffer>(1, *m_array_psum);
-			m_kernelPrescanDownSweep.setArg<cl::Buffer>(1, *m_array_psum);
+			k->m_kernelPrescan         .setArg<cl::Buffer>(0, m_array_psum);
+			k->m_kernelPrescanUpSweep  .setArg<cl::Buffer>(1, m_array_psum);
+			k->m_kernelPrescanDownSweep.setArg<cl::Buffer>(1, m_array_psum);
 		}
 
-		// call for all 4 digits
-		m_tKernelCounting = m_tKernelPermute = m_tKernelPrescan = m_tKernelPrescanSum = m_tKernelPrescanWithOffset = 0.0;
+		// call for all 4 digits; the passes are chained by events and kernel arguments are captured when a
+		// kernel is enqueued, hence all passes are enqueued without waiting
+		cl::vector<cl::Event> waitList;
+
+		runSingle(*k, array_a,   m_array_b,  0, events,                                            m_passEvents[0]);
+		runSingle(*k, m_array_b, array_a,    8, waitFor(waitList, m_passEvents[0].m_evPermute), m_passEvents[1]);
+		runSingle(*k, array_a,   m_array_b, 16, waitFor(waitList, m_passEvents[1].m_evPermute), m_passEvents[2]);
+		runSingle(*k, m_array_b, array_a,   24, waitFor(waitList, m_passEvents[2].m_evPermute), m_passEvents[3]);
 
-		runSingle(array_a, array_b,  0);
-		runSingle(array_b, array_a,  8);
-		runSingle(array_a, array_b, 16);
-		runSingle(array_b, array_a, 24);
+		m_devCon->flush(qiCompute);
 
-		//void *ptr = queue.enqueueMapBuffer(m_array_a, CL_TRUE, CL_MAP_READ, 0, m_nElements*sizeof(cl_uint));
-		//m_queue.enqueueReadBuffer(m_array_a, CL_TRUE, 0, m_nElements*sizeof(cl_uint), a);
+		// keep the buffer of the sorted array (which may be a temporary sub-buffer) until the sort has completed
+		m_array_a = array_a;
 
-		m_totalTime = readTimer();
+		// profiling info is read on demand (see updateTimes())
+		m_evDone = m_passEvents[3].m_evPermute;
+		m_timesValid = false;
 
-		// clean-up
-		delete m_array_gcount;
-		delete m_array_psum;
-		m_array_gcount = m_array_psum = 0;
-		m_devCon = 0;
+		m_hostTime = timer.elapsed();
+		return m_evDone;
 	}
 
 
-	void RadixSort::runSingle(DeviceArray<cl_uint> &bufferSrc, DeviceArray<cl_uint> &bufferTgt, cl_uint shift)
+	void RadixSort::runSingle(Kernels &k, DeviceArray<cl_uint> &bufferSrc, DeviceArray<cl_uint> &bufferTgt, cl_uint shift,
+		const cl::vector<cl::Event> *events, PassEvents &ev)
 	{
 		// set kernel arguments
-		m_kernelCounting         .setArg<cl::Buffer>(0, bufferSrc);
-		m_kernelCounting         .setArg<cl_uint>   (2, shift);
-		m_kernelPermute          .setArg<cl::Buffer>(0, bufferSrc);
-		m_kernelPermute          .setArg<cl::Buffer>(1, bufferTgt);
-		m_kernelPermute          .setArg<cl_uint>   (3, shift);
-		m_kernelPrescanSum       .setArg<cl::Buffer>(1, bufferTgt);
-		m_kernelPrescanWithOffset.setArg<cl::Buffer>(1, bufferTgt);
+		k.m_kernelCounting         .setArg<cl::Buffer>(0, bufferSrc);
+		k.m_kernelCounting         .setArg<cl_uint>   (2, shift);
+		k.m_kernelPermute          .setArg<cl::Buffer>(0, bufferSrc);
+		k.m_kernelPermute          .setArg<cl::Buffer>(1, bufferTgt);
+		k.m_kernelPermute          .setArg<cl_uint>   (3, shift);
+		k.m_kernelPrescanSum       .setArg<cl::Buffer>(1, bufferTgt);
+		k.m_kernelPrescanWithOffset.setArg<cl::Buffer>(1, bufferTgt);
 
 		if(m_numPrescanGroups > 256) {
-			m_kernelPrescanUpSweep  .setArg<cl::Buffer>(0, bufferTgt);
-			m_kernelPrescanDownSweep.setArg<cl::Buffer>(0, bufferTgt);
+			k.m_kernelPrescanUpSweep  .setArg<cl::Buffer>(0, bufferTgt);
+			k.m_kernelPrescanDownSweep.setArg<cl::Buffer>(0, bufferTgt);
 
 		} else {
-			m_kernelPrescan.setArg<cl::Buffer>(0, bufferTgt);
+			k.m_kernelPrescan.setArg<cl::Buffer>(0, bufferTgt);
 		}
-	
-		// events for profiling	
-		cl::Event evKernelCounting;
-		cl::Event evKernelPrescanSum;
-		cl::Event evKernelPrescanUpSweep;
-		cl::Event evKernelPrescan;
-		cl::Event evKernelPrescanDownSweep;
-		cl::Event evKernelPrescanWithOffset;
-		cl::Event evKernelPermute;
-	
-		// enqueue kernels
-		m_devCon->enqueue1DRangeKernel(m_kernelCounting,   m_numGroups*LOCAL_WORK, LOCAL_WORK, 0, &evKernelCounting);
-		m_devCon->enqueue1DRangeKernel(m_kernelPrescanSum, m_numPrescanGroups,              0, 0, &evKernelPrescanSum);
+
+		// enqueue kernels; each kernel depends on its predecessor
+		cl::vector<cl::Event> waitList;
+
+		m_devCon->enqueue1DRangeKernel(k.m_kernelCounting,   m_numGroups*LOCAL_WORK, LOCAL_WORK, events, &ev.m_evCounting);
+		m_devCon->enqueue1DRangeKernel(k.m_kernelPrescanSum, m_numPrescanGroups,              0, waitFor(waitList, ev.m_evCounting), &ev.m_evPrescanSum);
 
 		if(m_numPrescanGroups > 256) {
-			m_devCon->enqueue1DRangeKernel(m_kernelPrescanUpSweep,   m_numPrescanGroups/4, LOCAL_WORK, 0, &evKernelPrescanUpSweep);
-			m_devCon->enqueue1DRangeKernel(m_kernelPrescan,          LOCAL_WORK,           LOCAL_WORK, 0, &evKernelPrescan);
-			m_devCon->enqueue1DRangeKernel(m_kernelPrescanDownSweep, m_numPrescanGroups/4, LOCAL_WORK, 0, &evKernelPrescanDownSweep);
+			m_devCon->enqueue1DRangeKernel(k.m_kernelPrescanUpSweep,   m_numPrescanGroups/4, LOCAL_WORK, waitFor(waitList, ev.m_evPrescanSum),     &ev.m_evPrescanUpSweep);
+			m_devCon->enqueue1DRangeKernel(k.m_kernelPrescan,          LOCAL_WORK,           LOCAL_WORK, waitFor(waitList, ev.m_evPrescanUpSweep), &ev.m_evPrescan);
+			m_devCon->enqueue1DRangeKernel(k.m_kernelPrescanDownSweep, m_numPrescanGroups/4, LOCAL_WORK, waitFor(waitList, ev.m_evPrescan),        &ev.m_evPrescanDownSweep);
+			waitFor(waitList, ev.m_evPrescanDownSweep);
 
-		} else
-			m_devCon->enqueue1DRangeKernel(m_kernelPrescan, LOCAL_WORK, LOCAL_WORK, 0, &evKernelPrescan);
+		} else {
+			m_devCon->enqueue1DRangeKernel(k.m_kernelPrescan, LOCAL_WORK, LOCAL_WORK, waitFor(waitList, ev.m_evPrescanSum), &ev.m_evPrescan);
+			waitFor(waitList, ev.m_evPrescan);
+		}
 
-		m_devCon->enqueue1DRangeKernel(m_kernelPrescanWithOffset, m_numPrescanGroups,              0, 0, &evKernelPrescanWithOffset);
-		m_devCon->enqueue1DRangeKernel(m_kernelPermute,           m_numGroups*LOCAL_WORK, LOCAL_WORK, 0, &evKernelPermute);
+		m_devCon->enqueue1DRangeKernel(k.m_kernelPrescanWithOffset, m_numPrescanGroups,              0, &waitList,                                   &ev.m_evPrescanWithOffset);
+		m_devCon->enqueue1DRangeKernel(k.m_kernelPermute,           m_numGroups*LOCAL_WORK, LOCAL_WORK, waitFor(waitList, ev.m_evPrescanWithOffset), &ev.m_evPermute);
+	}
 
-		// retrieve kernel runtimes
-		m_devCon->finish();
 
-		m_tKernelCounting          += getEventTime(evKernelCounting);
-		m_tKernelPrescanSum        += getEventTime(evKernelPrescanSum);
-		m_tKernelPrescan           += getEventTime(evKernelPrescan);
-		m_tKernelPrescanWithOffset += getEventTime(evKernelPrescanWithOffset);
-		m_tKernelPermute           += getEventTime(evKernelPermute);
+	void RadixSort::addKernelTimes(const PassEvents &ev) const
+	{
+		m_tKernelCounting          += getEventTime(ev.m_evCounting);
+		m_tKernelPrescanSum        += getEventTime(ev.m_evPrescanSum);
+		m_tKernelPrescan           += getEventTime(ev.m_evPrescan);
+		m_tKernelPrescanWithOffset += getEventTime(ev.m_evPrescanWithOffset);
+		m_tKernelPermute           += getEventTime(ev.m_evPermute);
 
 		if(m_numPrescanGroups > 256)
-			m_tKernelPrescan += getEventTime(evKernelPrescanUpSweep) + getEventTime(evKernelPrescanDownSweep);
-
-
-	//	cl_uint *gcount = new cl_uint[m_nElements];
-	//	cout << "Reading gcount..." << flush;
-	//#ifdef USE_OLD_KERNELS
-	//	m_queue.enqueueReadBuffer(m_array_gcount, CL_TRUE, 0, m_nElements*sizeof(cl_uint), gcount);
-	//#else
-	//	m_queue.enqueueReadBuffer(m_array_gcount, CL_TRUE, 0, m_numGroups*BASE*sizeof(cl_uint), gcount);
-	//#endif
-	//	cout << "done." << endl;
-	//	
-	//	cl_uint *b = new cl_uint[m_nElements];
-	//	cout << "Reading bufferTgt..." << flush;
-	//	m_queue.enqueueReadBuffer(bufferTgt, CL_TRUE, 0, m_nElements*sizeof(cl_uint), b);
-	//	cout << "done." << endl;
-	//
-	//	if(m_nElements <= 1024) {
-			//for(cl_uint i = 0; i < m_numGroups*BASE; ++i)
-			//	cout << gcount[i] << "  ";
-			//cout << endl;
-	//
-	//		for(cl_uint i = 0; i < m_nElements; ++i) {
-	//			cout << "b[" << setw(4) << i << "] = " << setw(10) << b[i];
-	//			cout << "   " << setw(3) << (b[i] & 0xffu)
-	//				<< " | " << setw(3) << ((b[i] >> 8) & 0xffu)
-	//				<< " | " << setw(3) << ((b[i] >> 16) & 0xffu)
-	//				<< " | " << setw(3) << ((b[i] >> 24) & 0xffu) << endl;
-	//		}
-	//	}
-	//
-	//	delete [] b;
-	//	delete [] gcount;
+			m_tKernelPrescan += getEventTime(ev.m_evPrescanUpSweep) + getEventTime(ev.m_evPrescanDownSweep);
+	}
+
+
+	void RadixSort::updateTimes() const
+	{
+		if(m_timesValid)
+			return;
+
+		m_evDone.wait();
+
+		m_tKernelCounting = m_tKernelPermute = m_tKernelPrescan = m_tKernelPrescanSum = m_tKernelPrescanWithOffset = 0.0;
+		m_totalTime = 0.0;
+
+		try {
+			for(int i = 0; i < 4; ++i)
+				addKernelTimes(m_passEvents[i]);
+
+			cl_ulong queuedTime = m_passEvents[0].m_evCounting.getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>();
+			cl_ulong endTime    = m_evDone.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+			m_totalTime = 1.e-6 * (endTime - queuedTime);
+
+		} catch(cl::Error) {
+			// profiling not enabled for the command queue
+			m_tKernelCounting = m_tKernelPermute = m_tKernelPrescan = m_tKernelPrescanSum = m_tKernelPrescanWithOffset = 0.0;
+		}
+
+		m_timesValid = true;
 	}
 
 }
@@ -0,0 +1,131 @@
+#include <tbt/ThreadPool.h>
+
+using namespace std;
+
+
+namespace tbt
+{
+
+	ThreadPool::ThreadPool(unsigned int numThreads)
+		: m_task(0), m_numTasks(0), m_nextTask(0), m_numActive(0), m_generation(0), m_shutdown(false)
+	{
+		if(numThreads == 0)
+			numThreads = max(1u, thread::hardware_concurrency());
+
+		for(unsigned int i = 1; i < numThreads; ++i)
+			m_threads.push_back(thread(&ThreadPool::workerLoop, this));
+	}
+
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_shutdown = true;
+		}
+		m_cvWork.notify_all();
+
+		for(size_t i = 0; i < m_threads.size(); ++i)
+			m_threads[i].join();
+	}
+
+
+	void ThreadPool::runTasks()
+	{
+		for(size_t i = m_nextTask++; i < m_numTasks; i = m_nextTask++) {
+			try {
+				(*m_task)(i);
+			} catch(...) {
+				lock_guard<mutex> lock(m_mutex);
+				if(!m_exception)
+					m_exception = current_exception();
+			}
+		}
+	}
+
+
+	void ThreadPool::workerLoop()
+	{
+		unsigned int generation = 0;
+
+		for(;;) {
+			{
+				unique_lock<mutex> lock(m_mutex);
+				while(!m_shutdown && m_generation == generation)
+					m_cvWork.wait(lock);
+
+				if(m_shutdown)
+					return;
+				generation = m_generation;
+			}
+
+			runTasks();
+
+			lock_guard<mutex> lock(m_mutex);
+			if(--m_numActive == 0)
+				m_cvDone.notify_one();
+		}
+	}
+
+
+	void ThreadPool::parallelFor(size_t numTasks, const function<void(size_t)> &task)
+	{
+		if(m_threads.empty() || numTasks <= 1) {
+			// run all tasks even if some throw, and rethrow the first exception as in the parallel case
+			exception_ptr e;
+			for(size_t i = 0; i < numTasks; ++i) {
+				try {
+					task(i);
+				} catch(...) {
+					if(!e)
+						e = current_exception();
+				}
+			}
+
+			if(e)
+				rethrow_exception(e);
+			return;
+		}
+
+		lock_guard<mutex> runLock(m_runMutex);
+
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_task      = &task;
+			m_numTasks  = numTasks;
+			m_nextTask  = 0;
+			m_numActive = m_threads.size();
+			m_exception = exception_ptr();
+			++m_generation;
+		}
+		m_cvWork.notify_all();
+
+		runTasks();
+
+		exception_ptr e;
+		{
+			unique_lock<mutex> lock(m_mutex);
+			while(m_numActive > 0)
+				m_cvDone.wait(lock);
+
+			m_task = 0;
+			e = m_exception;
+			m_exception = exception_ptr();
+		}
+
+		if(e)
+			rethrow_exception(e);
+	}
+
+
+	ThreadPool &ThreadPool::getDefault()
+	{
+		// created with call_once, since function-local statics are not initialized thread-safely by all compilers;
+		// the pool is never destroyed, so worker threads are not joined during static destruction
+		static once_flag flag;
+		static ThreadPool *pool = 0;
+		call_once(flag, []() { pool = new ThreadPool; });
+		return *pool;
+	}
+
+}
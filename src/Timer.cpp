@@ -0,0 +1,51 @@
+
+#include <tbt/Timer.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+
+namespace tbt
+{
+
+#ifdef _WIN32
+
+	//! Returns the frequency of the performance counter (which is fixed at system boot).
+	static cl_ulong getCounterFrequency()
+	{
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		return (cl_ulong)frequency.QuadPart;
+	}
+
+	// initialized at namespace scope, since function-local statics are not initialized thread-safely by all
+	// compilers; Timer must therefore not be used by constructors of other global objects
+	static const cl_ulong s_frequency = getCounterFrequency();
+
+	cl_ulong Timer::now()
+	{
+		const cl_ulong frequency = s_frequency;
+
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+
+		// split into seconds and remainder to avoid overflow when converting to nanoseconds
+		cl_ulong ticks = (cl_ulong)counter.QuadPart;
+		return (ticks / frequency) * 1000000000ull + (ticks % frequency) * 1000000000ull / frequency;
+	}
+
+#else
+
+	cl_ulong Timer::now()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (cl_ulong)ts.tv_sec * 1000000000ull + (cl_ulong)ts.tv_nsec;
+	}
+
+#endif
+
+}
@@ -2,20 +2,98 @@
 #include <tbt/Utility.h>
 #include <tbt/Global.h>
 
+#include <algorithm>
 #include <fstream>
-#include <direct.h>
-#include <io.h>
+#include <iterator>
 #include <fcntl.h>
+#include <math.h>
 #include <sys/stat.h>
 #include <sstream>
-#include <sys/stat.h>
+#include <map>
+#include <mutex>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#else
+#include <sys/types.h>
+#include <limits.h>
+#include <unistd.h>
+#endif
 
 
 using namespace std;
 
 
 namespace tbt {
-	
+
+#ifdef _WIN32
+	typedef struct _stat64 FileStatus;
+
+	static int getFileStatus(int fh, FileStatus *st)                  { return _fstat64(fh, st); }
+	static int getFileStatus(const char *fileName, FileStatus *st)    { return _stat64(fileName, st); }
+	static int makeDirectory(const char *dirName)                     { return _mkdir(dirName); }
+
+	static FILE *openFile(const char *fileName, const char *mode) {
+		FILE *pFile;
+		return (fopen_s(&pFile, fileName, mode) == 0) ? pFile : 0;
+	}
+#else
+	typedef struct stat FileStatus;
+
+	static int getFileStatus(int fh, FileStatus *st)                  { return fstat(fh, st); }
+	static int getFileStatus(const char *fileName, FileStatus *st)    { return stat(fileName, st); }
+	static int makeDirectory(const char *dirName)                     { return mkdir(dirName, 0777); }
+
+	static FILE *openFile(const char *fileName, const char *mode)     { return fopen(fileName, mode); }
+#endif
+
+
+	//! A program binary registered with Utility::registerProgramBinary().
+	struct RegisteredProgramBinary {
+		string               m_deviceName;     //!< the name of the device the binary has been compiled for.
+		string               m_driverVersion;  //!< the driver version the binary has been compiled with.
+		cl_uint              m_extensions;     //!< the extensions enabled when compiling the binary.
+		const unsigned char *m_binary;         //!< the program binary.
+		size_t               m_size;           //!< the size of the program binary in bytes.
+	};
+
+	//! Returns the mutex protecting the program registry and the program cache.
+	static recursive_mutex &programMutex()
+	{
+		static recursive_mutex m;
+		return m;
+	}
+
+	//! Returns the registered program sources (indexed by program name).
+	static map<string,string> &registeredProgramSources()
+	{
+		static map<string,string> sources;
+		return sources;
+	}
+
+	//! Returns the registered program binaries (indexed by program name).
+	static multimap<string,RegisteredProgramBinary> &registeredProgramBinaries()
+	{
+		static multimap<string,RegisteredProgramBinary> binaries;
+		return binaries;
+	}
+
+	//! Escapes \a str such that it can be written as C string literal (up to the first null character).
+	static string escapeCString(const string &str)
+	{
+		string result;
+		for(size_t i = 0; i < str.length() && str[i] != '\0'; ++i) {
+			if(str[i] == '\\' || str[i] == '\"')
+				result += '\\';
+			result += str[i];
+		}
+		return result;
+	}
+
 	string Utility::toString(cl_uint i)
 	{
 		stringstream ss;
@@ -24,7 +102,34 @@ namespace tbt {
 	}
 
 
-	bool Utility::writeProgramInfoFile(const char *fileName, const DeviceController *devCon, cl_uint extensions)
+	void Utility::writeJSONString(ostream &os, const string &str)
+	{
+		os << '"';
+		for(size_t i = 0; i < str.size(); ++i) {
+			char c = str[i];
+			if(c == '"' || c == '\\')
+				os << '\\' << c;
+			else if((unsigned char)c < 0x20)
+				os << ' ';
+			else
+				os << c;
+		}
+		os << '"';
+	}
+
+
+	cl_ulong Utility::hash(const char *str, size_t length)
+	{
+		cl_ulong h = 14695981039346656037ULL;
+		for(size_t i = 0; i < length; ++i) {
+			h ^= (unsigned char)str[i];
+			h *= 1099511628211ULL;
+		}
+		return h;
+	}
+
+
+	bool Utility::writeProgramInfoFile(const char *fileName, const DeviceController *devCon, cl_uint extensions, cl_ulong sourceHash)
 	{
 		ofstream osInfo(fileName);
 		if(!osInfo) return false;
@@ -34,11 +139,13 @@ namespace tbt {
 		osInfo << "CL_DEVICE_VERSION\t"     << devCon->getVersion()       << "\n";
 		osInfo << "CL_DRIVER_VERSION\t"     << devCon->getDriverVersion() << "\n";
 		osInfo << "TBT_DEVICE_EXTENSIONS\t" << extensions                 << "\n";
+		if(sourceHash != 0)
+			osInfo << "TBT_SOURCE_HASH\t"   << sourceHash                 << "\n";
 
 		return true;
 	}
 
-	bool Utility::checkProgramInfoFile(const char *fileName, const DeviceController *devCon, cl_uint extensions)
+	bool Utility::checkProgramInfoFile(const char *fileName, const DeviceController *devCon, cl_uint extensions, cl_ulong sourceHash)
 	{
 		ifstream isInfo(fileName);
 		if(!isInfo) return false;
@@ -48,6 +155,7 @@ namespace tbt {
 		bool checkedVersion    = false;
 		bool checkedDriver     = false;
 		bool checkedExtensions = false;
+		bool checkedHash       = (sourceHash == 0);
 
 		char buffer[256];
 		while(!isInfo.eof())
@@ -88,10 +196,16 @@ namespace tbt {
 			} else if (name == "TBT_DEVICE_EXTENSIONS") {
 				if(extensions != atoi(value.c_str())) return false;
 				checkedExtensions = true;
+
+			} else if (name == "TBT_SOURCE_HASH") {
+				cl_ulong h = 0;
+				istringstream(value) >> h;
+				if(sourceHash != 0 && sourceHash != h) return false;
+				checkedHash = true;
 			}
 		}
 
-		return checkedName && checkedVendor && checkedVersion && checkedDriver && checkedExtensions;
+		return checkedName && checkedVendor && checkedVersion && checkedDriver && checkedExtensions && checkedHash;
 	}
 
 
@@ -140,52 +254,179 @@ namespace tbt {
 
 	size_t Utility::getFileLength(int fh)
 	{
-		struct _stat64 stat;
-		int retVal = _fstat64(fh, &stat);
+		FileStatus st;
+		int retVal = getFileStatus(fh, &st);
 		if (retVal == -1)
 			throw Error("OclBase::getFileLength: Could not access file-status information!");
 
-		return (size_t)stat.st_size;
+		return (size_t)st.st_size;
 	}
 
 
 	size_t Utility::getFileLength(const char *fileName)
 	{
-		struct _stat64 stat;
-		int retVal = _stat64(fileName, &stat);
+		FileStatus st;
+		int retVal = getFileStatus(fileName, &st);
 		if (retVal == -1)
 			throw Error("OclBase::getFileLength: Could not access file-status information!");
 
-		return (size_t)stat.st_size;
+		return (size_t)st.st_size;
 	}
 
 
-	__time64_t Utility::getFileModificationTime(int fh)
+	FileTime Utility::getFileModificationTime(int fh)
 	{
-		struct _stat64 stat;
-		int retVal = _fstat64(fh, &stat);
+		FileStatus st;
+		int retVal = getFileStatus(fh, &st);
 		if (retVal == -1)
 			throw Error("OclBase::getFileModificationTime: File not found!", Error::ecFileNotFound);
 
-		return stat.st_mtime;
+		return st.st_mtime;
 	}
 
 
-	__time64_t Utility::getFileModificationTime(const char *fileName)
+	FileTime Utility::getFileModificationTime(const char *fileName)
 	{
-		struct _stat64 stat;
-		int retVal = _stat64(fileName, &stat);
+		FileStatus st;
+		int retVal = getFileStatus(fileName, &st);
 		if (retVal == -1)
 			throw Error("OclBase::getFileModificationTime: File not found!", Error::ecFileNotFound);
 
-		return stat.st_mtime;
+		return st.st_mtime;
+	}
+
+
+	void Utility::registerProgramSource(const char *progName, const char *source, size_t length)
+	{
+		lock_guard<recursive_mutex> lock(programMutex());
+		registeredProgramSources()[progName] = string(source, length);
+	}
+
+
+	const string *Utility::findProgramSource(const char *progName)
+	{
+		map<string,string>::const_iterator it = registeredProgramSources().find(progName);
+		return (it != registeredProgramSources().end()) ? &it->second : 0;
+	}
+
+
+	void Utility::registerProgramBinary(const char *progName, const char *deviceName, const char *driverVersion,
+		cl_uint extensions, const unsigned char *binary, size_t size)
+	{
+		RegisteredProgramBinary rb;
+		rb.m_deviceName    = deviceName;
+		rb.m_driverVersion = driverVersion;
+		rb.m_extensions    = extensions;
+		rb.m_binary        = binary;
+		rb.m_size          = size;
+
+		lock_guard<recursive_mutex> lock(programMutex());
+		registeredProgramBinaries().insert(make_pair(string(progName), rb));
+	}
+
+
+	bool Utility::buildProgramFromRegisteredBinary(const char *progName, const DeviceController *devCon, cl_uint extensions, cl::Program &program)
+	{
+		typedef multimap<string,RegisteredProgramBinary>::const_iterator BinaryIterator;
+
+		pair<BinaryIterator,BinaryIterator> range = registeredProgramBinaries().equal_range(progName);
+		if(range.first == range.second)
+			return false;
+
+		// compare as C strings, since some OpenCL implementations return strings including the terminating null
+		string deviceName    = devCon->getName();
+		string driverVersion = devCon->getDriverVersion();
+
+		for(BinaryIterator it = range.first; it != range.second; ++it)
+		{
+			const RegisteredProgramBinary &rb = it->second;
+			if(rb.m_extensions != extensions || strcmp(rb.m_deviceName.c_str(), deviceName.c_str()) != 0 ||
+				strcmp(rb.m_driverVersion.c_str(), driverVersion.c_str()) != 0)
+				continue;
+
+			cl::vector<cl::Device> devices;
+			devices.push_back(devCon->getDevice());
+
+			cl::Program::Binaries binaries(1, make_pair((const void *)rb.m_binary, rb.m_size));
+			try {
+				program = cl::Program(devCon->getContext(), devices, binaries);
+				program.build(devices);
+				return true;
+
+			// binary rejected by the driver; just go on and build the program from source
+			} catch(cl::Error) { }
+		}
+
+		return false;
+	}
+
+
+	string Utility::getProgramBinary(const cl::Program &program)
+	{
+		cl::vector<size_t> binarySizes(1);
+		program.getInfo(CL_PROGRAM_BINARY_SIZES, &binarySizes);
+		size_t size = binarySizes[0];
+
+		char *buffer = new char[size];
+		cl::vector<char *> buffers(1, buffer);
+		program.getInfo(CL_PROGRAM_BINARIES, &buffers);
+
+		string binary(buffer, size);
+		delete [] buffer;
+
+		return binary;
+	}
+
+
+	string Utility::getProgramSource(const char *progName)
+	{
+		lock_guard<recursive_mutex> lock(programMutex());
+		registerEmbeddedPrograms();
+
+		const string *embeddedSource = findProgramSource(progName);
+		if(embeddedSource != 0)
+			return *embeddedSource;
+
+		string sourceName = getExePath() + progName;
+		ifstream sourceFile(sourceName);
+		if(!sourceFile) {
+			std::string msg("Utility::getProgramSource: Could not read kernel file ");
+			msg.append(sourceName);
+			throw Error(msg.c_str(), Error::ecKernelFileNotFound);
+		}
+
+		return string(istreambuf_iterator<char>(sourceFile), istreambuf_iterator<char>());
+	}
+
+
+	bool Utility::getDeviceCacheDir(const DeviceController *devCon, std::string &dir)
+	{
+		string dirNameCache = globalConfig.getProgramCacheDir().empty() ? getExePath() + "cache" : globalConfig.getProgramCacheDir();
+		dir = dirNameCache + getPathSeparator() + toString(devCon->getVendorID()) + "_" + simplify(devCon->getName());
+
+		// create cache directories (if not yet present)
+		makeDirectory(dirNameCache.c_str());
+		return makeDirectory(dir.c_str()) == 0 || errno == EEXIST;
 	}
 
 
 	cl::Program Utility::buildProgram(const char *progName, cl_uint requiredExt, cl_uint optionalExt)
 	{
-		cl::Context context = getContext();
-		DeviceController *devCon = getDeviceController();
+		return buildProgram(getDeviceController(), progName, requiredExt, optionalExt);
+	}
+
+
+	cl::Program Utility::buildProgram(DeviceController *devCon, const char *progName, cl_uint requiredExt, cl_uint optionalExt)
+	{
+		lock_guard<recursive_mutex> lock(programMutex());
+
+		static bool embeddedProgramsRegistered = false;
+		if(!embeddedProgramsRegistered) {
+			registerEmbeddedPrograms();
+			embeddedProgramsRegistered = true;
+		}
+
+		cl::Context context = devCon->getContext();
 
 		cl::vector<cl::Device> devices;
 		devices.push_back(devCon->getDevice());
@@ -197,35 +438,35 @@ namespace tbt {
 		cl_uint extensions = (requiredExt | optionalExt) & devCon->getExtensions();
 		bool cacheBinary = globalConfig.getCacheProgramBinaries();
 
-		string sourceName = getExePath() + progName;
-		string binaryName, infoName, deviceName;
+		// try registered (precompiled) binary first; this requires no disk access at all
+		cl::Program registeredProgram;
+		if(buildProgramFromRegisteredBinary(progName, devCon, extensions, registeredProgram))
+			return registeredProgram;
+
+		// embedded sources are identified by their hash value (instead of the modification time of the source file)
+		const string *embeddedSource = findProgramSource(progName);
+		cl_ulong sourceHash = (embeddedSource != 0) ? hash(embeddedSource->c_str(), embeddedSource->length()) : 0;
+
+		string sourceName = (embeddedSource != 0) ? string(progName) : getExePath() + progName;
+		string binaryName, infoName;
 
 		// try reading cached binary file?
 		if(cacheBinary)
 		{
-			// assemble directory and file names for cache
-			deviceName = simplify(devCon->getName());
-
-			cl_uint deviceVendorID = devCon->getVendorID();
-
-			string dirNameCache = getExePath() + "cache";
-			string dirNameCacheDevice = dirNameCache + getPathSeparator() + toString(deviceVendorID) + "_" + simplify(deviceName);
+			// assemble file names for cache
+			string dirNameCacheDevice;
+			cacheBinary = getDeviceCacheDir(devCon, dirNameCacheDevice);
 			binaryName = dirNameCacheDevice + getPathSeparator() + progName + ".bin";
 			infoName   = dirNameCacheDevice + getPathSeparator() + progName + ".info";
 
-			// create cache directories (if not yet present)
-			_mkdir(dirNameCache.c_str());
-			int retVal = _mkdir(dirNameCacheDevice.c_str());
-			cacheBinary = (retVal == 0 || errno == EEXIST);
-
 			// check if we have a cache directory, and if the cached file is up-to-date
-			if( retVal == 0 || (errno == EEXIST && (!globalConfig.getRecompileProgramsIfNewerDriver() || checkProgramInfoFile(infoName.c_str(), devCon, extensions))) )
+			bool skipInfoCheck = !globalConfig.getRecompileProgramsIfNewerDriver() && embeddedSource == 0;
+			if( cacheBinary && (skipInfoCheck || checkProgramInfoFile(infoName.c_str(), devCon, extensions, sourceHash)) )
 			{
 				//read cached file
-				FILE *pFile;
-				errno_t err = fopen_s(&pFile, binaryName.c_str(), "rb");
-				if(err == 0) {
-					if(getFileModificationTime(sourceName.c_str()) <= getFileModificationTime(pFile)) {
+				FILE *pFile = openFile(binaryName.c_str(), "rb");
+				if(pFile != 0) {
+					if(embeddedSource != 0 || getFileModificationTime(sourceName.c_str()) <= getFileModificationTime(pFile)) {
 						size_t size = getFileLength(pFile);
 						if(size > 0)
 						{
@@ -268,15 +509,20 @@ namespace tbt {
 			}
 		}
 
-		// read source file
-		ifstream sourceFile(sourceName);
-		if(!sourceFile) {
-			std::string msg("OclBase::buildProgram: Could not read kernel file ");
-			msg.append(sourceName);
-			throw Error(msg.c_str(), Error::ecKernelFileNotFound);
+		// read source file (unless we have an embedded source)
+		string sourceFromFile;
+		if(embeddedSource == 0) {
+			ifstream sourceFile(sourceName);
+			if(!sourceFile) {
+				std::string msg("OclBase::buildProgram: Could not read kernel file ");
+				msg.append(sourceName);
+				throw Error(msg.c_str(), Error::ecKernelFileNotFound);
+			}
+
+			sourceFromFile.assign(istreambuf_iterator<char>(sourceFile), (istreambuf_iterator<char>()));
 		}
 
-		string progstr(istreambuf_iterator<char>(sourceFile), (istreambuf_iterator<char>()));
+		const string &progstr = (embeddedSource != 0) ? *embeddedSource : sourceFromFile;
 		const string &header = devCon->createOpenCLHeader(requiredExt, optionalExt);
 
 		cl::Program::Sources source;
@@ -299,54 +545,118 @@ namespace tbt {
 
 		// cache binary file
 		if(cacheBinary) {
-			cl_uint numdev;
-			program.getInfo(CL_PROGRAM_NUM_DEVICES, &numdev);
-
-			cl::vector<size_t> binarySizes(1);
-			program.getInfo(CL_PROGRAM_BINARY_SIZES, &binarySizes);
-			size_t size = binarySizes[0];
+			string binary = getProgramBinary(program);
+			const char *errorMsg = 0;
 
-			char *buffer = new char[size];
-			cl::vector<char *> buffers(1, buffer);
-			program.getInfo(CL_PROGRAM_BINARIES, &buffers);
-
-			FILE *pFile;
-			errno_t err = fopen_s(&pFile, binaryName.c_str(), "wb");
-			if(err == 0) {
-				size_t bytesWritten = fwrite(buffer, 1, size, pFile);
+			FILE *pFile = openFile(binaryName.c_str(), "wb");
+			if(pFile != 0) {
+				size_t bytesWritten = fwrite(binary.data(), 1, binary.size(), pFile);
 				fclose(pFile);
 
-				if(bytesWritten < size) {
-					delete [] buffer;
-					throw Error("OclBase::buildProgram: Could not write binary file to cache!", Error::ecProgramCacheError);
-				}
+				if(bytesWritten < binary.size())
+					errorMsg = "OclBase::buildProgram: Could not write binary file to cache!";
+				else if(writeProgramInfoFile(infoName.c_str(), devCon, extensions, sourceHash) == false)
+					errorMsg = "OclBase::buildProgram: Could not write info file to cache!";
 
-				if(writeProgramInfoFile(infoName.c_str(), devCon, extensions) == false) {
-					delete [] buffer;
-					throw Error("OclBase::buildProgram: Could not write info file to cache!", Error::ecProgramCacheError);
+				// do not leave an incomplete cache entry behind
+				if(errorMsg != 0) {
+					remove(binaryName.c_str());
+					remove(infoName.c_str());
 				}
-				
-			} else {
-				delete [] buffer;
-				throw Error("OclBase::buildProgram: Could not cache binary file!", Error::ecProgramCacheError);
-			}
 
-			delete [] buffer;
+			} else
+				errorMsg = "OclBase::buildProgram: Could not cache binary file!";
+
+			// the cache is optional for registered (embedded) sources, e.g., in a read-only installation
+			if(errorMsg != 0 && embeddedSource == 0)
+				throw Error(errorMsg, Error::ecProgramCacheError);
 		}
 
 		return program;
 	}
 
 
+	void Utility::writeProgramBinaryBundle(const char *progName, const char *fileName, const char *funcName, cl_uint requiredExt, cl_uint optionalExt)
+	{
+		DeviceController *devCon = getDeviceController();
+		cl_uint extensions = (requiredExt | optionalExt) & devCon->getExtensions();
+
+		string binary = getProgramBinary(buildProgram(progName, requiredExt, optionalExt));
+		if(binary.empty())
+			throw Error("Utility::writeProgramBinaryBundle: Program binary not available!", Error::ecProgramCacheError);
+
+		ofstream os(fileName);
+		if(!os) {
+			std::string msg("Utility::writeProgramBinaryBundle: Could not write file ");
+			msg.append(fileName);
+			throw Error(msg, Error::ecProgramCacheError);
+		}
+
+		os << "\n// Binary of OpenCL program " << progName << " for device " << escapeCString(devCon->getName()) << "\n";
+		os << "// (generated by tbt::Utility::writeProgramBinaryBundle)\n\n";
+		os << "#include <tbt/Utility.h>\n\n\n";
+		os << "static const unsigned char s_binary[" << binary.size() << "] = {";
+		for(size_t i = 0; i < binary.size(); ++i) {
+			if(i % 16 == 0) os << "\n\t";
+			os << (unsigned int)(unsigned char)binary[i] << ",";
+		}
+		os << "\n};\n\n\n";
+
+		os << "void " << funcName << "()\n{\n";
+		os << "\ttbt::Utility::registerProgramBinary(\"" << progName << "\",\n";
+		os << "\t\t\"" << escapeCString(devCon->getName()) << "\",\n";
+		os << "\t\t\"" << escapeCString(devCon->getDriverVersion()) << "\",\n";
+		os << "\t\t" << extensions << ", s_binary, sizeof(s_binary));\n";
+		os << "}\n";
+
+		if(!os)
+			throw Error("Utility::writeProgramBinaryBundle: Could not write binary bundle!", Error::ecProgramCacheError);
+	}
+
+
 	void *Utility::alignedMalloc(size_t size, size_t alignment)
 	{
+#ifdef _WIN32
 		return _aligned_malloc(size, alignment);
+#else
+		// posix_memalign requires a multiple of sizeof(void*)
+		void *ptr;
+		return (posix_memalign(&ptr, max(alignment, sizeof(void*)), size) == 0) ? ptr : 0;
+#endif
 	}
 
 
 	void Utility::alignedFree(void *ptr)
 	{
+#ifdef _WIN32
 		_aligned_free(ptr);
+#else
+		free(ptr);
+#endif
+	}
+
+
+	static void CL_CALLBACK alignedFreeCallback(cl_mem, void *userData)
+	{
+		Utility::alignedFree(userData);
+	}
+
+
+	bool Utility::alignedFreeWithMemObject(const cl::Memory &memObject, void *ptr)
+	{
+		return clSetMemObjectDestructorCallback(memObject(), alignedFreeCallback, ptr) == CL_SUCCESS;
+	}
+
+
+	size_t Utility::getPageSize()
+	{
+#ifdef _WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwPageSize;
+#else
+		return (size_t)sysconf(_SC_PAGESIZE);
+#endif
 	}
 
 
@@ -1,6 +1,7 @@
 
 #include <tbt/algorithm.h>
 #include <tbt/RadixSort.h>
+#include <tbt/HostRadixSort.h>
 
 
 namespace tbt {
@@ -19,4 +20,76 @@ namespace tbt {
 		rs.run(first,last);
 	}
 
+
+	//! Returns true if an array of \a n elements shall be processed on the host with backend \a backend.
+	/**
+	 * The device radix-sort requires a multiple of 1024 elements; an error is thrown if backend beDevice is
+	 * requested for other sizes.
+	 */
+	static bool useHost(Backend backend, size_t n, DeviceController *devCon)
+	{
+		if(backend == beDevice && n % 1024 != 0)
+			throw Error("radixSort: the device backend requires a multiple of 1024 elements", Error::ecUnknown);
+
+		if(backend != beAuto)
+			return backend == beHost;
+
+		return devCon == 0 || n < globalConfig.getHostAlgorithmThreshold() || n % 1024 != 0;
+	}
+
+
+	template<>
+	void radixSort<cl_uint>(HostArray<cl_uint> &hostArray, Backend backend)
+	{
+		DeviceController *devCon = getDeviceController();
+
+		if(useHost(backend, hostArray.size(), devCon)) {
+			HostRadixSort rs;
+			rs.run(hostArray);
+
+		} else {
+			if(devCon == 0)
+				throw Error("radixSort: no device available", Error::ecNoOpenCLPlatformFound);
+
+			DeviceArray<cl_uint> devArray(devCon, hostArray.size());
+			devArray.loadBlocking(hostArray);
+
+			RadixSort rs;
+			rs.run(devArray);
+
+			devArray.storeBlocking(hostArray);
+		}
+	}
+
+
+	template<>
+	void radixSort<cl_uint>(MappedArray<cl_uint> &mappedArray, Backend backend)
+	{
+		if(mappedArray.size() == 0)
+			return;
+
+		bool mapped = mappedArray.isMapped();
+
+		if(useHost(backend, mappedArray.size(), mappedArray.getDeviceController())) {
+			if(!mapped)
+				mappedArray.mapDeviceToHostBlocking(mmReadWrite);
+
+			HostRadixSort rs;
+			rs.run(&mappedArray[0], mappedArray.size());
+
+			if(!mapped)
+				mappedArray.mapHostToDeviceBlocking();
+
+		} else {
+			if(mapped)
+				mappedArray.mapHostToDeviceBlocking();
+
+			RadixSort rs;
+			rs.run(mappedArray);
+
+			if(mapped)
+				mappedArray.mapDeviceToHostBlocking(mmReadWrite);
+		}
+	}
+
 }
@@ -0,0 +1,127 @@
+
+#ifndef _TBT_COMMAND_GRAPH_H
+#define _TBT_COMMAND_GRAPH_H
+
+#include <tbt/DeviceController.h>
+
+#include <vector>
+
+
+namespace tbt
+{
+
+	//! Recorded sequence of kernel launches that can be replayed with a single call.
+	/**
+	 * Applications often enqueue the same sequence of kernels with the same buffers many times (e.g., in
+	 * every iteration of a simulation loop). A command graph records such a sequence once; each recorded
+	 * launch owns its own kernel object, so its arguments are bound once at recording time and need not
+	 * be set again for each launch.
+	 *
+	 * A command graph is used as follows:
+	 *   -# Add kernel launches with addKernel() and set the arguments of the returned kernel objects.
+	 *   -# Call finalize(); arguments must not be changed afterwards.
+	 *   -# Call replay() as often as required.
+	 *
+	 * The launches are executed in the order they were added, also on out-of-order command queues. If the
+	 * device supports the extension <tt>cl_khr_command_buffer</tt>, the sequence is recorded into a command
+	 * buffer and replay() enqueues it with a single OpenCL call. Otherwise, replay() enqueues the pre-bound
+	 * kernels in a tight loop using the OpenCL C API directly. Since the extension is still provisional,
+	 * only the revision TBT has been written against (0.9.5) is used.
+	 *
+	 * If a Profiler is attached to the device controller, a replay of a command buffer is recorded as a
+	 * single command named "command graph"; otherwise, each kernel launch is recorded.
+	 *
+	 * A command graph must not be replayed by several host threads at the same time.
+	 *
+	 * \ingroup context
+	 */
+	class CommandGraph
+	{
+		struct CommandBufferKHR;
+
+		//! A recorded kernel launch.
+		struct Node {
+			cl::Kernel m_kernel;      //!< the kernel object (owned by this node).
+			size_t     m_globalWork;  //!< the number of global work-items.
+			size_t     m_localWork;   //!< the number of work-items per work-group (0 = chosen by implementation).
+		};
+
+		DeviceController *m_devCon;  //!< the device controller to whose queue the graph is enqueued.
+		QueueId           m_queue;   //!< the command queue used for replay.
+
+		std::vector<Node> m_nodes;      //!< the recorded kernel launches.
+		bool              m_finalized;  //!< has finalize() been called?
+
+		CommandBufferKHR *m_commandBuffer;  //!< the command buffer (if cl_khr_command_buffer is used, otherwise 0).
+
+		CommandGraph(const CommandGraph &);              // = delete
+		CommandGraph &operator=(const CommandGraph &);   // = delete
+
+	public:
+		//! Constructs an empty command graph for queue \a queue of \a devCon.
+		/**
+		 * @param[in] devCon  is the device controller on whose device the kernels are executed.
+		 * @param[in] queue   selects the command queue used by replay().
+		 */
+		CommandGraph(DeviceController *devCon, QueueId queue = qiCompute);
+
+		//! Destructor. Releases the command buffer (if any).
+		~CommandGraph();
+
+		//! Adds a launch of kernel \a kernelName from \a program.
+		/**
+		 * @param[in] program     is a program built for the device of the command graph.
+		 * @param[in] kernelName  is the name of the kernel function in \a program.
+		 * @param[in] globalWork  is the number of global work-items (1D range).
+		 * @param[in] localWork   is the number of work-items that make up a work-group (0 lets the
+		 *                        OpenCL implementation choose).
+		 * @return                the kernel object of the new launch; its arguments must be set before finalize().
+		 */
+		cl::Kernel addKernel(const cl::Program &program, const char *kernelName, size_t globalWork, size_t localWork = 0);
+
+		//! Adds a launch of the same kernel function as \a kernel.
+		/**
+		 * The launch gets a new kernel object created from the program and function name of \a kernel;
+		 * the arguments of \a kernel are not copied.
+		 *
+		 * @param[in] kernel      is a kernel object whose kernel function shall be launched.
+		 * @param[in] globalWork  is the number of global work-items (1D range).
+		 * @param[in] localWork   is the number of work-items that make up a work-group (0 lets the
+		 *                        OpenCL implementation choose).
+		 * @return                the kernel object of the new launch; its arguments must be set before finalize().
+		 */
+		cl::Kernel addKernel(const cl::Kernel &kernel, size_t globalWork, size_t localWork = 0);
+
+		//! Completes recording; no launches can be added afterwards.
+		/**
+		 * Records the launches into a command buffer if <tt>cl_khr_command_buffer</tt> is supported by
+		 * the device (and falls back to replaying the pre-bound kernels if creating the command buffer fails).
+		 */
+		void finalize();
+
+		//! Returns true if finalize() has been called.
+		bool isFinalized() const { return m_finalized; }
+
+		//! Returns true if the graph is replayed using a <tt>cl_khr_command_buffer</tt> command buffer.
+		bool usesCommandBuffer() const { return m_commandBuffer != 0; }
+
+		//! Returns the number of recorded kernel launches.
+		size_t size() const { return m_nodes.size(); }
+
+		//! Returns the associated device controller.
+		DeviceController *getDeviceController() const { return m_devCon; }
+
+		//! Enqueues all recorded kernel launches (calls finalize() first if required).
+		/**
+		 * @param[in]     events  specify events that need to complete before the first launch can be executed.
+		 * @param[in,out] ev      if not 0, returns an event that completes when all launches have completed.
+		 */
+		void replay(const cl::vector<cl::Event> *events = 0, cl::Event *ev = 0);
+
+		//! Returns true if the device of \a devCon supports <tt>cl_khr_command_buffer</tt> in exactly the revision used by TBT.
+		static bool isCommandBufferSupported(DeviceController *devCon);
+	};
+
+}
+
+#endif
@@ -24,8 +24,18 @@ namespace tbt
 	protected:
 		cl::Buffer m_buffer;         //!< the allocated OpenCL buffer object.
 		index_t m_nElements;         //!< the number of elements in the array.
+		index_t m_offset;            //!< the index of the first element of the array in m_buffer.
 		DeviceController *m_devCon;  //!< the associated device controller.
 
+		std::shared_ptr<MemoryPool::Lease> m_lease;  //!< the lease of m_buffer from the memory pool (if any).
+
+		//! Throws an error if the array does not start at the beginning of m_buffer (see getBuffer()).
+		void checkNoOffset() const {
+			if(m_offset != 0)
+				throw Error("DeviceArray: slice does not start at an address aligned to the device's base address alignment; it cannot be used as buffer object.",
+					Error::ecMisalignedSubArray);
+		}
+
 	public:
 		//! The type for iterator differences.
 		typedef index_t difference_type;
@@ -46,10 +56,10 @@ namespace tbt
 		 * The constructed device array is neither associated with an OpenCL buffer object nor a
 		 * device controller. Hence, it cannot be used for loading or storing data.
 		 */
-		DeviceArray() : m_nElements(0), m_devCon(0) { }
+		DeviceArray() : m_nElements(0), m_offset(0), m_devCon(0) { }
 
 		//! Copy constructor. The constructed device array will share the OpenCL buffer object.
-		DeviceArray(const DeviceArray<T> &da) : m_buffer(da.m_buffer), m_nElements(da.m_nElements), m_devCon(da.m_devCon) { }
+		DeviceArray(const DeviceArray<T> &da) : m_buffer(da.m_buffer), m_nElements(da.m_nElements), m_offset(da.m_offset), m_devCon(da.m_devCon), m_lease(da.m_lease) { }
 
 		//! Constructs a device array for \a n elements of type \a T associated with device controller \a devCon.
 		/**
@@ -58,15 +68,34 @@ namespace tbt
 		 * @param[in] flags   are the memory flags (restricting the access of kernels to the corresponding device memory)
 		 *                    that will be used for creating the OpenCL buffer object; \a flags can be one of
 		 *                    CL_MEM_READ_WRITE, CL_MEM_READ_ONLY and CL_MEM_WRITE_ONLY.
+		 *
+		 * The buffer object is taken from the memory pool of \a devCon and returned to the pool once the
+		 * last device array sharing it is destroyed; hence, the buffer object may be larger than required.
+		 * The pool reuses the buffer only after the commands enqueued to the queues of \a devCon before
+		 * have completed, so a device array may be destroyed while commands using it are still pending.
+		 * The device array may also outlive \a devCon, but must not be used after \a devCon has been destroyed.
 		 */
 		DeviceArray(DeviceController *devCon, index_t n, cl_mem_flags flags = CL_MEM_READ_WRITE)
-			: m_buffer( devCon->getContext(), flags & (CL_MEM_READ_WRITE | CL_MEM_READ_ONLY | CL_MEM_WRITE_ONLY), n*sizeof(T) ),
-			  m_nElements(n),
-			  m_devCon(devCon)
-		{ }
+			: m_nElements(n),
+			  m_offset(0),
+			  m_devCon(devCon),
+			  m_lease( devCon->getMemoryPool().allocate(n*sizeof(T), flags & (CL_MEM_READ_WRITE | CL_MEM_READ_ONLY | CL_MEM_WRITE_ONLY)) )
+		{
+			m_buffer = m_lease->getBuffer();
+		}
 
 		//@}
 
+		//! Assignment operator. The device array will share the OpenCL buffer object of \a da.
+		DeviceArray<T> &operator=(const DeviceArray<T> &da) {
+			m_buffer    = da.m_buffer;
+			m_nElements = da.m_nElements;
+			m_offset    = da.m_offset;
+			m_devCon    = da.m_devCon;
+			m_lease     = da.m_lease;
+			return *this;
+		}
+
 
 		/** @name General Information
 		 * These methods provide access to the associated device controller and the created OpenCL buffer object,
@@ -84,15 +113,34 @@ namespace tbt
 
 		//! Returns the corresponding OpenCL buffer object.
 		/**
+		 * The buffer object starts with the first element of this device array, so it can be passed to kernels.
+		 * Throws an error with code Error::ecMisalignedSubArray if the device array is a slice with a non-zero
+		 * offset (see getOffset()), since the buffer object would then start at a different element.
+		 *
 		 * @return the OpenCL buffer object of this device array; will be invalid if the device array is invalid.
 		 */
-		cl::Buffer &getBuffer() { return m_buffer; }
+		cl::Buffer &getBuffer() {
+			checkNoOffset();
+			return m_buffer;
+		}
 
 		//! Converts a device array to an OpenCL buffer object.
 		/**
+		 * @see getBuffer()
+		 *
 		 * @return the OpenCL buffer object of this device array; will be invalid if the device array is invalid.
 		 */
-		operator cl::Buffer() { return m_buffer; }
+		operator cl::Buffer() {
+			checkNoOffset();
+			return m_buffer;
+		}
+
+		//! Returns the OpenCL buffer object containing the elements of this device array, starting at getOffset().
+		/**
+		 * Unlike getBuffer(), this method also works for slices with a non-zero offset; the caller must
+		 * add the offset to all positions in the buffer object (e.g., for transfers).
+		 */
+		const cl::Buffer &getBaseBuffer() const { return m_buffer; }
 
 		//! Returns the number of elements in the array.
 		/**
@@ -102,6 +150,48 @@ namespace tbt
 			return m_nElements;
 		}
 
+		//! Returns the index of the first element of this array in its OpenCL buffer object.
+		/**
+		 * The offset is 0 unless the device array is a slice that could not be represented by a
+		 * sub-buffer (see slice()). Such a device array cannot be passed to kernels.
+		 */
+		index_t getOffset() const {
+			return m_offset;
+		}
+
+		//@}
+
+
+		/** @name Slices
+		 */
+		//@{
+
+		//! Returns a device array representing the subarray [\a first, \a last) of this device array.
+		/**
+		 * The returned device array is a view sharing device memory with this device array; no data is copied.
+		 * If the position of \a first in device memory is a multiple of the device's base address alignment
+		 * (see DeviceController::getMemBaseAddrAlign()), the slice is backed by an OpenCL sub-buffer object and
+		 * can be passed to any kernel or algorithm. Otherwise, the slice shares the buffer object of this array
+		 * and getOffset() returns the index of its first element in the buffer object; such a slice supports
+		 * transfers, copies, fills and mappings, but getBuffer() throws an error with code Error::ecMisalignedSubArray,
+		 * so it cannot be passed to kernels.
+		 *
+		 * \pre \a first and \a last must be valid iterators pointing to this device array and \a first <= \a last.
+		 *
+		 * @param[in] first  is an iterator pointing to the first element in the slice.
+		 * @param[in] last   is an iterator pointing to the one-past-last element in the slice.
+		 * @return           a device array for the elements in [\a first, \a last).
+		 */
+		DeviceArray<T> slice(const_iterator first, const_iterator last) const {
+			return slice(first.getIndex(), last.getIndex());
+		}
+
+		//! Returns a device array representing the subarray of elements with indices in [\a first, \a last).
+		/**
+		 * @see slice(const_iterator,const_iterator) const
+		 */
+		DeviceArray<T> slice(index_t first, index_t last) const;
+
 		//@}
 
 
@@ -171,9 +261,11 @@ namespace tbt
 		 * transfer to the device is completed.
 		 *
 		 * @param[in] ptr  must point to an allocated region of memory that is large enough to store the whole array.
+		 * @param[in] queue  selects the command queue.
 		 */
-		void loadBlocking(const T *ptr) {
-			m_devCon->getCommandQueue().enqueueWriteBuffer(m_buffer, CL_TRUE, 0, m_nElements*sizeof(T), ptr);
+		void loadBlocking(const T *ptr, QueueId queue = qiCompute) {
+			m_devCon->enqueueOrderingBarrier(queue);
+			m_devCon->enqueueWriteBuffer(m_buffer, true, m_offset*sizeof(T), m_nElements*sizeof(T), ptr, 0, 0, queue);
 		}
 
 		//! Loads data from host array \a ha onto the device.
@@ -182,19 +274,22 @@ namespace tbt
 		 * transfer to the device is completed.
 		 *
 		 * @param[in] ha  must be a host array that is large enough to store the whole array.
+		 * @param[in] queue  selects the command queue.
 		 */
-		void loadBlocking(const HostArray<T> &ha) {
-			m_devCon->getCommandQueue().enqueueWriteBuffer(m_buffer, CL_TRUE, 0, m_nElements*sizeof(T), &ha[0]);
+		void loadBlocking(const HostArray<T> &ha, QueueId queue = qiCompute) {
+			m_devCon->enqueueOrderingBarrier(queue);
+			m_devCon->enqueueWriteBuffer(m_buffer, true, m_offset*sizeof(T), m_nElements*sizeof(T), &ha[0], 0, 0, queue);
 		}
 
 		//! Loads data from mapped array \a ma onto the device.
 		/**
-		 * This method enqueues a blocking write-buffer command. Once this method returns, the memory
-		 * transfer to the device is completed.
+		 * This method enqueues a blocking write-buffer command if \a ma is mapped, and a copy from the buffer
+		 * object of \a ma otherwise. Once this method returns, the memory transfer to the device is completed.
 		 *
 		 * @param[in] ma  must be a mapped array that is large enough to store the whole array.
+		 * @param[in] queue  selects the command queue.
 		 */
-		void loadBlocking(const MappedArray<T> &ma);
+		void loadBlocking(const MappedArray<T> &ma, QueueId queue = qiCompute);
 
 		//! Loads the subarray [\a first, \a last) from host memory to the subarray starting at \a firstSrc onto the device.
 		/**
@@ -210,10 +305,12 @@ namespace tbt
 		 * @param[in] first    is an iterator pointing to the first element in the subarray to be loaded.
 		 * @param[in] last     is an iterator pointing to the one-past-last element in the subarray to be loaded.
 		 * @param[in] firstSrc is an iterator pointing to the starting position, where the subarray is stored on the host.
+		 * @param[in] queue    selects the command queue.
 		 */
 		template<class _ITER>
-		void loadBlocking(iterator first, iterator last, _ITER firstSrc) {
-			m_devCon->getCommandQueue().enqueueWriteBuffer(m_buffer, CL_TRUE, first.m_index * sizeof(T), (last-first) * sizeof(T), &*firstSrc);
+		void loadBlocking(iterator first, iterator last, _ITER firstSrc, QueueId queue = qiCompute) {
+			m_devCon->enqueueOrderingBarrier(queue);
+			m_devCon->enqueueWriteBuffer(m_buffer, true, (m_offset + first.m_index) * sizeof(T), (last-first) * sizeof(T), &*firstSrc, 0, 0, queue);
 		}
 
 		//! Enqueues a command for loading data from a C-array \a ptr onto the device.
@@ -223,9 +320,11 @@ namespace tbt
 		 *
 		 * @param[in]     ptr         must point to an allocated region of memory that is large enough to store the whole array.
 		 * @param[in,out] eventLoad   if not 0, returns an event object that identifies the write command.
+		 * @param[in]     queue       selects the command queue.
+		 * @param[in]     events      if not 0, specifies events that need to complete before this command can be executed.
 		 */
-		void load(const T *ptr, cl::Event *eventLoad = 0) {
-			m_devCon->getCommandQueue().enqueueWriteBuffer(m_buffer, CL_FALSE, 0, m_nElements*sizeof(T), ptr, 0, eventLoad);
+		void load(const T *ptr, cl::Event *eventLoad = 0, QueueId queue = qiCompute, const cl::vector<cl::Event> *events = 0) {
+			m_devCon->enqueueWriteBuffer(m_buffer, false, m_offset*sizeof(T), m_nElements*sizeof(T), ptr, events, eventLoad, queue);
 		}
 
 		//! Enqueues a command for loading data from host array \a ha onto the device.
@@ -235,20 +334,25 @@ namespace tbt
 		 *
 		 * @param[in]     ha          must be a host array that is large enough to store the whole array.
 		 * @param[in,out] eventLoad   if not 0, returns an event object that identifies the write command.
+		 * @param[in]     queue       selects the command queue.
+		 * @param[in]     events      if not 0, specifies events that need to complete before this command can be executed.
 		 */
-		void load(const HostArray<T> &ha, cl::Event *eventLoad = 0) {
-			m_devCon->getCommandQueue().enqueueWriteBuffer(m_buffer, CL_FALSE, 0, m_nElements*sizeof(T), &ha[0], 0, eventLoad);
+		void load(const HostArray<T> &ha, cl::Event *eventLoad = 0, QueueId queue = qiCompute, const cl::vector<cl::Event> *events = 0) {
+			m_devCon->enqueueWriteBuffer(m_buffer, false, m_offset*sizeof(T), m_nElements*sizeof(T), &ha[0], events, eventLoad, queue);
 		}
 
 		//! Enqueues a command for loading data from mapped array \a ma onto the device.
 		/**
-		 * This method enqueues a non-blocking write-buffer command and returns an event object associated with
-		 * this write command that can be queried (or waited for).
+		 * This method enqueues a non-blocking write-buffer command if \a ma is mapped, and a copy from the buffer
+		 * object of \a ma otherwise, and returns an event object associated with this command that can be queried
+		 * (or waited for). \a ma must not be mapped or unmapped before the command has completed.
 		 *
 		 * @param[in]     ma          must be a mapped array that is large enough to store the whole array.
 		 * @param[in,out] eventLoad   if not 0, returns an event object that identifies the write command.
+		 * @param[in]     queue       selects the command queue.
+		 * @param[in]     events      if not 0, specifies events that need to complete before this command can be executed.
 		 */
-		void load(const MappedArray<T> &ma, cl::Event *eventLoad = 0);
+		void load(const MappedArray<T> &ma, cl::Event *eventLoad = 0, QueueId queue = qiCompute, const cl::vector<cl::Event> *events = 0);
 
 		//! Enqueues a command for loading the subarray [\a first, \a last) from host memory at \a firstSrc onto the device.
 		/**
@@ -265,12 +369,14 @@ namespace tbt
 		 * @param[in]     last       is an iterator pointing to the one-past-last element in the subarray to be loaded.
 		 * @param[in]     firstSrc   is an iterator pointing to the starting position, where the subarray is stored on the host.
 		 * @param[in,out] eventLoad  if not 0, returns an event object that identifies the write command.
+		 * @param[in]     queue      selects the command queue.
+		 * @param[in]     events     if not 0, specifies events that need to complete before this command can be executed.
 		 */
 		template<class _ITER>
-		void load(iterator first, iterator last, _ITER firstSrc, cl::Event *eventLoad = 0)
+		void load(iterator first, iterator last, _ITER firstSrc, cl::Event *eventLoad = 0, QueueId queue = qiCompute, const cl::vector<cl::Event> *events = 0)
 		{
-			m_devCon->getCommandQueue().enqueueWriteBuffer(m_buffer, CL_FALSE,
-				first.m_index * sizeof(T), (last-first) * sizeof(T), &*firstSrc, 0, eventLoad);
+			m_devCon->enqueueWriteBuffer(m_buffer, false,
+				(m_offset + first.m_index) * sizeof(T), (last-first) * sizeof(T), &*firstSrc, events, eventLoad, queue);
 		}
 
 		//@}
@@ -289,9 +395,11 @@ namespace tbt
 		 * transfer to the host is completed.
 		 *
 		 * @param[in,out] ptr  must point to an allocated region of memory that is large enough to hold the whole array.
+		 * @param[in]     queue  selects the command queue.
 		 */
-		void storeBlocking(T *ptr) {
-			m_devCon->getCommandQueue().enqueueReadBuffer(m_buffer, CL_TRUE, 0, m_nElements*sizeof(T), ptr);
+		void storeBlocking(T *ptr, QueueId queue = qiCompute) {
+			m_devCon->enqueueOrderingBarrier(queue);
+			m_devCon->enqueueReadBuffer(m_buffer, true, m_offset*sizeof(T), m_nElements*sizeof(T), ptr, 0, 0, queue);
 		}
 
 		//! Stores the data on the device in host array \a ha.
@@ -300,19 +408,22 @@ namespace tbt
 		 * transfer to the host is completed.
 		 *
 		 * @param[in,out] ha  must be a host array that is large enough to hold the whole array.
+		 * @param[in]     queue  selects the command queue.
 		 */
-		void storeBlocking(HostArray<T> &ha) {
-			m_devCon->getCommandQueue().enqueueReadBuffer(m_buffer, CL_TRUE, 0, m_nElements*sizeof(T), &ha[0]);
+		void storeBlocking(HostArray<T> &ha, QueueId queue = qiCompute) {
+			m_devCon->enqueueOrderingBarrier(queue);
+			m_devCon->enqueueReadBuffer(m_buffer, true, m_offset*sizeof(T), m_nElements*sizeof(T), &ha[0], 0, 0, queue);
 		}
 
 		//! Stores the data on the device in mapped array \a ma.
 		/**
-		 * This method enqueues a blocking read-buffer command. Once this method returns, the memory
-		 * transfer to the host is completed.
+		 * This method enqueues a blocking read-buffer command if \a ma is mapped, and a copy to the buffer
+		 * object of \a ma otherwise. Once this method returns, the memory transfer is completed.
 		 *
 		 * @param[in,out] ma  must be a mapped array that is large enough to hold the whole array.
+		 * @param[in]     queue  selects the command queue.
 		 */
-		void storeBlocking(MappedArray<T> &ma);
+		void storeBlocking(MappedArray<T> &ma, QueueId queue = qiCompute);
 
 		//! Stores the subarray [\a first, \a last) of this device array in host memory at \a firstSrc.
 		/**
@@ -328,10 +439,12 @@ namespace tbt
 		 * @param[in]     first       is an iterator pointing to the first element in the subarray to be stored.
 		 * @param[in]     last        is an iterator pointing to the one-past-last element in the subarray to be stored.
 		 * @param[in]     firstDst    is an iterator pointing to the starting position, where the subarray shall be stored.
+		 * @param[in]     queue       selects the command queue.
 		 */
 		template<class _ITER>
-		void storeBlocking(const_iterator first, const_iterator last, _ITER firstDst) {
-			m_devCon->getCommandQueue().enqueueReadBuffer(m_buffer, CL_TRUE, first.getIndex()*sizeof(T), (last-first)*sizeof(T), &*firstDst);
+		void storeBlocking(const_iterator first, const_iterator last, _ITER firstDst, QueueId queue = qiCompute) {
+			m_devCon->enqueueOrderingBarrier(queue);
+			m_devCon->enqueueReadBuffer(m_buffer, true, (m_offset + first.getIndex())*sizeof(T), (last-first)*sizeof(T), &*firstDst, 0, 0, queue);
 		}
 
 		//! Enqueues a command for storing the data on the device in C-array \a ptr.
@@ -341,9 +454,11 @@ namespace tbt
 		 *
 		 * @param[in,out] ptr          must point to an allocated region of memory that is large enough to hold the whole array.
 		 * @param[in,out] eventStore   if not 0, returns an event object that identifies the read command.
+		 * @param[in]     queue        selects the command queue.
+		 * @param[in]     events       if not 0, specifies events that need to complete before this command can be executed.
 		 */
-		void store(T *ptr, cl::Event *eventStore = 0) {
-			m_devCon->getCommandQueue().enqueueReadBuffer(m_buffer, CL_FALSE, 0, m_nElements*sizeof(T), ptr, 0, eventStore);
+		void store(T *ptr, cl::Event *eventStore = 0, QueueId queue = qiCompute, const cl::vector<cl::Event> *events = 0) {
+			m_devCon->enqueueReadBuffer(m_buffer, false, m_offset*sizeof(T), m_nElements*sizeof(T), ptr, events, eventStore, queue);
 		}
 
 		//! Enqueues a command for storing the data on the device in host array \a ha.
@@ -353,20 +468,25 @@ namespace tbt
 		 *
 		 * @param[in,out] ha           must be a host array that is large enough to hold the whole array.
 		 * @param[in,out] eventStore   if not 0, returns an event object that identifies the read command.
+		 * @param[in]     queue        selects the command queue.
+		 * @param[in]     events       if not 0, specifies events that need to complete before this command can be executed.
 		 */
-		void store(HostArray<T> &ha, cl::Event *eventStore = 0) {
-			m_devCon->getCommandQueue().enqueueReadBuffer(m_buffer, CL_FALSE, 0, m_nElements*sizeof(T), &ha[0], 0, eventStore);
+		void store(HostArray<T> &ha, cl::Event *eventStore = 0, QueueId queue = qiCompute, const cl::vector<cl::Event> *events = 0) {
+			m_devCon->enqueueReadBuffer(m_buffer, false, m_offset*sizeof(T), m_nElements*sizeof(T), &ha[0], events, eventStore, queue);
 		}
 
 		//! Enqueues a command for storing the data on the device in mapped array \a ma.
 		/**
-		 * This method enqueues a non-blocking read-buffer command and returns an event object associated with
-		 * this read command that can be queried (or waited for).
+		 * This method enqueues a non-blocking read-buffer command if \a ma is mapped, and a copy to the buffer
+		 * object of \a ma otherwise, and returns an event object associated with this command that can be queried
+		 * (or waited for). \a ma must not be mapped or unmapped before the command has completed.
 		 *
 		 * @param[in,out] ma           must be a mapped array that is large enough to hold the whole array.
 		 * @param[in,out] eventStore   if not 0, returns an event object that identifies the read command.
+		 * @param[in]     queue        selects the command queue.
+		 * @param[in]     events       if not 0, specifies events that need to complete before this command can be executed.
 		 */
-		void store(MappedArray<T> &ma, cl::Event *eventStore = 0);
+		void store(MappedArray<T> &ma, cl::Event *eventStore = 0, QueueId queue = qiCompute, const cl::vector<cl::Event> *events = 0);
 
 		//! Enqueues a command for storing the subarray [\a first, \a last) of this device array in host memory at \a firstSrc.
 		/**
@@ -383,10 +503,109 @@ namespace tbt
 		 * @param[in]     last        is an iterator pointing to the one-past-last element in the subarray to be stored.
 		 * @param[in]     firstDst    is an iterator pointing to the starting position, where the subarray shall be stored.
 		 * @param[in,out] eventStore  if not 0, returns an event object that identifies the write command.
+		 * @param[in]     queue       selects the command queue.
+		 * @param[in]     events      if not 0, specifies events that need to complete before this command can be executed.
 		 */
 		template<class _ITER>
-		void store(const_iterator first, const_iterator last, _ITER firstDst, cl::Event *eventStore = 0) {
-			m_devCon->getCommandQueue().enqueueReadBuffer(m_buffer, CL_FALSE, first.getIndex()*sizeof(T), (last-first)*sizeof(T), &*firstDst, 0, eventStore);
+		void store(const_iterator first, const_iterator last, _ITER firstDst, cl::Event *eventStore = 0, QueueId queue = qiCompute, const cl::vector<cl::Event> *events = 0) {
+			m_devCon->enqueueReadBuffer(m_buffer, false, (m_offset + first.getIndex())*sizeof(T), (last-first)*sizeof(T), &*firstDst, events, eventStore, queue);
+		}
+
+		//@}
+
+
+		/** @name Copying and Filling Device Memory
+		 * These methods copy data between device arrays or fill a device array with a value without
+		 * transfering any data between host and device. The suffix <strong>Blocking</strong> indicates
+		 * that the operation is already completed once the method returns; the other methods just enqueue
+		 * a command (an event object can be used to wait for completion).
+		 */
+		//@{
+
+		//! Copies the elements of device array \a src to this device array.
+		/**
+		 * This method enqueues a copy-buffer command and waits for its completion.
+		 *
+		 * @param[in] src  must be a device array on the same device with at least size() elements.
+		 * @param[in] queue  selects the command queue.
+		 */
+		void copyBlocking(const DeviceArray<T> &src, QueueId queue = qiCompute) {
+			cl::Event ev;
+			m_devCon->enqueueOrderingBarrier(queue);
+			copy(src, &ev, queue);
+			ev.wait();
+		}
+
+		//! Enqueues a command for copying the elements of device array \a src to this device array.
+		/**
+		 * @param[in]     src        must be a device array on the same device with at least size() elements.
+		 * @param[in,out] eventCopy  if not 0, returns an event object that identifies the copy command.
+		 * @param[in]     queue      selects the command queue.
+		 * @param[in]     events     if not 0, specifies events that need to complete before this command can be executed.
+		 */
+		void copy(const DeviceArray<T> &src, cl::Event *eventCopy = 0, QueueId queue = qiCompute, const cl::vector<cl::Event> *events = 0) {
+			m_devCon->enqueueCopyBuffer(src.m_buffer, m_buffer, src.m_offset*sizeof(T), m_offset*sizeof(T), m_nElements*sizeof(T), events, eventCopy, queue);
+		}
+
+		//! Enqueues a command for copying the subarray starting at \a firstSrc of another device array to [\a first, \a last).
+		/**
+		 * The command copies \ m := \a last-\a first elements in [\a firstSrc, \a firstSrc+\ m) to [\a first, \a last)
+		 * in this device array. If the source is this device array, the two ranges must not overlap.
+		 *
+		 * \pre \a first and \a last must be valid iterators pointing to this device array, and
+		 *      \a firstSrc must be a valid iterator pointing to a device array on the same device.
+		 *
+		 * @param[in]     first      is an iterator pointing to the first element in the target subarray.
+		 * @param[in]     last       is an iterator pointing to the one-past-last element in the target subarray.
+		 * @param[in]     firstSrc   is an iterator pointing to the first element in the source subarray.
+		 * @param[in,out] eventCopy  if not 0, returns an event object that identifies the copy command.
+		 * @param[in]     queue      selects the command queue.
+		 * @param[in]     events     if not 0, specifies events that need to complete before this command can be executed.
+		 */
+		void copy(iterator first, iterator last, const_iterator firstSrc, cl::Event *eventCopy = 0, QueueId queue = qiCompute, const cl::vector<cl::Event> *events = 0) {
+			const DeviceArray<T> *src = firstSrc.getDeviceArray();
+			m_devCon->enqueueCopyBuffer(src->m_buffer, m_buffer, (src->m_offset + firstSrc.getIndex())*sizeof(T),
+				(m_offset + first.m_index)*sizeof(T), (last-first)*sizeof(T), events, eventCopy, queue);
+		}
+
+		//! Sets all elements of this device array to \a value.
+		/**
+		 * This method enqueues a fill command (see DeviceController::enqueueFillBuffer()) and waits for its completion.
+		 *
+		 * @param[in] value  is the value assigned to all elements.
+		 * @param[in] queue  selects the command queue.
+		 */
+		void fillBlocking(const T &value, QueueId queue = qiCompute) {
+			cl::Event ev;
+			m_devCon->enqueueOrderingBarrier(queue);
+			fill(value, &ev, queue);
+			ev.wait();
+		}
+
+		//! Enqueues a command for setting all elements of this device array to \a value.
+		/**
+		 * @param[in]     value      is the value assigned to all elements.
+		 * @param[in,out] eventFill  if not 0, returns an event object that identifies the fill command.
+		 * @param[in]     queue      selects the command queue.
+		 * @param[in]     events     if not 0, specifies events that need to complete before this command can be executed.
+		 */
+		void fill(const T &value, cl::Event *eventFill = 0, QueueId queue = qiCompute, const cl::vector<cl::Event> *events = 0) {
+			m_devCon->enqueueFillBuffer(m_buffer, &value, sizeof(T), m_offset*sizeof(T), m_nElements*sizeof(T), events, eventFill, queue);
+		}
+
+		//! Enqueues a command for setting all elements in [\a first, \a last) to \a value.
+		/**
+		 * \pre \a first and \a last must be valid iterators pointing to this device array.
+		 *
+		 * @param[in]     first      is an iterator pointing to the first element to be set.
+		 * @param[in]     last       is an iterator pointing to the one-past-last element to be set.
+		 * @param[in]     value      is the value assigned to the elements.
+		 * @param[in,out] eventFill  if not 0, returns an event object that identifies the fill command.
+		 * @param[in]     queue      selects the command queue.
+		 * @param[in]     events     if not 0, specifies events that need to complete before this command can be executed.
+		 */
+		void fill(iterator first, iterator last, const T &value, cl::Event *eventFill = 0, QueueId queue = qiCompute, const cl::vector<cl::Event> *events = 0) {
+			m_devCon->enqueueFillBuffer(m_buffer, &value, sizeof(T), (m_offset + first.m_index)*sizeof(T), (last-first)*sizeof(T), events, eventFill, queue);
 		}
 
 		//@}
@@ -634,6 +853,9 @@ namespace tbt
 		 */
 		_DeviceArrayIterator(index_t index, DeviceArray<T> *devArray) : m_index(index), m_devArray(devArray) { }
 
+		//! Returns the index of the position in the device array this iterator points to.
+		index_t getIndex() const { return m_index; }
+
 	public:
 		//! Shorthand for this iterator type.
 		typedef _DeviceArrayIterator<T> _MyIter;
@@ -672,7 +894,7 @@ namespace tbt
 		/**
 		 * Returns 0 if this is an invalid iterator.
 		 */
-		DeviceArray<T> *getDeviceArray() { return m_devArray; }
+		DeviceArray<T> *getDeviceArray() const { return m_devArray; }
 
 		//@}
 
@@ -857,34 +1079,98 @@ namespace tbt
 	template<class T> inline
 	typename DeviceArray<T>::const_iterator DeviceArray<T>::at(index_t i) const { return const_iterator(i,this); }
 
+
+	template<class T>
+	DeviceArray<T> DeviceArray<T>::slice(index_t first, index_t last) const
+	{
+		DeviceArray<T> da(*this);
+		da.m_nElements = last - first;
+		da.m_offset    = m_offset + first;
+
+		// sub-buffers cannot be nested, so create the sub-buffer in the parent of m_buffer (if any)
+		cl_mem parent = 0;
+		clGetMemObjectInfo(m_buffer(), CL_MEM_ASSOCIATED_MEMOBJECT, sizeof(cl_mem), &parent, 0);
+
+		size_t origin = da.m_offset * sizeof(T);
+		if(parent != 0) {
+			size_t bufferOrigin = 0;
+			clGetMemObjectInfo(m_buffer(), CL_MEM_OFFSET, sizeof(size_t), &bufferOrigin, 0);
+			origin += bufferOrigin;
+		}
+
+		const size_t align = m_devCon->getMemBaseAddrAlign() >> 3;
+		if(last > first && origin % align == 0) {
+			cl::Buffer base;
+			if(parent != 0) {
+				clRetainMemObject(parent);
+				base = cl::Buffer(parent);
+			} else
+				base = m_buffer;
+
+			cl_mem_flags flags = base.getInfo<CL_MEM_FLAGS>() & (CL_MEM_READ_WRITE | CL_MEM_READ_ONLY | CL_MEM_WRITE_ONLY);
+
+			cl_buffer_region region;
+			region.origin = origin;
+			region.size   = da.m_nElements * sizeof(T);
+
+			da.m_buffer = base.createSubBuffer(flags, CL_BUFFER_CREATE_TYPE_REGION, &region);
+			da.m_offset = 0;
+		}
+
+		return da;
+	}
+
 }
 
 #include <tbt/MappedArray.h>
 
 namespace tbt {
 
+	// If the mapped array is mapped, its host memory holds the current data; otherwise, the data is
+	// copied from or to its buffer object on the device (the host pointer is not valid then).
+
 	template<class T> inline
-	void DeviceArray<T>::loadBlocking(const MappedArray<T> &ma)
+	void DeviceArray<T>::loadBlocking(const MappedArray<T> &ma, QueueId queue)
 	{
-		m_devCon->getCommandQueue().enqueueWriteBuffer(m_buffer, CL_TRUE, 0, m_nElements*sizeof(T), &ma[0]);
+		m_devCon->enqueueOrderingBarrier(queue);
+		if(ma.isMapped())
+			m_devCon->enqueueWriteBuffer(m_buffer, true, m_offset*sizeof(T), m_nElements*sizeof(T), &ma[0], 0, 0, queue);
+		else {
+			cl::Event ev;
+			m_devCon->enqueueCopyBuffer(ma.getBaseBuffer(), m_buffer, 0, m_offset*sizeof(T), m_nElements*sizeof(T), 0, &ev, queue);
+			ev.wait();
+		}
 	}
 
 	template<class T> inline
-	void DeviceArray<T>::load(const MappedArray<T> &ma, cl::Event *eventLoad)
+	void DeviceArray<T>::load(const MappedArray<T> &ma, cl::Event *eventLoad, QueueId queue, const cl::vector<cl::Event> *events)
 	{
-		m_devCon->getCommandQueue().enqueueWriteBuffer(m_buffer, CL_FALSE, 0, m_nElements*sizeof(T), &ma[0], 0, eventLoad);
+		if(ma.isMapped())
+			m_devCon->enqueueWriteBuffer(m_buffer, false, m_offset*sizeof(T), m_nElements*sizeof(T), &ma[0], events, eventLoad, queue);
+		else
+			m_devCon->enqueueCopyBuffer(ma.getBaseBuffer(), m_buffer, 0, m_offset*sizeof(T), m_nElements*sizeof(T), events, eventLoad, queue);
 	}
 
 	template<class T> inline
-	void DeviceArray<T>::storeBlocking(MappedArray<T> &ma)
+	void DeviceArray<T>::storeBlocking(MappedArray<T> &ma, QueueId queue)
 	{
-		m_devCon->getCommandQueue().enqueueReadBuffer(m_buffer, CL_TRUE, 0, m_nElements*sizeof(T), &ma[0]);
+		m_devCon->enqueueOrderingBarrier(queue);
+		if(ma.isMapped())
+			m_devCon->enqueueReadBuffer(m_buffer, true, m_offset*sizeof(T), m_nElements*sizeof(T), &ma[0], 0, 0, queue);
+		else {
+			cl::Event ev;
+			m_devCon->enqueueCopyBuffer(m_buffer, ma.getBaseBuffer(), m_offset*sizeof(T), 0, m_nElements*sizeof(T), 0, &ev, queue);
+			ev.wait();
+		}
 	}
 
 	template<class T> inline
-	void DeviceArray<T>::store(MappedArray<T> &ma, cl::Event *eventStore = 0)
+	void DeviceArray<T>::store(MappedArray<T> &ma, cl::Event *eventStore, QueueId queue, const cl::vector<cl::Event> *events)
 	{
-		m_devCon->getCommandQueue().enqueueReadBuffer(m_buffer, CL_FALSE, 0, m_nElements*sizeof(T), &ma[0], 0, eventStore);
+		if(ma.isMapped())
+			m_devCon->enqueueReadBuffer(m_buffer, false, m_offset*sizeof(T), m_nElements*sizeof(T), &ma[0], events, eventStore, queue);
+		else
+			m_devCon->enqueueCopyBuffer(m_buffer, ma.getBaseBuffer(), m_offset*sizeof(T), 0, m_nElements*sizeof(T), events, eventStore, queue);
 	}
 
 }
@@ -0,0 +1,89 @@
+#ifndef _TBT_DEVICE_CHARACTERISTICS_H
+#define _TBT_DEVICE_CHARACTERISTICS_H
+
+#include <tbt/tbthc.h>
+
+#include <algorithm>
+
+
+namespace tbt
+{
+
+	class DeviceController;
+
+	//! Measured performance characteristics of a device.
+	/**
+	 * The characteristics are determined by a few short micro-benchmarks (see measure()), which take
+	 * a fraction of a second. Algorithms use them for choosing work-group counts and strategies instead of
+	 * hard-coded thresholds. Usually, the characteristics are not measured directly but determined once per
+	 * device controller by DeviceController::characterize(), which caches them on disk, and obtained with
+	 * DeviceController::getCharacteristics().
+	 *
+	 * All values are 0 if the characteristics have not been measured (see isValid()).
+	 *
+	 * \ingroup context
+	 */
+	struct DeviceCharacteristics
+	{
+		double  m_globalBandwidth;      //!< bandwidth of a copy kernel in global memory (in GB/s, counting read and written bytes).
+		cl_uint m_saturationWorkItems;  //!< smallest number of work-items achieving at least 80% of m_globalBandwidth.
+		double  m_localBandwidth;       //!< bandwidth of reading local memory (in GB/s).
+		double  m_atomicsThroughput;    //!< throughput of atomic additions in global memory (in million operations per second).
+		double  m_launchLatency;        //!< time for launching an empty kernel and waiting for its completion (in microseconds).
+
+		//! Constructs invalid characteristics (all values 0).
+		DeviceCharacteristics()
+			: m_globalBandwidth(0), m_saturationWorkItems(0), m_localBandwidth(0), m_atomicsThroughput(0), m_launchLatency(0) { }
+
+		//! Returns true if the characteristics have been measured.
+		bool isValid() const { return m_globalBandwidth > 0 && m_saturationWorkItems > 0; }
+
+		//! Returns the estimated global memory bandwidth (in GB/s) of a kernel with \a workItems work-items.
+		/**
+		 * The bandwidth grows linearly with the number of work-items until m_saturationWorkItems is reached.
+		 */
+		double getBandwidth(size_t workItems) const {
+			return m_globalBandwidth * std::min(1.0, (double)workItems / m_saturationWorkItems);
+		}
+
+		//! Returns the estimated time (in microseconds) for moving \a bytes bytes in global memory with \a workItems work-items.
+		double estimateTransferTime(double bytes, size_t workItems) const {
+			return bytes / (1.e3 * getBandwidth(workItems));
+		}
+
+		//! Measures the characteristics of the device of \a devCon.
+		/**
+		 * The micro-benchmarks use a private command queue on the device of \a devCon, so they neither wait for
+		 * commands pending in the queues of \a devCon nor are counted or profiled by the device controller.
+		 * Commands running concurrently on the device distort the results.
+		 *
+		 * @param[in] devCon  is the device controller.
+		 * @return            the measured characteristics.
+		 */
+		static DeviceCharacteristics measure(DeviceController *devCon);
+
+		//! Reads characteristics from file \a fileName.
+		/**
+		 * @param[in] fileName  is the name of the file (written by save()).
+		 * @param[in] devCon    is the device controller; the file is rejected if it has been written for another
+		 *                      device or driver version.
+		 * @return              true if the characteristics could be read, false otherwise.
+		 */
+		bool load(const char *fileName, const DeviceController *devCon);
+
+		//! Writes the characteristics to file \a fileName.
+		/**
+		 * @param[in] fileName  is the name of the file.
+		 * @param[in] devCon    is the device controller whose device has been characterized.
+		 * @return              true if the file could be written, false otherwise.
+		 */
+		bool save(const char *fileName, const DeviceController *devCon) const;
+
+		//! Displays the characteristics on output stream \a os.
+		std::ostream &displayInfo(std::ostream &os = std::cout) const;
+	};
+
+}
+
+
+#endif
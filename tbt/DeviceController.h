@@ -3,6 +3,11 @@
 #define _TBT_DEVICE_CONTROLLER_H
 
 #include <tbt/tbthc.h>
+#include <tbt/MemoryPool.h>
+#include <tbt/DeviceCounters.h>
+#include <tbt/DeviceCharacteristics.h>
+
+#include <atomic>
 
 
 namespace tbt
@@ -10,9 +15,58 @@ namespace tbt
 
 #define TBT_NUM_EXTENSION_STRINGS 8
 
-	//! Device controller encapsulating a device with a command queue.
+	//! Identifies one of the command queues of a device controller.
 	/**
 	 * \ingroup context
+	 */
+	enum QueueId {
+		qiCompute,   //!< the default queue; used for kernels and for all commands without an explicit queue.
+		qiUpload,    //!< a queue for host-to-device transfers.
+		qiDownload   //!< a queue for device-to-host transfers.
+	};
+
+#define TBT_NUM_QUEUES 3   //!< The number of command queues of a device controller.
+
+	class Profiler;
+
+	//! Device controller encapsulating a device with its command queues.
+	/**
+	 * \ingroup context
+	 *
+	 * \section dev_queues Command Queues
+	 *
+	 * A device controller owns several in-order command queues for its device, identified by QueueId.
+	 * All commands are enqueued to the compute queue (qiCompute) unless another queue is passed explicitly.
+	 * Commands in different queues may execute concurrently, e.g., on devices with separate copy engines
+	 * transfers in the upload and download queues overlap with kernels in the compute queue. Commands in
+	 * different queues are not ordered with respect to each other, hence they must be synchronized with events.
+	 *
+	 * If the queues are created with <tt>CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE</tt>, commands in the same queue are
+	 * not ordered either. All non-blocking methods of TBT accept an event wait list for expressing dependencies,
+	 * and algorithms order their own commands by events. Blocking methods enqueue a barrier first (see
+	 * enqueueOrderingBarrier()), so they observe all previously enqueued commands as with in-order queues.
+	 *
+	 * Sequences of kernel launches that are enqueued repeatedly with the same arguments can be recorded once
+	 * in a CommandGraph and replayed with a single call.
+	 *
+	 * \section dev_counters Counters
+	 *
+	 * A device controller counts the bytes transferred to and from the device, the bytes mapped, the launched kernels,
+	 * and the bytes of live buffer objects with their high-water mark (see getCounters()). Counting is always enabled.
+	 *
+	 * \section dev_characteristics Characteristics
+	 *
+	 * Algorithms choose work-group counts and strategies based on measured characteristics of the device, like the
+	 * global memory bandwidth and the kernel launch latency (see getCharacteristics()). The characteristics are determined
+	 * by characterize(), which createContext() calls for all devices if enabled (see Global::setCharacterizeDevices()). Measuring
+	 * takes a fraction of a second; the results are stored in the program cache directory if binaries are cached (see
+	 * Global::setCacheProgramBinaries()), so they are measured only once per device and driver version.
+	 *
+	 * \section dev_profiling Profiling
+	 *
+	 * All commands enqueued through a device controller (kernels, transfers, copies, fills, maps and unmaps) can be
+	 * recorded by a Profiler attached with setProfiler(). This includes the commands of device arrays, device structs,
+	 * mapped arrays and mapped structs, which use the enqueue methods of their device controller.
 	 *
 	 * \section dev_info Device Information
 	 *
@@ -117,9 +171,18 @@ namespace tbt
 	 */
 	class DeviceController
 	{
-		cl::Device       m_device;  //!< the associated device.
-		cl::Context      m_context; //!< the associated context.
-		cl::CommandQueue m_queue;   //!< the command queue for device in context.
+		cl::Device       m_device;      //!< the associated device.
+		cl::Context      m_context;     //!< the associated context.
+		cl::CommandQueue m_queue[TBT_NUM_QUEUES];  //!< the command queues for device in context.
+		cl_command_queue_properties m_queueProperties;  //!< the properties of the command queues.
+		std::shared_ptr<DeviceCounters> m_counters;  //!< the transfer, kernel and memory counters.
+		std::shared_ptr<MemoryPool> m_memoryPool;  //!< the pool for buffer objects on the device (kept alive by leases).
+		std::atomic<Profiler*> m_profiler;  //!< the attached profiler (or 0); read once per enqueued command.
+		bool             m_forceFillKernel;  //!< shall fills always use the fill kernel?
+
+		DeviceCharacteristics m_characteristics;      //!< the measured characteristics (valid if m_characterized is set).
+		std::once_flag        m_characteristicsFlag;  //!< ensures that the characteristics are determined only once.
+		std::atomic<bool>     m_characterized;        //!< have the characteristics been determined?
 
 		cl_device_type              m_deviceType;             //!< the type of the associated device.
 		cl_uint                     m_maxComputeUnits;        //!< the number of parallel compute units on the associated device.
@@ -138,6 +201,7 @@ namespace tbt
 		cl_device_exec_capabilities m_execCapabilities;       //!< the execution capabilities of the associated device.
 
 		cl_uint m_supportedExtensions;  //!< a bitvector specifiying the supported OpenCL extensions (as defined by TBT).
+		cl_uint m_versionNumber;        //!< the supported OpenCL version as number (100*major + 10*minor).
 
 		int m_extString[TBT_NUM_EXT];
 
@@ -145,6 +209,10 @@ namespace tbt
 		static cl_uint     s_valExtension[TBT_NUM_EXTENSION_STRINGS];
 		static const char *s_defineExtension[TBT_NUM_EXT];
 
+		//! Enqueues a fill command or kernel (see enqueueFillBuffer()); does not record the command.
+		void enqueueFill(const cl::Buffer &buffer, const void *pattern, size_t patternSize, size_t offset, size_t size,
+			const cl::vector<cl::Event> *events, cl::Event *ev, QueueId queue);
+
 	public:
 		/** @name Constructor
 		 *  Device controllers are usually constructed by the class Global when creating a global context,
@@ -160,6 +228,9 @@ namespace tbt
 		 */
 		DeviceController(cl::Device device, cl::Context context, cl_command_queue_properties properties = 0);
 
+		//! Destructor. Device arrays still alive keep the memory pool alive, but their buffers are not cached anymore.
+		~DeviceController();
+
 		//@}
 
 
@@ -175,11 +246,12 @@ namespace tbt
 		 */
 		cl::Device getDevice() const { return m_device; }
 
-		//! Returns the command queue.
+		//! Returns the command queue \a queue.
 		/**
-		 * @return the command queue of this device controller.
+		 * @param[in] queue  selects the command queue.
+		 * @return the selected command queue of this device controller.
 		 */
-		cl::CommandQueue getCommandQueue() { return m_queue; }
+		cl::CommandQueue getCommandQueue(QueueId queue = qiCompute) { return m_queue[queue]; }
 
 		//! Returns the properties of the command queue associated with this device controller.
 		/**
@@ -187,12 +259,65 @@ namespace tbt
 		 */
 		cl_command_queue_properties getCommandQueueProperties() const;
 
+		//! Returns true if the command queues execute commands out-of-order.
+		bool isOutOfOrder() const { return (m_queueProperties & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) != 0; }
+
 		//! Returns the associated OpenCL context.
 		/**
 		 * @return the context associated with this device controller.
 		 */
 		cl::Context getContext() const { return m_context; }
 
+		//! Returns the memory pool for buffer objects on the associated device.
+		/**
+		 * Device arrays allocate their buffer objects from this pool, so it can be used to query
+		 * statistics, to release cached buffers (MemoryPool::trim()), or to disable caching.
+		 */
+		MemoryPool &getMemoryPool() { return *m_memoryPool; }
+
+		//! Returns the transfer, kernel and memory counters of this device controller.
+		/**
+		 * The counters are updated by all enqueue methods of this device controller (and hence by device arrays,
+		 * device structs, mapped arrays and mapped structs) and track all buffer objects created by them.
+		 */
+		DeviceCounters &getCounters() { return *m_counters; }
+
+		//! Returns the current values of the counters of this device controller.
+		DeviceCounters::Values getCounterValues() const { return m_counters->getValues(); }
+
+		//! Resets the counters of this device controller (see DeviceCounters::reset()).
+		void resetCounters() { m_counters->reset(); }
+
+		//! Attaches \a profiler to this device controller (or detaches the current profiler if \a profiler is 0).
+		/**
+		 * The profiler records all subsequently enqueued commands; it must not be destroyed while attached.
+		 * Profiling information is only available if the command queues have been created with
+		 * <tt>CL_QUEUE_PROFILING_ENABLE</tt>. The profiler may be attached or detached while other threads
+		 * enqueue commands; a command enqueued concurrently with setProfiler() may be recorded by either
+		 * profiler, so a detached profiler must not be destroyed before such commands have been enqueued.
+		 */
+		void setProfiler(Profiler *profiler) { m_profiler = profiler; }
+
+		//! Returns the attached profiler (or 0 if no profiler is attached).
+		Profiler *getProfiler() const { return m_profiler; }
+
+		//! Determines the characteristics of the associated device (see getCharacteristics()).
+		/**
+		 * The characteristics are read from the program cache directory or measured with a private command queue;
+		 * only the first call has an effect (thread-safe). The command queues of this device controller are neither
+		 * used nor waited for. Results measured while commands of this device controller were pending or enqueued
+		 * are used, but not stored in the program cache directory, since they may be distorted.
+		 */
+		void characterize();
+
+		//! Returns the characteristics of the associated device.
+		/**
+		 * The returned characteristics are invalid (see DeviceCharacteristics::isValid()) if characterize() has not
+		 * completed or the characteristics could not be measured; algorithms then fall back to default strategies.
+		 * This method never measures itself, so it can be called while commands are pending.
+		 */
+		const DeviceCharacteristics &getCharacteristics() const;
+
 		//@}
 
 
@@ -375,6 +500,13 @@ namespace tbt
 		 */
 		std::string getVersion() const;
 
+		//! Returns the OpenCL version supported by the associated device as number.
+		/**
+		 * @return the supported OpenCL version encoded as 100*<i>major</i> + 10*<i>minor</i>, e.g., 120 for OpenCL 1.2;
+		 *         versions not supported by the OpenCL headers TBT has been compiled with are capped accordingly.
+		 */
+		cl_uint getVersionNumber() const { return m_versionNumber; }
+
 		//! Returns the highest OpenCL C version supported by the compiler for the associated device.
 		/**
 		 * @return the highest OpenCL C version (CL_DEVICE_OPENCL_C_VERSION) supported by the compiler
@@ -437,9 +569,9 @@ namespace tbt
 		//@}
 
 
-		/** @name Command Queue
-		 *  These methods enqueue commands to the command queue for the device associated with this
-		 *  device controller, or perform a flush or finish on this command queue.
+		/** @name Command Queues
+		 *  These methods enqueue commands to one of the command queues for the device associated with this
+		 *  device controller (the compute queue by default), or perform a flush or finish on the command queues.
 		 */
 		//@{
 
@@ -460,13 +592,15 @@ namespace tbt
 		 *                            instance. If event is 0 (the default), no event will be created for this kernel
 		 *                            execution instance and therefore it will not be possible to query or queue a
 		 *                            wait for this kernel execution instance.
+		 * @param[in]     queue       selects the command queue.
 		 */
 		void enqueue1DRangeKernel(
 			const cl::Kernel &kernel,
 			size_t globalWork,
 			size_t localWork = 0,
 			const cl::vector<cl::Event> *events = 0,
-			cl::Event *ev = 0);
+			cl::Event *ev = 0,
+			QueueId queue = qiCompute);
 
 		//! Enqueues a command to execute a kernel on this device.
 		/**
@@ -479,20 +613,189 @@ namespace tbt
 		 *                            instance. If event is 0 (the default), no event will be created for this kernel
 		 *                            execution instance and therefore it will not be possible to query or queue a
 		 *                            wait for this kernel execution instance.
+		 * @param[in]     queue       selects the command queue.
 		 */
 		void enqueueTask(
 			const cl::Kernel &kernel,
 			const cl::vector<cl::Event> *events = 0,
-			cl::Event *ev = 0)
-		{
-			m_queue.enqueueTask(kernel, events, ev);
+			cl::Event *ev = 0,
+			QueueId queue = qiCompute);
+
+		//! Enqueues a command to copy \a size bytes from buffer \a src to buffer \a dst.
+		/**
+		 * @param[in]     src         is the source buffer object.
+		 * @param[in]     dst         is the destination buffer object.
+		 * @param[in]     srcOffset   is the offset (in bytes) in \a src where copying starts.
+		 * @param[in]     dstOffset   is the offset (in bytes) in \a dst where copying starts.
+		 * @param[in]     size        is the number of bytes to copy; the source and destination regions
+		 *                            must not overlap if \a src and \a dst are the same buffer.
+		 * @param[in]     events      specify events that need to complete before this command can be executed.
+		 * @param[in,out] ev          if not 0, returns an event object that identifies this copy command.
+		 * @param[in]     queue       selects the command queue.
+		 */
+		void enqueueCopyBuffer(
+			const cl::Buffer &src,
+			const cl::Buffer &dst,
+			size_t srcOffset,
+			size_t dstOffset,
+			size_t size,
+			const cl::vector<cl::Event> *events = 0,
+			cl::Event *ev = 0,
+			QueueId queue = qiCompute);
+
+		//! Enqueues a command to write \a size bytes from host memory \a ptr to \a buffer.
+		/**
+		 * @param[in]     buffer      is the buffer object to be written.
+		 * @param[in]     blocking    if true, the method returns when the data has been written and \a ptr can be reused.
+		 * @param[in]     offset      is the offset (in bytes) in \a buffer where writing starts.
+		 * @param[in]     size        is the number of bytes to write.
+		 * @param[in]     ptr         points to the data in host memory.
+		 * @param[in]     events      specify events that need to complete before this command can be executed.
+		 * @param[in,out] ev          if not 0, returns an event object that identifies this write command.
+		 * @param[in]     queue       selects the command queue.
+		 */
+		void enqueueWriteBuffer(
+			const cl::Buffer &buffer,
+			bool blocking,
+			size_t offset,
+			size_t size,
+			const void *ptr,
+			const cl::vector<cl::Event> *events = 0,
+			cl::Event *ev = 0,
+			QueueId queue = qiCompute);
+
+		//! Enqueues a command to read \a size bytes from \a buffer to host memory \a ptr.
+		/**
+		 * @param[in]     buffer      is the buffer object to be read.
+		 * @param[in]     blocking    if true, the method returns when the data has been read into \a ptr.
+		 * @param[in]     offset      is the offset (in bytes) in \a buffer where reading starts.
+		 * @param[in]     size        is the number of bytes to read.
+		 * @param[out]    ptr         points to the destination in host memory.
+		 * @param[in]     events      specify events that need to complete before this command can be executed.
+		 * @param[in,out] ev          if not 0, returns an event object that identifies this read command.
+		 * @param[in]     queue       selects the command queue.
+		 */
+		void enqueueReadBuffer(
+			const cl::Buffer &buffer,
+			bool blocking,
+			size_t offset,
+			size_t size,
+			void *ptr,
+			const cl::vector<cl::Event> *events = 0,
+			cl::Event *ev = 0,
+			QueueId queue = qiCompute);
+
+		//! Enqueues a command to map a region of \a buffer into host memory.
+		/**
+		 * @param[in]     buffer      is the buffer object to be mapped.
+		 * @param[in]     blocking    if true, the method returns when the region has been mapped.
+		 * @param[in]     flags       are the map flags (<tt>CL_MAP_READ</tt> and/or <tt>CL_MAP_WRITE</tt>).
+		 * @param[in]     offset      is the offset (in bytes) in \a buffer of the mapped region.
+		 * @param[in]     size        is the size (in bytes) of the mapped region.
+		 * @param[in]     events      specify events that need to complete before this command can be executed.
+		 * @param[in,out] ev          if not 0, returns an event object that identifies this map command.
+		 * @param[in]     queue       selects the command queue.
+		 * @return                    a pointer to the mapped region.
+		 */
+		void *enqueueMapBuffer(
+			const cl::Buffer &buffer,
+			bool blocking,
+			cl_map_flags flags,
+			size_t offset,
+			size_t size,
+			const cl::vector<cl::Event> *events = 0,
+			cl::Event *ev = 0,
+			QueueId queue = qiCompute);
+
+		//! Enqueues a command to unmap a region of \a memObject previously mapped to \a ptr.
+		/**
+		 * @param[in]     memObject   is the memory object.
+		 * @param[in]     ptr         is the host address returned by the map command.
+		 * @param[in]     size        is the size (in bytes) of the mapped region (only used for profiling).
+		 * @param[in]     events      specify events that need to complete before this command can be executed.
+		 * @param[in,out] ev          if not 0, returns an event object that identifies this unmap command.
+		 * @param[in]     queue       selects the command queue.
+		 */
+		void enqueueUnmapMemObject(
+			const cl::Memory &memObject,
+			void *ptr,
+			size_t size,
+			const cl::vector<cl::Event> *events = 0,
+			cl::Event *ev = 0,
+			QueueId queue = qiCompute);
+
+		//! Enqueues a command to fill \a size bytes of \a buffer with a repeated pattern.
+		/**
+		 * Uses clEnqueueFillBuffer on OpenCL 1.2 devices if \a patternSize is a power of two (unless the fill
+		 * kernel is forced, see setForceFillKernel()); otherwise, a fill kernel is launched. The kernel fallback supports patterns of up to 64 bytes
+		 * and is built for each device; its launch is counted as a kernel (see getCounters()). The profiler records either as a fill.
+		 *
+		 * @param[in]     buffer       is the buffer object to be filled.
+		 * @param[in]     pattern      points to the pattern.
+		 * @param[in]     patternSize  is the size of the pattern in bytes.
+		 * @param[in]     offset       is the offset (in bytes) in \a buffer where filling starts; must be a multiple of \a patternSize.
+		 * @param[in]     size         is the number of bytes to fill; must be a multiple of \a patternSize.
+		 * @param[in]     events       specify events that need to complete before this command can be executed.
+		 * @param[in,out] ev           if not 0, returns an event object that identifies this fill command.
+		 * @param[in]     queue        selects the command queue.
+		 */
+		void enqueueFillBuffer(
+			const cl::Buffer &buffer,
+			const void *pattern,
+			size_t patternSize,
+			size_t offset,
+			size_t size,
+			const cl::vector<cl::Event> *events = 0,
+			cl::Event *ev = 0,
+			QueueId queue = qiCompute);
+
+		//! Returns true if enqueueFillBuffer() always launches the fill kernel (see setForceFillKernel()).
+		bool getForceFillKernel() const { return m_forceFillKernel; }
+
+		//! Selects whether enqueueFillBuffer() always launches the fill kernel instead of using clEnqueueFillBuffer.
+		/**
+		 * The fill kernel is only required on devices before OpenCL 1.2; forcing it allows testing the kernel
+		 * on any device. Must not be changed while other threads enqueue fills.
+		 */
+		void setForceFillKernel(bool b) { m_forceFillKernel = b; }
+
+		//! Enqueues a barrier to command queue \a queue.
+		/**
+		 * All commands enqueued to \a queue after the barrier wait until all commands enqueued before have completed.
+		 */
+		void enqueueBarrier(QueueId queue = qiCompute) { m_queue[queue].enqueueBarrier(); }
+
+		//! Enqueues a barrier to command queue \a queue if the command queues are out-of-order.
+		/**
+		 * Blocking transfers call this method first, so that they wait for all previously enqueued commands
+		 * in \a queue as they would in an in-order queue.
+		 */
+		void enqueueOrderingBarrier(QueueId queue = qiCompute) {
+			if(isOutOfOrder())
+				m_queue[queue].enqueueBarrier();
+		}
+
+		//!	Issues all previously queued commands in all command queues to the device.
+		void flush() {
+			for(int i = 0; i < TBT_NUM_QUEUES; ++i)
+				m_queue[i].flush();
 		}
 
-		//!	Issues all previously queued commands to the device.
-		void flush() { m_queue.flush(); }
+		//!	Issues all previously queued commands in command queue \a queue to the device.
+		void flush(QueueId queue) { m_queue[queue].flush(); }
+
+		//! Blocks until all previously queued commands in all command queues have completed.
+		/**
+		 * Afterwards, all buffers released to the memory pool before can be reused.
+		 */
+		void finish() {
+			m_memoryPool->fence();
+			for(int i = 0; i < TBT_NUM_QUEUES; ++i)
+				m_queue[i].finish();
+		}
 
-		//! Blocks until all previously queued commands are issued to the device and have completed.
-		void finish() { m_queue.finish(); }
+		//! Blocks until all previously queued commands in command queue \a queue have completed.
+		void finish(QueueId queue) { m_queue[queue].finish(); }
 
 		//@}
 	};
@@ -0,0 +1,94 @@
+
+#ifndef _TBT_DEVICE_COUNTERS_H
+#define _TBT_DEVICE_COUNTERS_H
+
+#include <tbt/tbthc.h>
+
+#include <atomic>
+#include <memory>
+
+
+namespace tbt
+{
+
+	//! Counters for data transfers, kernel launches and buffer memory of a device controller.
+	/**
+	 * Each device controller maintains counters (see DeviceController::getCounters()), which are updated by
+	 * the enqueue methods of the device controller and hence by device arrays, device structs, mapped arrays
+	 * and mapped structs. The counters are atomic and updated with relaxed memory ordering, so the overhead
+	 * is negligible and counters can be queried by any thread at any time.
+	 *
+	 * Buffer memory is tracked from the creation of a buffer object until the OpenCL runtime destroys it
+	 * (using a memory object destructor callback); this includes buffers cached by the memory pool.
+	 *
+	 * \ingroup context
+	 */
+	class DeviceCounters : public std::enable_shared_from_this<DeviceCounters>
+	{
+	public:
+		//! The values of the counters at some point in time.
+		struct Values {
+			cl_ulong m_bytesLoaded;      //!< bytes transferred from host to device.
+			cl_ulong m_bytesStored;      //!< bytes transferred from device to host.
+			cl_ulong m_bytesMapped;      //!< bytes of buffer regions mapped into host memory.
+			cl_ulong m_numKernels;       //!< number of kernels launched.
+			cl_ulong m_liveBufferBytes;  //!< bytes of buffer objects currently alive.
+			cl_ulong m_highWaterMark;    //!< maximal value of m_liveBufferBytes (since the last reset).
+		};
+
+	private:
+		std::atomic<cl_ulong> m_bytesLoaded;
+		std::atomic<cl_ulong> m_bytesStored;
+		std::atomic<cl_ulong> m_bytesMapped;
+		std::atomic<cl_ulong> m_numKernels;
+		std::atomic<cl_ulong> m_liveBufferBytes;
+		std::atomic<cl_ulong> m_highWaterMark;
+
+		DeviceCounters(const DeviceCounters &);              // = delete
+		DeviceCounters &operator=(const DeviceCounters &);   // = delete
+
+		//! Subtracts \a size bytes from the live buffer bytes.
+		void releaseBuffer(cl_ulong size) { m_liveBufferBytes.fetch_sub(size, std::memory_order_relaxed); }
+
+		//! Called by the OpenCL runtime when a tracked buffer is destroyed.
+		static void CL_CALLBACK bufferDestroyed(cl_mem memObject, void *userData);
+
+	public:
+		//! Constructs counters with all values 0.
+		/**
+		 * Counters must be owned by a <tt>std::shared_ptr</tt> if buffers are tracked (see trackBuffer()).
+		 */
+		DeviceCounters();
+
+		//! Adds \a bytes to the number of bytes loaded onto the device.
+		void addBytesLoaded(cl_ulong bytes) { m_bytesLoaded.fetch_add(bytes, std::memory_order_relaxed); }
+
+		//! Adds \a bytes to the number of bytes stored from the device.
+		void addBytesStored(cl_ulong bytes) { m_bytesStored.fetch_add(bytes, std::memory_order_relaxed); }
+
+		//! Adds \a bytes to the number of bytes mapped.
+		void addBytesMapped(cl_ulong bytes) { m_bytesMapped.fetch_add(bytes, std::memory_order_relaxed); }
+
+		//! Adds \a n to the number of launched kernels.
+		void addKernels(cl_ulong n = 1) { m_numKernels.fetch_add(n, std::memory_order_relaxed); }
+
+		//! Tracks the buffer object \a buffer of \a size bytes until it is destroyed.
+		/**
+		 * Adds \a size to the live buffer bytes (updating the high-water mark) and registers a destructor
+		 * callback that subtracts \a size again when the OpenCL runtime destroys the buffer.
+		 */
+		void trackBuffer(const cl::Buffer &buffer, size_t size);
+
+		//! Returns the current values of all counters.
+		Values getValues() const;
+
+		//! Resets the transfer and kernel counters to 0 and the high-water mark to the current live buffer bytes.
+		/**
+		 * The live buffer bytes are not affected.
+		 */
+		void reset();
+	};
+
+}
+
+#endif
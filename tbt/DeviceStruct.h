@@ -44,7 +44,9 @@ namespace tbt
 		DeviceStruct(DeviceController *devCon, cl_mem_flags flags = CL_MEM_READ_WRITE)
 			: m_buffer( devCon->getContext(), flags & (CL_MEM_READ_WRITE | CL_MEM_READ_ONLY | CL_MEM_WRITE_ONLY), sizeof(T) ),
 			  m_devCon(devCon)
-		{ }
+		{
+			devCon->getCounters().trackBuffer(m_buffer, sizeof(T));
+		}
 
 		//@}
 
@@ -93,7 +95,8 @@ namespace tbt
 		 * @param[in] x  is the value to be loaded onto the device.
 		 */
 		void loadBlocking(const T &x) {
-			m_devCon->getCommandQueue().enqueueWriteBuffer(m_buffer, CL_TRUE, 0, sizeof(T), &x);
+			m_devCon->enqueueOrderingBarrier();
+			m_devCon->enqueueWriteBuffer(m_buffer, true, 0, sizeof(T), &x);
 		}
 
 		//! Enqueues a command for loading \a x onto the device.
@@ -105,7 +108,7 @@ namespace tbt
 		 * @param[in,out] eventLoad   if not 0, returns an event object that identifies the write command.
 		 */
 		void load(const T &x, cl::Event *eventLoad = 0) {
-			m_devCon->getCommandQueue().enqueueWriteBuffer(m_buffer, CL_FALSE, 0, sizeof(T), &x, 0, eventLoad);
+			m_devCon->enqueueWriteBuffer(m_buffer, false, 0, sizeof(T), &x, 0, eventLoad);
 		}
 
 		//! Stores the data on the device in \a x.
@@ -116,7 +119,8 @@ namespace tbt
 		 * @param[out] x  will be assigned the value stored on the device.
 		 */
 		void storeBlocking(T &x) {
-			m_devCon->getCommandQueue().enqueueReadBuffer(m_buffer, CL_TRUE, 0, sizeof(T), &x);
+			m_devCon->enqueueOrderingBarrier();
+			m_devCon->enqueueReadBuffer(m_buffer, true, 0, sizeof(T), &x);
 		}
 
 		//! Enqueues a command for storing the data on the device in \a x.
@@ -128,7 +132,7 @@ namespace tbt
 		 * @param[in,out] eventStore   if not 0, returns an event object that identifies the read command.
 		 */
 		void store(T &x, cl::Event *eventStore = 0) {
-			m_devCon->getCommandQueue().enqueueReadBuffer(m_buffer, CL_FALSE, 0, sizeof(T), &x, 0, eventStore);
+			m_devCon->enqueueReadBuffer(m_buffer, false, 0, sizeof(T), &x, 0, eventStore);
 		}
 
 		//@}
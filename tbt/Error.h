@@ -22,7 +22,8 @@ namespace tbt
 			ecProgramCacheError,       //!< an error occurred while trying to cache a kernel binary.
 			ecNoOpenCLPlatformFound,   //!< no suitable OpenCL platform could be found.
 			ecDataTypeNotSupported,    //!< data type of a device array not supported.
-			ecExtensionNotSupported    //!< an OpenCL extension is not supported by the device.
+			ecExtensionNotSupported,   //!< an OpenCL extension is not supported by the device.
+			ecMisalignedSubArray       //!< a subarray does not start at a properly aligned address.
 		};
 
 		//! Constructs an unknown error.
@@ -26,6 +26,9 @@ namespace tbt
 
 		bool m_cacheProgramBinaries;           //!< shall we cache program (kernel) binaries at all?
 		bool m_recompileProgramsIfNewerDriver; //!< shall we check driver version and recompile programs if newer?
+		std::string m_programCacheDir;         //!< directory for cached program binaries (empty means "cache" beside the executable).
+		size_t m_hostAlgorithmThreshold;       //!< arrays with fewer elements are processed on the host (with backend beAuto).
+		bool m_characterizeDevices;            //!< shall createContext() determine the characteristics of all devices?
 
 	public:
 		/** @name Constructor
@@ -38,6 +41,8 @@ namespace tbt
 			m_cpuDeviceIndex = m_gpuDeviceIndex = -1;
 			m_cacheProgramBinaries = true;
 			m_recompileProgramsIfNewerDriver = true;
+			m_hostAlgorithmThreshold = 1 << 16;
+			m_characterizeDevices = false;
 		}
 
 		//@}
@@ -62,6 +67,39 @@ namespace tbt
 		//! Sets option recompileProgramsIfNewerDriver to \a b.
 		void setRecompileProgramsIfNewerDriver(bool b) { m_recompileProgramsIfNewerDriver = b; }
 
+		//! Returns current setting of option programCacheDir.
+		const std::string &getProgramCacheDir() const { return m_programCacheDir; }
+
+		//! Sets option programCacheDir to \a dir.
+		/**
+		 * Program binaries are cached in directory \a dir, which must be writable if caching is enabled; only
+		 * programs with registered (embedded) sources are built without caching if \a dir is read-only.
+		 * If \a dir is empty (the default), the directory <tt>cache</tt> in the path of the executable is used.
+		 */
+		void setProgramCacheDir(const std::string &dir) { m_programCacheDir = dir; }
+
+		//! Returns current setting of option hostAlgorithmThreshold.
+		size_t getHostAlgorithmThreshold() const { return m_hostAlgorithmThreshold; }
+
+		//! Sets option hostAlgorithmThreshold to \a n.
+		/**
+		 * Algorithms on host arrays and mapped arrays with backend beAuto run on the host if the array has fewer
+		 * than \a n elements (default 2^16), since dispatching small arrays to a device costs more than it saves.
+		 */
+		void setHostAlgorithmThreshold(size_t n) { m_hostAlgorithmThreshold = n; }
+
+		//! Returns current setting of option characterizeDevices.
+		bool getCharacterizeDevices() const { return m_characterizeDevices; }
+
+		//! Sets option characterizeDevices to \a b.
+		/**
+		 * If set, createContext() determines the characteristics of all devices (see DeviceController::characterize())
+		 * before any commands are enqueued, reading them from the program cache directory if possible; if the cache
+		 * is missing or outdated, this runs micro-benchmarks on each device. Not set by default, so algorithms use
+		 * default strategies unless characterize() is called explicitly.
+		 */
+		void setCharacterizeDevices(bool b) { m_characterizeDevices = b; }
+
 		//@}
 
 		/** @name Platform and Context
@@ -85,6 +123,12 @@ namespace tbt
 		//! Returns a device controller for a GPU device (if any, otherwise 0 is returned).
 		DeviceController *getGPUDeviceController() { return (m_gpuDeviceIndex >= 0) ? m_devCons[m_gpuDeviceIndex] : 0; }
 
+		//! Returns the number of device controllers in the global context.
+		int numDeviceControllers() const { return m_devCons.numDevices(); }
+
+		//! Returns the <i>i</i>-th device controller in the global context.
+		DeviceController *getDeviceController(int i) { return m_devCons[i]; }
+
 		//@}
 	};
 
@@ -105,6 +149,9 @@ namespace tbt
 
 	//! Create global context from given device type.
 	/**
+	 * The platform is chosen automatically: the AMD, Intel (CPUs) and NVIDIA (GPUs) platforms are preferred,
+	 * otherwise the first platform providing devices of type \a deviceType is used (e.g., pocl on Linux).
+	 *
 	 * @param[in] deviceType  is the desired device type; possible values are CL_DEVICE_TYPE_CPU and CL_DEVICE_TYPE_GPU.
 	 * @param[in] properties  specifies a list of properties for the created command-queues. This is a bit-field; possible
 	 *                        properties are CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE and CL_QUEUE_PROFILING_ENABLE.
@@ -133,6 +180,12 @@ namespace tbt
 	//! Returns a global device controller for a GPU device (if any, otherwise 0 is returned).
 	inline DeviceController *getGPUDeviceController() { return globalConfig.getGPUDeviceController(); }
 
+	//! Returns the number of global device controllers.
+	inline int numDeviceControllers() { return globalConfig.numDeviceControllers(); }
+
+	//! Returns the <i>i</i>-th global device controller.
+	inline DeviceController *getDeviceController(int i) { return globalConfig.getDeviceController(i); }
+
 	//@}
 
 }
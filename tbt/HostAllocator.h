@@ -0,0 +1,88 @@
+
+#ifndef _TBT_HOST_ALLOCATOR_H
+#define _TBT_HOST_ALLOCATOR_H
+
+#include <tbt/tbthc.h>
+
+
+namespace tbt
+{
+
+	//! Kinds of host memory that can be used for host arrays.
+	/**
+	 * \ingroup memobjects
+	 */
+	enum HostMemoryKind {
+		hmCacheAligned,  //!< memory aligned to cache lines (64 bytes).
+		hmPageAligned,   //!< page-aligned memory obtained directly from the virtual memory system.
+		hmHugePages      //!< page-aligned memory backed by huge (large) pages if available, otherwise by normal pages.
+	};
+
+
+	//! Allocation policy for host memory.
+	/**
+	 * An allocation policy determines the kind of memory, the NUMA node it is bound to, and whether its
+	 * pages are touched in parallel after allocation.
+	 *
+	 * Page-aligned memory allows OpenCL drivers to transfer data directly from and to host memory (DMA)
+	 * instead of copying it to an internal staging buffer first. Binding memory to a NUMA node
+	 * requires page granularity, hence hmCacheAligned is treated like hmPageAligned in this case.
+	 *
+	 * If the memory is not bound to a NUMA node, the operating system places each page on the node
+	 * of the thread touching it first. With \a m_firstTouchThreads > 0, the memory is divided into that
+	 * many contiguous parts that are initialized (set to zero) by separate threads, so that each part is
+	 * local to the thread that processes it later if the same partition is used.
+	 *
+	 * \ingroup memobjects
+	 */
+	struct HostAllocPolicy
+	{
+		HostMemoryKind m_kind;               //!< the kind of memory.
+		int            m_numaNode;           //!< the NUMA node the memory is bound to (-1 for no binding).
+		int            m_firstTouchThreads;  //!< the number of threads touching the memory after allocation (0 for none).
+
+		//! Constructs an allocation policy.
+		HostAllocPolicy(HostMemoryKind kind = hmCacheAligned, int numaNode = -1, int firstTouchThreads = 0)
+			: m_kind(kind), m_numaNode(numaNode), m_firstTouchThreads(firstTouchThreads) { }
+
+		//! Returns true if the policy requires allocation from the virtual memory system.
+		bool usesPages() const {
+			return m_kind != hmCacheAligned || m_numaNode >= 0;
+		}
+	};
+
+
+	//! Allocation of host memory according to an allocation policy.
+	/**
+	 * \ingroup memobjects
+	 */
+	class HostAllocator
+	{
+	public:
+		//! Allocates \a size bytes of host memory according to \a policy.
+		/**
+		 * @param[in] size    is the number of bytes to allocate.
+		 * @param[in] policy  is the allocation policy.
+		 * @return            a pointer to the allocated memory, or 0 if \a size is 0.
+		 * \throws std::bad_alloc if the memory could not be allocated.
+		 */
+		static void *allocate(size_t size, const HostAllocPolicy &policy);
+
+		//! Releases memory allocated with allocate().
+		/**
+		 * @param[in] ptr     is the pointer returned by allocate() (may be 0).
+		 * @param[in] size    is the size that has been passed to allocate().
+		 * @param[in] policy  is the allocation policy that has been passed to allocate().
+		 */
+		static void deallocate(void *ptr, size_t size, const HostAllocPolicy &policy);
+
+		//! Returns the size of huge pages in bytes (0 if huge pages are not supported).
+		static size_t getHugePageSize();
+
+		//! Returns the number of NUMA nodes of the system (1 if NUMA is not supported).
+		static int getNumNumaNodes();
+	};
+
+}
+
+#endif
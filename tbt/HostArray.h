@@ -2,7 +2,12 @@
 #ifndef _TBT_HOST_ARRAY_H
 #define _TBT_HOST_ARRAY_H
 
-#include <tbt/tbthc.h>
+#include <tbt/HostAllocator.h>
+
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 
 namespace tbt
@@ -21,12 +26,26 @@ namespace tbt
 	 * construct arrays for 0 elements; in this case no memory is allocated. The usual copy
 	 * constructors and assignment operators are supported, which copy the elements to the
 	 * newly created array.
+	 *
+	 * Host arrays can also be moved, which transfers the allocated memory without copying any
+	 * elements; hence host arrays can be returned from functions and stored in containers cheaply.
+	 * Like std::vector, a host array distinguishes between its size and its capacity (see reserve()),
+	 * so that it can be shrunken and enlarged again without reallocation. Elements of trivially
+	 * copyable types are copied with memcpy.
+	 *
+	 * The memory of a host array is allocated according to an allocation policy (see HostAllocPolicy),
+	 * which can request page-aligned memory (allowing OpenCL drivers to transfer the array without
+	 * intermediate copies), huge pages, or memory bound to a NUMA node. By default, the memory is
+	 * aligned to cache lines.
 	 */
 	template<class T>
 	class HostArray
 	{
 		T     *m_ptr;        //!< pointer to memory allocated for array.
 		size_t m_nElements;  //!< number of elements in array.
+		size_t m_capacity;   //!< number of elements for which memory is allocated.
+
+		HostAllocPolicy m_policy;  //!< the allocation policy for the array's memory.
 
 	public:
 		//! The type for iterator differences.
@@ -46,22 +65,40 @@ namespace tbt
 
 
 		//! Constructs an empty host array (for 0 elements).
-		HostArray() : m_ptr(0), m_nElements(0) { }
+		HostArray() : m_ptr(0), m_nElements(0), m_capacity(0) { }
+
+		//! Constructs an empty host array (for 0 elements) that allocates memory according to \a policy.
+		explicit HostArray(const HostAllocPolicy &policy) : m_ptr(0), m_nElements(0), m_capacity(0), m_policy(policy) { }
+
+		//! Copy constructor. Allocates a new array (with the allocation policy of \a b) and copies all elements from \a b.
+		HostArray(const HostArray<T> &b) : m_nElements(b.m_nElements), m_capacity(b.m_nElements), m_policy(b.m_policy) {
+			m_ptr = allocate(m_capacity);
+			copyConstruct(m_ptr, b.m_ptr, m_nElements);
+		}
 
-		//! Copy constructor. Allocates a new array and copies all elements from \a b.
-		HostArray(const HostArray<T> &b) : m_nElements(b.m_nElements) {
-			m_ptr = (m_nElements > 0) ? new T [m_nElements] : 0;
-			copy(b.m_ptr);
+		//! Move constructor. Takes over the memory of \a b, which becomes an empty array.
+		HostArray(HostArray<T> &&b) : m_ptr(b.m_ptr), m_nElements(b.m_nElements), m_capacity(b.m_capacity), m_policy(b.m_policy) {
+			b.m_ptr = 0;
+			b.m_nElements = b.m_capacity = 0;
 		}
 
 		//! Constructs a host array for \a n elements of type \a T.
-		HostArray(size_t n) : m_nElements(n) {
-			m_ptr = (n > 0) ? new T [n] : 0;
+		/**
+		 * The elements are default-initialized, i.e., elements of built-in types are not initialized
+		 * (unless \a policy requests first-touch initialization, which sets the memory to zero).
+		 *
+		 * @param[in] n       is the number of elements.
+		 * @param[in] policy  is the allocation policy for the array's memory.
+		 */
+		HostArray(size_t n, const HostAllocPolicy &policy = HostAllocPolicy()) : m_nElements(n), m_capacity(n), m_policy(policy) {
+			m_ptr = allocate(n);
+			defaultConstruct(m_ptr, n);
 		}
 
 		//! Destructor. Releases allocated memory.
 		~HostArray() {
-			delete [] m_ptr;
+			destroy(m_ptr, m_nElements);
+			deallocate(m_ptr);
 		}
 
 		//! Returns a reference to the <i>i</i>-th element in the array.
@@ -79,6 +116,31 @@ namespace tbt
 			return m_nElements;
 		}
 
+		//! Returns the number of elements the array can hold without reallocation.
+		size_t capacity() const {
+			return m_capacity;
+		}
+
+		//! Returns the allocation policy of the array.
+		const HostAllocPolicy &getPolicy() const {
+			return m_policy;
+		}
+
+		//! Returns true if the array has no elements.
+		bool empty() const {
+			return m_nElements == 0;
+		}
+
+		//! Returns a pointer to the first element in the array (0 if no memory is allocated).
+		const T *data() const {
+			return m_ptr;
+		}
+
+		//! Returns a pointer to the first element in the array (0 if no memory is allocated).
+		T *data() {
+			return m_ptr;
+		}
+
 
 		/** @name Iterators
 		 * These methods return iterators to specific positions in the host array.
@@ -131,16 +193,53 @@ namespace tbt
 
 
 		//! Assignment operator. Copies the elements from b.
+		/**
+		 * Memory is only reallocated if the capacity of this array is too small.
+		 */
 		HostArray<T> &operator=(const HostArray<T> &b) {
-			if(b.m_nElements != m_nElements) {
-				delete [] m_ptr;
+			if(&b != this) {
+				destroy(m_ptr, m_nElements);
+				m_nElements = 0;
+
+				if(b.m_nElements > m_capacity) {
+					deallocate(m_ptr);
+					m_ptr = 0;
+					m_capacity = 0;
+					m_ptr = allocate(b.m_nElements);
+					m_capacity = b.m_nElements;
+				}
+
+				copyConstruct(m_ptr, b.m_ptr, b.m_nElements);
 				m_nElements = b.m_nElements;
-				m_ptr = (m_nElements > 0) ? new T [m_nElements] : 0;
 			}
-			copy(b);
 			return *this;
 		}
 
+		//! Move assignment operator. Takes over the memory (and allocation policy) of \a b, which becomes an empty array.
+		HostArray<T> &operator=(HostArray<T> &&b) {
+			if(&b != this) {
+				destroy(m_ptr, m_nElements);
+				deallocate(m_ptr);
+
+				m_ptr = b.m_ptr;
+				m_nElements = b.m_nElements;
+				m_capacity = b.m_capacity;
+				m_policy = b.m_policy;
+
+				b.m_ptr = 0;
+				b.m_nElements = b.m_capacity = 0;
+			}
+			return *this;
+		}
+
+		//! Exchanges the contents of this array and \a b (without copying elements).
+		void swap(HostArray<T> &b) {
+			std::swap(m_ptr, b.m_ptr);
+			std::swap(m_nElements, b.m_nElements);
+			std::swap(m_capacity, b.m_capacity);
+			std::swap(m_policy, b.m_policy);
+		}
+
 		//! Assigns x to every element in the array.
 		void fill(T x) {
 			for(size_t i = 0; i < m_nElements; ++i)
@@ -150,38 +249,124 @@ namespace tbt
 		//! Resizes the array to an array for \a n elements.
 		/**
 		 * The array can be enlarged or shrunken; it is also possible to resize it to 0 elements.
-		 * If the old array had \a n_old elements, then min(\a n_old, \a n) elements are copied from
-		 * the old to the resized array.
+		 * If the old array had \a n_old elements, then min(\a n_old, \a n) elements are kept;
+		 * new elements are default-initialized. Memory is only reallocated if \a n exceeds the
+		 * capacity of the array; shrinking never releases memory (see shrinkToFit()).
 		 */
 		void resize(size_t n) {
-			if(n != m_nElements) {
-				if(n > 0) {
-					T *ptr = new T [n];
-					size_t n_min = min(n,m_nElements);
-					for(size_t i = 0; i < n_min; i++)
-						ptr[i] = m_ptr[i];
-
-					delete m_ptr;
-					m_ptr = ptr;
-
-				} else {
-					delete [] m_ptr;
-					m_ptr = 0;
-				}
+			if(n > m_capacity)
+				reallocate(n);
 
-				m_nElements = n;
-			}
+			if(n > m_nElements)
+				defaultConstruct(m_ptr+m_nElements, n-m_nElements);
+			else
+				destroy(m_ptr+n, m_nElements-n);
+
+			m_nElements = n;
+		}
+
+		//! Ensures that the array can hold at least \a n elements without reallocation.
+		/**
+		 * The size of the array is not changed.
+		 */
+		void reserve(size_t n) {
+			if(n > m_capacity)
+				reallocate(n);
+		}
+
+		//! Reduces the capacity of the array to its size.
+		void shrinkToFit() {
+			if(m_capacity > m_nElements)
+				reallocate(m_nElements);
+		}
+
+		//! Removes all elements from the array; the capacity is not changed.
+		void clear() {
+			destroy(m_ptr, m_nElements);
+			m_nElements = 0;
 		}
 
 	private:
-		//! Auxiliary function for copying elements.
-		void copy(T *b) {
-			for(size_t i = 0; i < m_nElements; ++i)
-				m_ptr[i] = b[i];
+		//! Allocates uninitialized memory for \a n elements (returns 0 if \a n is 0).
+		T *allocate(size_t n) const {
+			return static_cast<T*>(HostAllocator::allocate(n * sizeof(T), m_policy));
+		}
+
+		//! Releases memory allocated with allocate() (for the current capacity).
+		void deallocate(T *p) const {
+			HostAllocator::deallocate(p, m_capacity * sizeof(T), m_policy);
+		}
+
+		//! Default-initializes \a n elements in uninitialized memory starting at \a p.
+		static void defaultConstruct(T *p, size_t n) {
+			for(size_t i = 0; i < n; ++i)
+				new (p+i) T;
+		}
+
+		//! Copy-constructs \a n elements starting at \a p from the elements starting at \a src.
+		static void copyConstruct(T *p, const T *src, size_t n) {
+			copyConstruct(p, src, n, std::is_trivially_copyable<T>());
+		}
+
+		//! Copies \a n trivially copyable elements with memcpy.
+		static void copyConstruct(T *p, const T *src, size_t n, std::true_type) {
+			if(n > 0)
+				memcpy(p, src, n * sizeof(T));
+		}
+
+		//! Copy-constructs \a n elements with the copy constructor of \a T.
+		static void copyConstruct(T *p, const T *src, size_t n, std::false_type) {
+			for(size_t i = 0; i < n; ++i)
+				new (p+i) T(src[i]);
+		}
+
+		//! Move-constructs \a n elements starting at \a p from the elements starting at \a src.
+		static void moveConstruct(T *p, T *src, size_t n) {
+			moveConstruct(p, src, n, std::is_trivially_copyable<T>());
+		}
+
+		//! Moves \a n trivially copyable elements with memcpy.
+		static void moveConstruct(T *p, T *src, size_t n, std::true_type) {
+			if(n > 0)
+				memcpy(p, src, n * sizeof(T));
+		}
+
+		//! Move-constructs \a n elements with the move constructor of \a T.
+		static void moveConstruct(T *p, T *src, size_t n, std::false_type) {
+			for(size_t i = 0; i < n; ++i)
+				new (p+i) T(std::move(src[i]));
+		}
+
+		//! Destroys \a n elements starting at \a p.
+		static void destroy(T *p, size_t n) {
+			for(size_t i = 0; i < n; ++i)
+				p[i].~T();
+		}
+
+		//! Reallocates the array with capacity \a n (\a n must not be less than the size).
+		void reallocate(size_t n) {
+			T *ptr = allocate(n);
+			moveConstruct(ptr, m_ptr, m_nElements);
+			destroy(m_ptr, m_nElements);
+			deallocate(m_ptr);
+
+			m_ptr = ptr;
+			m_capacity = n;
 		}
 	};
 
 
+	//! Exchanges the contents of host arrays \a a and \a b.
+	/**
+	 * \ingroup memobjects
+	 */
+	template<class T> inline
+	void swap(HostArray<T> &a, HostArray<T> &b)
+	{
+		a.swap(b);
+	}
+
+
 	//! Const-iterator for host arrays.
 	/**
 	 * \ingroup iterators
@@ -191,7 +376,7 @@ namespace tbt
 	{
 		friend class HostArray<T>;
 
-		T *m_ptr;  //!< pointer to the element in the host array.
+		const T *m_ptr;  //!< pointer to the element in the host array.
 
 		//! Constructs a const-iterator pointing to the element \a ptr points to.
 		/**
@@ -286,7 +471,7 @@ namespace tbt
 		 * \pre This const-iterator must be valid.
 		 */
 		_MyIter operator--(int) {
-			_DeviceArrayConstIterator<T> iter(*this);
+			_MyIter iter(*this);
 			--m_ptr;
 			return iter;
 		}
@@ -305,7 +490,7 @@ namespace tbt
 		 * \pre This const-iterator must be valid.
 		 */
 		_MyIter operator+(difference_type offset) const {
-			_DeviceArrayConstIterator<T> iter(*this);
+			_MyIter iter(*this);
 			return ( iter += offset);
 		}
 
@@ -323,7 +508,7 @@ namespace tbt
 		 * \pre This const-iterator must be valid.
 		 */
 		_MyIter operator-(difference_type offset) const {
-			_DeviceArrayConstIterator<T> iter(*this);
+			_MyIter iter(*this);
 			return ( iter -= offset);
 		}
 
@@ -0,0 +1,53 @@
+#ifndef _TBT_HOST_RADIX_SORT_H
+#define _TBT_HOST_RADIX_SORT_H
+
+
+#include <tbt/HostArray.h>
+#include <tbt/ThreadPool.h>
+
+#include <vector>
+
+
+namespace tbt
+{
+
+	//! Radix-sort module running on host threads.
+	/**
+	 * Sorts arrays in host memory with the same least-significant-digit radix sort as RadixSort (four passes
+	 * over 8-bit digits), so the results are identical to sorting on a device. Each pass splits the array
+	 * into one block per thread; the threads count the digits of their blocks and then scatter their keys to
+	 * the target positions. Passes in which all keys have the same digit are skipped.
+	 *
+	 * Unlike RadixSort, there are no restrictions on the number of elements, and no OpenCL device is required.
+	 * A module keeps its temporary array between runs and must not be run by several threads at the same time.
+	 *
+	 * \ingroup algorithm
+	 */
+	class HostRadixSort
+	{
+		ThreadPool          *m_pool;      //!< the thread pool running the passes.
+		std::vector<cl_uint> m_buffer;    //!< temporary array for odd passes.
+		std::vector<size_t>  m_counts;    //!< digit counts (and then target positions) per block.
+		double               m_hostTime;  //!< time of the last run() (in milliseconds).
+
+		HostRadixSort(const HostRadixSort &);              // = delete
+		HostRadixSort &operator=(const HostRadixSort &);   // = delete
+
+	public:
+		//! Constructs a host radix-sort module using \a pool (or the default thread pool if \a pool is 0).
+		explicit HostRadixSort(ThreadPool *pool = 0) : m_pool((pool != 0) ? pool : &ThreadPool::getDefault()), m_hostTime(0.0) { }
+
+		//! Sorts the \a n elements starting at \a data.
+		void run(cl_uint *data, size_t n);
+
+		//! Sorts host array \a hostArray.
+		void run(HostArray<cl_uint> &hostArray) { run(hostArray.data(), hostArray.size()); }
+
+		//! Returns the time of the last run() in milliseconds.
+		double hostTime() const { return m_hostTime; }
+	};
+
+}
+
+
+#endif
@@ -0,0 +1,199 @@
+
+#ifndef _TBT_KERNEL_POOL_H
+#define _TBT_KERNEL_POOL_H
+
+#include <tbt/Utility.h>
+#include <tbt/Global.h>
+
+#include <atomic>
+#include <mutex>
+
+
+namespace tbt
+{
+
+	//! Pool of kernel objects that can be used concurrently by several host threads.
+	/**
+	 * OpenCL kernel objects carry their arguments, so a kernel object must not be shared by host threads
+	 * that set arguments and enqueue the kernel at the same time. A kernel pool maintains any number of
+	 * instances of a set of kernels (type \a KernelSet) created from the same program. A host thread
+	 * checks out an instance with acquire(), which is lock-free; the instance is returned to the pool
+	 * when the returned handle is destroyed. New instances are only created if all existing instances
+	 * are currently in use, hence the number of instances is bounded by the number of concurrent users.
+	 *
+	 * The program is built for each device on first use with a device controller of that device (thread-safe)
+	 * and owned by the pool; kernel sets are maintained per device, since kernels can only be launched on
+	 * devices their program has been built for. Device controllers sharing the device and context (e.g., with
+	 * in-order and out-of-order queues) share the program and kernel sets.
+	 *
+	 * \a KernelSet must provide a constructor taking a <tt>const cl::Program&</tt> that creates all its kernels.
+	 *
+	 * \ingroup context
+	 */
+	template<class KernelSet>
+	class KernelPool
+	{
+		//! An instance of the kernel set in the pool.
+		struct Slot {
+			KernelSet         m_kernels;  //!< the kernel objects.
+			std::atomic<bool> m_inUse;    //!< true if this slot is currently checked out.
+			Slot             *m_next;     //!< next slot in list (slots are never removed).
+
+			Slot(const cl::Program &program) : m_kernels(program), m_inUse(true), m_next(0) { }
+		};
+
+		//! The program and the kernel sets for a device.
+		struct DeviceEntry {
+			cl_context         m_context;  //!< the context the program has been built in.
+			cl_device_id       m_device;   //!< the device the program has been built for.
+			cl::Program        m_program;  //!< the program.
+			std::atomic<Slot*> m_head;     //!< head of (append-only) list of slots.
+			DeviceEntry       *m_next;     //!< next entry in list (entries are never removed).
+
+			DeviceEntry(DeviceController *devCon, const cl::Program &program)
+				: m_context(devCon->getContext()()), m_device(devCon->getDevice()()), m_program(program), m_head(0), m_next(0) { }
+
+			~DeviceEntry() {
+				Slot *slot = m_head.load();
+				while(slot != 0) {
+					Slot *next = slot->m_next;
+					delete slot;
+					slot = next;
+				}
+			}
+
+			//! Returns true if this entry belongs to the device and context of \a devCon.
+			bool matches(DeviceController *devCon) const {
+				return m_device == devCon->getDevice()() && m_context == devCon->getContext()();
+			}
+		};
+
+		const char *m_progName;     //!< file name of the OpenCL program.
+		cl_uint     m_requiredExt;  //!< required OpenCL extensions.
+		cl_uint     m_optionalExt;  //!< optional OpenCL extensions.
+
+		std::atomic<DeviceEntry*> m_entries;     //!< head of (append-only) list of per-device entries.
+		std::mutex                m_buildMutex;  //!< serializes building programs.
+
+		//! Returns the entry for the device of \a devCon (or the global device controller if 0); builds the program if required.
+		DeviceEntry &getEntry(DeviceController *devCon) {
+			if(devCon == 0)
+				devCon = getDeviceController();
+
+			for(DeviceEntry *entry = m_entries.load(std::memory_order_acquire); entry != 0; entry = entry->m_next)
+				if(entry->matches(devCon))
+					return *entry;
+
+			std::lock_guard<std::mutex> lock(m_buildMutex);
+			DeviceEntry *head = m_entries.load(std::memory_order_relaxed);
+			for(DeviceEntry *entry = head; entry != 0; entry = entry->m_next)
+				if(entry->matches(devCon))
+					return *entry;
+
+			DeviceEntry *entry = new DeviceEntry(devCon, Utility::buildProgram(devCon, m_progName, m_requiredExt, m_optionalExt));
+			entry->m_next = head;
+			m_entries.store(entry, std::memory_order_release);
+
+			return *entry;
+		}
+
+		KernelPool(const KernelPool<KernelSet> &);                           // = delete
+		KernelPool<KernelSet> &operator=(const KernelPool<KernelSet> &);     // = delete
+
+	public:
+		//! Handle to a checked-out kernel set; returns the kernel set to the pool on destruction.
+		class Handle
+		{
+			friend class KernelPool<KernelSet>;
+
+			Slot *m_slot;
+
+			explicit Handle(Slot *slot) : m_slot(slot) { }
+
+			Handle(const Handle &);              // = delete
+			Handle &operator=(const Handle &);   // = delete
+
+		public:
+			//! Move constructor.
+			Handle(Handle &&h) : m_slot(h.m_slot) { h.m_slot = 0; }
+
+			//! Destructor. Returns the kernel set to the pool.
+			~Handle() {
+				if(m_slot != 0)
+					m_slot->m_inUse.store(false, std::memory_order_release);
+			}
+
+			//! Returns the checked-out kernel set.
+			KernelSet &operator*() const { return m_slot->m_kernels; }
+
+			//! Provides access to the members of the checked-out kernel set.
+			KernelSet *operator->() const { return &m_slot->m_kernels; }
+		};
+
+
+		//! Constructs a kernel pool for kernels in program \a progName.
+		/**
+		 * @param[in] progName     file name of the OpenCL program (see Utility::buildProgram()); the program is
+		 *                         not built before the first call of acquire().
+		 * @param[in] requiredExt  is a bitvector specifying the OpenCL extensions required to build \a progName.
+		 * @param[in] optionalExt  is a bitvector specifying optional OpenCL extensions.
+		 */
+		KernelPool(const char *progName, cl_uint requiredExt = 0, cl_uint optionalExt = 0)
+			: m_progName(progName), m_requiredExt(requiredExt), m_optionalExt(optionalExt), m_entries(0) { }
+
+		//! Destructor. Releases all programs and kernel sets; no handles may be alive.
+		~KernelPool() {
+			DeviceEntry *entry = m_entries.load();
+			while(entry != 0) {
+				DeviceEntry *next = entry->m_next;
+				delete entry;
+				entry = next;
+			}
+		}
+
+		//! Returns the program of this pool for the device of \a devCon; builds the program if required.
+		/**
+		 * @param[in] devCon  is the device controller; if 0, the global device controller is used.
+		 */
+		const cl::Program &getProgram(DeviceController *devCon = 0) {
+			return getEntry(devCon).m_program;
+		}
+
+		//! Checks out a kernel set for the device of \a devCon for exclusive use by the calling thread.
+		/**
+		 * Reuses an unused kernel set if available, otherwise creates a new one.
+		 *
+		 * @param[in] devCon  is the device controller the kernels are enqueued to; if 0, the global device controller is used.
+		 */
+		Handle acquire(DeviceController *devCon = 0) {
+			DeviceEntry &entry = getEntry(devCon);
+
+			for(Slot *slot = entry.m_head.load(std::memory_order_acquire); slot != 0; slot = slot->m_next) {
+				bool expected = false;
+				if(!slot->m_inUse.load(std::memory_order_relaxed) &&
+					slot->m_inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+					return Handle(slot);
+			}
+
+			Slot *slot = new Slot(entry.m_program);
+			Slot *head = entry.m_head.load(std::memory_order_relaxed);
+			do {
+				slot->m_next = head;
+			} while(!entry.m_head.compare_exchange_weak(head, slot, std::memory_order_release, std::memory_order_relaxed));
+
+			return Handle(slot);
+		}
+
+		//! Returns the number of kernel sets created so far (for all devices).
+		size_t size() const {
+			size_t n = 0;
+			for(DeviceEntry *entry = m_entries.load(std::memory_order_acquire); entry != 0; entry = entry->m_next)
+				for(Slot *slot = entry->m_head.load(std::memory_order_acquire); slot != 0; slot = slot->m_next)
+					++n;
+			return n;
+		}
+	};
+
+}
+
+#endif
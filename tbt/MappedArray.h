@@ -13,14 +13,75 @@ namespace tbt
 	template<class T> class _MappedArrayIterator;
 
 
+	//! Access modes for mapping device memory to host memory.
+	/**
+	 * \ingroup memobjects
+	 */
+	enum MapMode {
+		mmRead,             //!< the host only reads the mapped memory.
+		mmWrite,            //!< the host only writes the mapped memory (its previous contents are still transfered).
+		mmReadWrite,        //!< the host reads and writes the mapped memory.
+		mmWriteInvalidate   //!< the host overwrites the whole mapped memory; its previous contents need not be transfered.
+	};
+
+	//! Returns the OpenCL map flags for map mode \a mode on the device of \a devCon.
+	/**
+	 * mmWriteInvalidate requires OpenCL 1.2 (CL_MAP_WRITE_INVALIDATE_REGION); on older devices CL_MAP_WRITE is used.
+	 */
+	inline cl_map_flags getMapFlags(MapMode mode, const DeviceController *devCon)
+	{
+		switch(mode) {
+		case mmRead:
+			return CL_MAP_READ;
+		case mmWrite:
+			return CL_MAP_WRITE;
+		case mmWriteInvalidate:
+#ifdef CL_MAP_WRITE_INVALIDATE_REGION
+			if(devCon->getVersionNumber() >= 120)
+				return CL_MAP_WRITE_INVALIDATE_REGION;
+#endif
+			return CL_MAP_WRITE;
+		default:
+			return CL_MAP_READ | CL_MAP_WRITE;
+		}
+	}
+
+
+	//! Strategies for allocating the memory of mapped arrays.
+	/**
+	 * \ingroup memobjects
+	 */
+	enum MappingStrategy {
+		msAuto,          //!< chooses msUseHostPtr for devices sharing memory with the host, and msAllocHostPtr otherwise.
+		msUseHostPtr,    //!< the array is allocated by TBT in host memory and used by the device (<tt>CL_MEM_USE_HOST_PTR</tt>).
+		msAllocHostPtr   //!< the array is allocated by the OpenCL driver in host-accessible (pinned) memory (<tt>CL_MEM_ALLOC_HOST_PTR</tt>).
+	};
+
+
 	//! Array mapped to an OpenCL device.
 	/**
+	 * A mapped array is stored in host-accessible memory that is also used by an OpenCL device; see MappingStrategy
+	 * for the available allocation strategies. By default, the strategy is chosen per device: on devices sharing
+	 * memory with the host (integrated GPUs, CPUs), TBT allocates the array suitably aligned and the device uses it
+	 * directly, and on discrete devices the driver allocates pinned host memory. At any time, the array is either mapped to the host, in which case its elements can
+	 * be accessed with the access operators, or owned by the device, in which case it can be used by kernels. A newly
+	 * constructed mapped array is mapped to the host; mapHostToDevice() unmaps it, mapDeviceToHost() maps it again.
+	 * On devices sharing memory with the host, mapping and unmapping does not copy any data.
+	 *
+	 * Use ScopedMapping for temporarily mapping only a part of an array owned by the device.
+	 *
 	 * \ingroup memobjects
 	 */
 	template<class T>
 	class MappedArray : public DeviceArray<T>
 	{
-		T *m_ptr;  //!< pointer to memory allocated for array.
+		T *m_hostPtr;  //!< memory allocated for the array that is freed on destruction (only for strategy msUseHostPtr; 0 if freed with the buffer object).
+		T *m_ptr;      //!< pointer to the mapped array in host memory (0 if not mapped).
+
+		MappingStrategy m_strategy;  //!< the allocation strategy used for this array.
+
+		MappedArray(const MappedArray<T> &);                  // = delete
+		MappedArray<T> &operator=(const MappedArray<T> &);    // = delete
 
 	public:
 
@@ -46,38 +107,79 @@ namespace tbt
 		 * The constructed mapped array is neither associated with an OpenCL buffer object nor a
 		 * device controller. Hence, it cannot be used for loading or storing data.
 		 */
-		MappedArray() : DeviceArray<T>(), m_ptr(0) { }
+		MappedArray() : DeviceArray<T>(), m_hostPtr(0), m_ptr(0), m_strategy(msAuto) { }
 
 		//! Constructs a mapped array for \a n elements of type \a T associated with device controller \a devCon.
 		/**
-		 * @param devCon  must be a valid device controller that will be associated with the device array.
-		 * @param n       is the number of elements (of type \a T) in the constructed device array.
-		 * @param flags   are the memory flags (restricting the access of kernels to the corresponding device memory)
-		 *                that will be used for creating the OpenCL buffer object; \a flags can be one of
-		 *                CL_MEM_READ_WRITE, CL_MEM_READ_ONLY and CL_MEM_WRITE_ONLY.
+		 * The constructed array is mapped to the host.
+		 *
+		 * @param devCon    must be a valid device controller that will be associated with the device array.
+		 * @param n         is the number of elements (of type \a T) in the constructed device array.
+		 * @param flags     are the memory flags (restricting the access of kernels to the corresponding device memory)
+		 *                  that will be used for creating the OpenCL buffer object; \a flags can be one of
+		 *                  CL_MEM_READ_WRITE, CL_MEM_READ_ONLY and CL_MEM_WRITE_ONLY.
+		 * @param strategy  is the allocation strategy; msAuto selects the strategy based on
+		 *                  DeviceController::getHostUnifiedMemory().
 		 */
-		MappedArray(DeviceController *devCon, size_t n, cl_mem_flags flags = CL_MEM_READ_WRITE)
-			: DeviceArray<T>()
+		MappedArray(DeviceController *devCon, size_t n, cl_mem_flags flags = CL_MEM_READ_WRITE, MappingStrategy strategy = msAuto)
+			: DeviceArray<T>(), m_hostPtr(0), m_ptr(0)
 		{
-			m_nElements = n;
-			m_devCon = devCon;
-			m_ptr = (n > 0) ? (T *) Utility::alignedMalloc(n*sizeof(T),devCon->getMemBaseAddrAlign() >> 3) : 0;
-			m_buffer = cl::Buffer( devCon->getContext(),
-				CL_MEM_USE_HOST_PTR | (flags & (CL_MEM_READ_WRITE | CL_MEM_READ_ONLY | CL_MEM_WRITE_ONLY)), n*sizeof(T), m_ptr );
+			this->m_nElements = n;
+			this->m_devCon = devCon;
+
+			if(strategy == msAuto)
+				strategy = (devCon->getHostUnifiedMemory() || devCon->getType() == CL_DEVICE_TYPE_CPU) ? msUseHostPtr : msAllocHostPtr;
+			m_strategy = strategy;
+
+			if(n > 0) {
+				flags &= (CL_MEM_READ_WRITE | CL_MEM_READ_ONLY | CL_MEM_WRITE_ONLY);
+
+				if(strategy == msUseHostPtr) {
+					// zero-copy requires page-aligned memory and a size that is a multiple of the cache line size
+					size_t alignment = Utility::getPageSize();
+					if(alignment < (devCon->getMemBaseAddrAlign() >> 3))
+						alignment = devCon->getMemBaseAddrAlign() >> 3;
+
+					size_t cacheline = (devCon->getGlobalMemCachelineSize() > 64) ? devCon->getGlobalMemCachelineSize() : 64;
+					size_t size = (n*sizeof(T) + cacheline - 1) / cacheline * cacheline;
+
+					m_hostPtr = (T *) Utility::alignedMalloc(size, alignment);
+					this->m_buffer = cl::Buffer(devCon->getContext(), CL_MEM_USE_HOST_PTR | flags, n*sizeof(T), m_hostPtr);
+
+					// device arrays and slices may share the buffer object beyond the lifetime of this array,
+					// so the host memory is freed when the buffer object is destroyed
+					if(Utility::alignedFreeWithMemObject(this->m_buffer, m_hostPtr))
+						m_hostPtr = 0;
+
+				} else
+					this->m_buffer = cl::Buffer(devCon->getContext(), CL_MEM_ALLOC_HOST_PTR | flags, n*sizeof(T));
+
+				devCon->getCounters().trackBuffer(this->m_buffer, n*sizeof(T));
+				map(CL_TRUE, mmWrite, 0, 0);
+			}
 		}
 
-		//! Destructor. Releases allocated memory.
+		//! Destructor. Unmaps the array (if mapped) and releases its reference to the buffer object.
+		/**
+		 * Host memory allocated for strategy msUseHostPtr is freed when the buffer object is destroyed, i.e.,
+		 * after all device arrays sharing it have been destroyed and all commands using it have completed.
+		 */
 		~MappedArray() {
-			Utility::alignedFree(m_ptr);
+			if(m_ptr != 0) {
+				cl::Event eventUnmap;
+				unmap(0, &eventUnmap);
+				eventUnmap.wait();
+			}
+			this->m_buffer = cl::Buffer();
+			Utility::alignedFree(m_hostPtr);
 		}
 
 		//@}
 
 
 		/** @name Access Operators
-		 * These methods provide access to the elements in host memory. If array elements have been changed
-		 * in device memory, they must first be explicitly transfered back to host memory (see
-		 * <strong>Transfering Data Between Host and Device</strong> below).
+		 * These methods provide access to the elements in host memory; they may only be used while
+		 * the array is mapped to the host (see <strong>Transfering Data Between Host and Device</strong> below).
 		 */
 		//@{
 
@@ -91,6 +193,12 @@ namespace tbt
 			return m_ptr[i];
 		}
 
+		//! Returns true if the array is currently mapped to the host.
+		bool isMapped() const { return m_ptr != 0; }
+
+		//! Returns the allocation strategy used for this array (never msAuto for valid arrays).
+		MappingStrategy getStrategy() const { return m_strategy; }
+
 		//@}
 
 
@@ -145,53 +253,176 @@ namespace tbt
 
 
 		/** @name Transfering Data Between Host and Device
-		 *  These methods transfer data from host to device memory, and vice versa. They enqueue map-buffer
-		 *  commands to the command queue for the associated device. If the device is the CPU, the device memory
-		 *  is the host memory and no actual data transfer operations are necessary.
+		 *  These methods transfer the ownership of the array between host and device. They enqueue map-buffer
+		 *  and unmap commands to the command queue for the associated device. If the device shares memory with
+		 *  the host, no actual data transfer operations are necessary.
 		 */
 		//@{
 
-		//! Enqueues a blocking command for mapping the array on the device to the array on the host; transfers data if necessary.
+		//! Maps the array on the device to the array on the host; transfers data if necessary.
 		/**
-		 * This methods enqueues a blocking, (reading) map-buffer command. Once this method returns, the memory
-		 * transfer to the host is completed. If the device is the CPU, no memory transfer is necessary.
+		 * This methods enqueues a blocking map-buffer command. Once this method returns, the memory
+		 * transfer to the host is completed. Does nothing if the array is already mapped.
+		 *
+		 * @param mode  specifies how the host will access the mapped array.
 		 */
-		void mapDeviceToHostBlocking() {
-			m_devCon->getCommandQueue().enqueueMapBuffer(m_buffer, CL_TRUE, CL_MAP_READ, 0, m_nElements*sizeof(T));
+		void mapDeviceToHostBlocking(MapMode mode = mmReadWrite) {
+			if(m_ptr == 0)
+				map(CL_TRUE, mode, 0, 0);
 		}
 
 		//! Enqueues a command for mapping the array on the device to the array on the host; transfers data if necessary.
 		/**
-		 * This methods enqueues a non-blocking, (reading) map-buffer command and returns an event object associated with
-		 * this map command that can be queried (or waited for). If the device is the CPU, no memory transfer is necessary.
+		 * This methods enqueues a non-blocking map-buffer command and returns an event object associated with
+		 * this map command that can be queried (or waited for); the elements must not be accessed before the
+		 * command has completed. If the array is already mapped, only a marker command is enqueued.
 		 *
 		 * @param eventMap   if not 0, returns an event object that identifies the map command.
+		 * @param mode       specifies how the host will access the mapped array.
+		 * @param events     if not 0, specifies events that need to complete before the map command can be executed.
 		 */
-		void mapDeviceToHost(cl::Event *eventMap = 0) {
-			m_devCon->getCommandQueue().enqueueMapBuffer(m_buffer, CL_FALSE, CL_MAP_READ, 0, m_nElements*sizeof(T), 0, eventMap);
+		void mapDeviceToHost(cl::Event *eventMap = 0, MapMode mode = mmReadWrite, const cl::vector<cl::Event> *events = 0) {
+			if(m_ptr == 0)
+				map(CL_FALSE, mode, events, eventMap);
+			else
+				marker(events, eventMap);
 		}
 
-		//! Enqueues a blocking command for mapping the array on the host to the array on the device; transfers data if necessary.
+		//! Unmaps the array from the host, making it available to the device; transfers data if necessary.
 		/**
-		 * This methods enqueues a blocking, (writing) map-buffer command. Once this method returns, the memory
-		 * transfer to the device is completed. If the device is the CPU, no memory transfer is necessary.
+		 * This methods enqueues an unmap command and waits for its completion. Once this method returns, the memory
+		 * transfer to the device is completed. Does nothing if the array is not mapped.
 		 */
 		void mapHostToDeviceBlocking() {
-			m_devCon->getCommandQueue().enqueueMapBuffer(m_buffer, CL_TRUE, CL_MAP_WRITE, 0, m_nElements*sizeof(T));
+			if(m_ptr != 0) {
+				cl::Event eventUnmap;
+				unmap(0, &eventUnmap);
+				eventUnmap.wait();
+			}
 		}
 
-		//! Enqueues a command for mapping the array on the host to the array on the device; transfers data if necessary.
+		//! Enqueues a command for unmapping the array from the host, making it available to the device; transfers data if necessary.
 		/**
-		 * This methods enqueues a non-blocking, (writing) map-buffer command and returns an event object associated with
-		 * this map command that can be queried (or waited for). If the device is the CPU, no memory transfer is necessary.
+		 * This methods enqueues an unmap command and returns an event object associated with this command that can be
+		 * queried (or waited for). The elements must not be accessed on the host anymore. If the array is not mapped,
+		 * only a marker command is enqueued.
 		 *
-		 * @param eventMap   if not 0, returns an event object that identifies the map command.
+		 * @param eventMap   if not 0, returns an event object that identifies the unmap command.
+		 * @param events     if not 0, specifies events that need to complete before the unmap command can be executed.
 		 */
-		void mapHostToDevice(cl::Event *eventMap = 0) {
-			m_devCon->getCommandQueue().enqueueMapBuffer(m_buffer, CL_FALSE, CL_MAP_WRITE, 0, m_nElements*sizeof(T), 0, eventMap);
+		void mapHostToDevice(cl::Event *eventMap = 0, const cl::vector<cl::Event> *events = 0) {
+			if(m_ptr != 0)
+				unmap(events, eventMap);
+			else
+				marker(events, eventMap);
 		}
 
 		//@}
+
+	private:
+		//! Maps the whole array with access mode \a mode after \a events have completed.
+		void map(cl_bool blocking, MapMode mode, const cl::vector<cl::Event> *events, cl::Event *eventMap) {
+			if(blocking)
+				this->m_devCon->enqueueOrderingBarrier();
+			m_ptr = (T *) this->m_devCon->enqueueMapBuffer(this->m_buffer, blocking,
+				getMapFlags(mode, this->m_devCon), 0, this->m_nElements*sizeof(T), events, eventMap);
+		}
+
+		//! Unmaps the array after \a events have completed.
+		void unmap(const cl::vector<cl::Event> *events, cl::Event *eventUnmap) {
+			this->m_devCon->enqueueUnmapMemObject(this->m_buffer, m_ptr, this->m_nElements*sizeof(T), events, eventUnmap);
+			m_ptr = 0;
+		}
+
+		//! Enqueues a marker waiting for \a events instead of a map or unmap command.
+		void marker(const cl::vector<cl::Event> *events, cl::Event *ev) {
+			cl::CommandQueue queue = this->m_devCon->getCommandQueue();
+			if(events != 0 && !events->empty())
+				queue.enqueueWaitForEvents(*events);
+			if(ev != 0)
+				queue.enqueueMarker(ev);
+		}
+	};
+
+
+	//! Temporary mapping of (a part of) a device array to host memory.
+	/**
+	 * The constructor maps the elements of a device array (or of a subarray) to host memory and the destructor unmaps
+	 * them again. Only the mapped range is transfered (if necessary at all), and on devices sharing memory with the
+	 * host, no data is copied. The device array must not be used by kernels while it is mapped.
+	 *
+	 * \code
+	 * {
+	 *     tbt::ScopedMapping<cl_uint> m(devArray, 0, 100, tbt::mmRead);
+	 *     for(index_t i = 0; i < m.size(); ++i)
+	 *         std::cout << m[i] << std::endl;
+	 * }   // unmapped here
+	 * \endcode
+	 *
+	 * \ingroup memobjects
+	 */
+	template<class T>
+	class ScopedMapping
+	{
+		DeviceController *m_devCon;     //!< the device controller of the mapped array.
+		cl::Buffer        m_buffer;     //!< the mapped buffer object.
+		T                *m_ptr;        //!< the mapped range in host memory (0 if unmapped).
+		index_t           m_nElements;  //!< the number of mapped elements.
+
+		ScopedMapping(const ScopedMapping<T> &);                  // = delete
+		ScopedMapping<T> &operator=(const ScopedMapping<T> &);    // = delete
+
+		void map(DeviceArray<T> &da, index_t first, index_t last, MapMode mode) {
+			m_devCon    = da.getDeviceController();
+			m_buffer    = da.getBaseBuffer();
+			m_nElements = last - first;
+			m_devCon->enqueueOrderingBarrier();
+			m_ptr = (T *) m_devCon->enqueueMapBuffer(m_buffer, true, getMapFlags(mode, m_devCon),
+				(da.getOffset() + first)*sizeof(T), m_nElements*sizeof(T));
+		}
+
+	public:
+		//! Maps all elements of \a da with access mode \a mode (blocking).
+		ScopedMapping(DeviceArray<T> &da, MapMode mode = mmReadWrite) {
+			map(da, 0, da.size(), mode);
+		}
+
+		//! Maps the elements in [\a first, \a last) of \a da with access mode \a mode (blocking).
+		ScopedMapping(DeviceArray<T> &da, index_t first, index_t last, MapMode mode = mmReadWrite) {
+			map(da, first, last, mode);
+		}
+
+		//! Destructor. Enqueues an unmap command if still mapped.
+		~ScopedMapping() {
+			unmap();
+		}
+
+		//! Enqueues a command for unmapping the mapped elements; the mapping must not be accessed afterwards.
+		/**
+		 * @param eventUnmap   if not 0, returns an event object that identifies the unmap command.
+		 * @param events       if not 0, specifies events that need to complete before the unmap command can be executed.
+		 */
+		void unmap(cl::Event *eventUnmap = 0, const cl::vector<cl::Event> *events = 0) {
+			if(m_ptr != 0) {
+				m_devCon->enqueueUnmapMemObject(m_buffer, m_ptr, m_nElements*sizeof(T), events, eventUnmap);
+				m_ptr = 0;
+			}
+		}
+
+		//! Returns true if the elements are still mapped.
+		bool isMapped() const { return m_ptr != 0; }
+
+		//! Returns the number of mapped elements.
+		index_t size() const { return m_nElements; }
+
+		//! Returns a reference to the <i>i</i>-th mapped element.
+		T &operator[](index_t i) const { return m_ptr[i]; }
+
+		//! Returns a pointer to the first mapped element.
+		T *begin() const { return m_ptr; }
+
+		//! Returns a pointer to one past the last mapped element.
+		T *end() const { return m_ptr + m_nElements; }
 	};
 
 
@@ -209,26 +440,26 @@ namespace tbt
 		/**
 		 * This constructor can only be called from class DeviceArray.
 		 */
-		_MappedArrayConstIterator(index_t index, const MappedArray<T> *mappedArray) : _DeviceArrayConstIterator(index,mappedArray) { }
+		_MappedArrayConstIterator(index_t index, const MappedArray<T> *mappedArray) : _DeviceArrayConstIterator<T>(index,mappedArray) { }
 
 	public:
 		//! The reference type for this iterator.
 		typedef typename MappedArray<T>::const_reference reference;
 
 		//! Constructs an invalid const-iterator.
-		_MappedArrayConstIterator() : _DeviceArrayConstIterator() { }
+		_MappedArrayConstIterator() : _DeviceArrayConstIterator<T>() { }
 
 		//! Copy constructor. Constructs a const-iterator pointing to the same position as \a iter.
-		_MappedArrayConstIterator(const _MappedArrayConstIterator<T> &iter) : _DeviceArrayConstIterator(iter) { }
+		_MappedArrayConstIterator(const _MappedArrayConstIterator<T> &iter) : _DeviceArrayConstIterator<T>(iter) { }
 
 		//! Constructs a const-iterator pointing to the same position as iterator \a iter.
-		_MappedArrayConstIterator(const _MappedArrayIterator<T> &iter) : _DeviceArrayConstIterator(iter) { }
+		_MappedArrayConstIterator(const _MappedArrayIterator<T> &iter) : _DeviceArrayConstIterator<T>(iter) { }
 
 		//! Returns the mapped array this iterator points to.
 		/**
 		 * Returns 0 if this is an invalid const-iterator.
 		 */
-		const MappedArray<T> *getMappedArray() const { return (const MappedArray<T> *)getDeviceArray(); }
+		const MappedArray<T> *getMappedArray() const { return (const MappedArray<T> *)this->getDeviceArray(); }
 
 		//! Assignment operator.
 		_MappedArrayConstIterator<T> &operator=(const _MappedArrayConstIterator<T> &iter) {
@@ -238,7 +469,7 @@ namespace tbt
 
 		//! Returns a reference to the element in the mapped array this iterator points to.
 		reference operator*() const {
-			return (*getMappedArray())[getIndex()];
+			return (*getMappedArray())[this->getIndex()];
 		}
 
 	};
@@ -257,23 +488,23 @@ namespace tbt
 		/**
 		 * This constructor can only be called from class DeviceArray.
 		 */
-		_MappedArrayIterator(index_t index, MappedArray<T> *mappedArray) : _DeviceArrayIterator(index,mappedArray) { }
+		_MappedArrayIterator(index_t index, MappedArray<T> *mappedArray) : _DeviceArrayIterator<T>(index,mappedArray) { }
 
 	public:
 		//! The reference type for this iterator.
 		typedef typename MappedArray<T>::reference reference;
 
 		//! Constructs an invalid iterator.
-		_MappedArrayIterator() : _DeviceArrayIterator() { }
+		_MappedArrayIterator() : _DeviceArrayIterator<T>() { }
 
 		//! Copy constructor. Constructs an iterator pointing to the same position as \a iter.
-		_MappedArrayIterator(const _MappedArrayIterator<T> &iter) : _DeviceArrayIterator(iter) { }
+		_MappedArrayIterator(const _MappedArrayIterator<T> &iter) : _DeviceArrayIterator<T>(iter) { }
 
 		//! Returns the mapped array this iterator points to.
 		/**
 		 * Returns 0 if this is an invalid const-iterator.
 		 */
-		MappedArray<T> *getMappedArray() { return (MappedArray<T> *)getDeviceArray(); }
+		MappedArray<T> *getMappedArray() const { return (MappedArray<T> *)this->getDeviceArray(); }
 
 		//! Assignment operator.
 		_MappedArrayIterator<T> &operator=(const _MappedArrayIterator<T> &iter) {
@@ -283,7 +514,7 @@ namespace tbt
 
 		//! Returns a reference to the element in the mapped array this iterator points to.
 		reference operator*() const {
-			return (*getMappedArray())[getIndex()];
+			return (*getMappedArray())[this->getIndex()];
 		}
 
 	};
@@ -296,16 +527,16 @@ namespace tbt
 	typename MappedArray<T>::const_iterator MappedArray<T>::begin() const { return const_iterator(0,this); }
 
 	template<class T> inline
-	typename MappedArray<T>::iterator MappedArray<T>::end() { return iterator(m_nElements,this); }
+	typename MappedArray<T>::iterator MappedArray<T>::end() { return iterator(this->m_nElements,this); }
 
 	template<class T> inline
-	typename MappedArray<T>::const_iterator MappedArray<T>::end() const { return const_iterator(m_nElements,this); }
+	typename MappedArray<T>::const_iterator MappedArray<T>::end() const { return const_iterator(this->m_nElements,this); }
 
 	template<class T> inline
-	typename MappedArray<T>::iterator MappedArray<T>::rbegin() { return iterator(m_nElements-1,this); }
+	typename MappedArray<T>::iterator MappedArray<T>::rbegin() { return iterator(this->m_nElements-1,this); }
 
 	template<class T> inline
-	typename MappedArray<T>::const_iterator MappedArray<T>::rbegin() const { return const_iterator(m_nElements-1,this); }
+	typename MappedArray<T>::const_iterator MappedArray<T>::rbegin() const { return const_iterator(this->m_nElements-1,this); }
 
 	template<class T> inline
 	typename MappedArray<T>::iterator MappedArray<T>::rend() { return iterator(-1,this); }
@@ -40,10 +40,11 @@ namespace tbt
 		MappedStruct(DeviceController *devCon, cl_mem_flags flags = CL_MEM_READ_WRITE)
 			: DeviceStruct<T>()
 		{
-			m_devCon = devCon;
+			this->m_devCon = devCon;
 			m_ptr = (T *) Utility::alignedMalloc(sizeof(T),devCon->getMemBaseAddrAlign() >> 3);
-			m_buffer = cl::Buffer( devCon->getContext(),
+			this->m_buffer = cl::Buffer( devCon->getContext(),
 				CL_MEM_USE_HOST_PTR | (flags & (CL_MEM_READ_WRITE | CL_MEM_READ_ONLY | CL_MEM_WRITE_ONLY)), sizeof(T), m_ptr );
+			devCon->getCounters().trackBuffer(this->m_buffer, sizeof(T));
 		}
 
 		//! Destructor. Releases allocated memory.
@@ -84,7 +85,8 @@ namespace tbt
 		 * transfer to the host is completed. If the device is the CPU, no memory transfer is necessary.
 		 */
 		void mapDeviceToHostBlocking() {
-			m_devCon->getCommandQueue().enqueueMapBuffer(m_buffer, CL_TRUE, CL_MAP_READ, 0, sizeof(T));
+			this->m_devCon->enqueueOrderingBarrier();
+			this->m_devCon->enqueueMapBuffer(this->m_buffer, true, CL_MAP_READ, 0, sizeof(T));
 		}
 
 		//! Enqueues a command for mapping the strucutre on the device to the strucutre on the host; transfers data if necessary.
@@ -93,9 +95,10 @@ namespace tbt
 		 * this map command that can be queried (or waited for). If the device is the CPU, no memory transfer is necessary.
 		 *
 		 * @param eventMap   if not 0, returns an event object that identifies the map command.
+		 * @param events     if not 0, specifies events that need to complete before the map command can be executed.
 		 */
-		void mapDeviceToHost(cl::Event *eventMap = 0) {
-			m_devCon->getCommandQueue().enqueueMapBuffer(m_buffer, CL_FALSE, CL_MAP_READ, 0, sizeof(T), 0, eventMap);
+		void mapDeviceToHost(cl::Event *eventMap = 0, const cl::vector<cl::Event> *events = 0) {
+			this->m_devCon->enqueueMapBuffer(this->m_buffer, false, CL_MAP_READ, 0, sizeof(T), events, eventMap);
 		}
 
 		//! Enqueues a blocking command for mapping the strucutre on the host to the strucutre on the device; transfers data if necessary.
@@ -104,7 +107,8 @@ namespace tbt
 		 * transfer to the device is completed. If the device is the CPU, no memory transfer is necessary.
 		 */
 		void mapHostToDeviceBlocking() {
-			m_devCon->getCommandQueue().enqueueMapBuffer(m_buffer, CL_TRUE, CL_MAP_WRITE, 0, sizeof(T));
+			this->m_devCon->enqueueOrderingBarrier();
+			this->m_devCon->enqueueMapBuffer(this->m_buffer, true, CL_MAP_WRITE, 0, sizeof(T));
 		}
 
 		//! Enqueues a command for mapping the structure on the host to the strucutre on the device; transfers data if necessary.
@@ -113,9 +117,10 @@ namespace tbt
 		 * this map command that can be queried (or waited for). If the device is the CPU, no memory transfer is necessary.
 		 *
 		 * @param eventMap   if not 0, returns an event object that identifies the map command.
+		 * @param events     if not 0, specifies events that need to complete before the map command can be executed.
 		 */
-		void mapHostToDevice(cl::Event *eventMap = 0) {
-			m_devCon->getCommandQueue().enqueueMapBuffer(m_buffer, CL_FALSE, CL_MAP_WRITE, 0, sizeof(T), 0, eventMap);
+		void mapHostToDevice(cl::Event *eventMap = 0, const cl::vector<cl::Event> *events = 0) {
+			this->m_devCon->enqueueMapBuffer(this->m_buffer, false, CL_MAP_WRITE, 0, sizeof(T), events, eventMap);
 		}
 
 		//@}
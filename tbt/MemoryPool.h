@@ -0,0 +1,183 @@
+
+#ifndef _TBT_MEMORY_POOL_H
+#define _TBT_MEMORY_POOL_H
+
+#include <tbt/tbthc.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace tbt
+{
+
+	class DeviceCounters;
+
+	//! Caching allocator for OpenCL buffer objects of a device.
+	/**
+	 * Creating and releasing OpenCL buffer objects is expensive and fragments device memory if done frequently.
+	 * A memory pool keeps released buffers and hands them out again for later requests of the same size class
+	 * and memory flags. Sizes are rounded up to size classes (four classes per power of two), so a buffer may be
+	 * up to 25% larger than requested.
+	 *
+	 * Each device controller maintains a memory pool (see DeviceController::getMemoryPool()), which is used by
+	 * device arrays. A buffer is returned to the pool when the last lease referring to it is destroyed. Commands
+	 * using the buffer may still be pending at that time, possibly in other queues or in out-of-order queues, so
+	 * the pool hands the buffer out again only after a marker enqueued to each command queue of the device
+	 * controller after its release has completed; until then, requests of the same size class create new buffers.
+	 * Releasing a buffer enqueues nothing; the markers are enqueued when a request finds only such buffers
+	 * (covering all buffers released so far) or when fence() is called, e.g., by DeviceController::finish().
+	 * Commands enqueued to command queues not owned by the device controller are not covered by the markers.
+	 *
+	 * Leases keep the pool alive, so device arrays may outlive their device controller. Memory pools must
+	 * therefore be owned by a std::shared_ptr.
+	 *
+	 * All methods are thread-safe.
+	 *
+	 * \ingroup memobjects
+	 */
+	class MemoryPool : public std::enable_shared_from_this<MemoryPool>
+	{
+	public:
+		//! Statistics of a memory pool.
+		struct Statistics {
+			size_t   m_numHits;           //!< number of allocations served from cached buffers.
+			size_t   m_numMisses;         //!< number of allocations that required creating a new buffer.
+			size_t   m_numCachedBuffers;  //!< number of buffers currently cached (not in use).
+			size_t   m_numBuffersInUse;   //!< number of buffers currently in use.
+			cl_ulong m_bytesCached;       //!< total size of cached buffers in bytes.
+			cl_ulong m_bytesInUse;        //!< total size of buffers in use in bytes.
+		};
+
+		//! A buffer leased from a memory pool; returns the buffer to the pool on destruction.
+		class Lease
+		{
+			friend class MemoryPool;
+
+			std::shared_ptr<MemoryPool> m_pool;    //!< the pool owning the buffer.
+			cl::Buffer                  m_buffer;  //!< the leased buffer.
+			cl_mem_flags                m_flags;   //!< the memory flags of the buffer.
+			size_t                      m_size;    //!< the size (class) of the buffer in bytes.
+
+			Lease(const std::shared_ptr<MemoryPool> &pool, const cl::Buffer &buffer, cl_mem_flags flags, size_t size)
+				: m_pool(pool), m_buffer(buffer), m_flags(flags), m_size(size) { }
+
+			Lease(const Lease &);              // = delete
+			Lease &operator=(const Lease &);   // = delete
+
+		public:
+			//! Destructor. Returns the buffer to the pool.
+			~Lease() { m_pool->release(m_buffer, m_flags, m_size); }
+
+			//! Returns the leased buffer.
+			const cl::Buffer &getBuffer() const { return m_buffer; }
+
+			//! Returns the size of the leased buffer in bytes (which may be larger than the requested size).
+			size_t size() const { return m_size; }
+		};
+
+	private:
+		typedef std::pair<cl_mem_flags,size_t> Key;  //!< flags and size class of a cached buffer.
+
+		//! A cached buffer together with the markers that must complete before the buffer can be reused.
+		struct CachedBuffer {
+			cl::Buffer            m_buffer;  //!< the buffer.
+			cl::vector<cl::Event> m_fences;  //!< the markers enqueued after the buffer was released.
+			bool                  m_fenced;  //!< have the markers been enqueued?
+		};
+
+		typedef std::multimap<Key,CachedBuffer>::iterator CacheIterator;
+
+		cl::Context m_context;          //!< the context in which buffers are created.
+		DeviceCounters *m_counters;     //!< the counters tracking created buffers (or 0).
+		std::vector<cl::CommandQueue> m_queues;  //!< the command queues that may use the buffers.
+		size_t      m_maxBufferSize;    //!< the maximal size of a buffer object (no rounding beyond).
+		bool        m_enabled;          //!< shall buffers be cached at all?
+		cl_ulong    m_maxCachedBytes;   //!< upper bound on the total size of cached buffers.
+
+		std::multimap<Key,CachedBuffer> m_cache;  //!< the cached buffers.
+		size_t                        m_numUnfenced;  //!< number of cached buffers without markers.
+		Statistics                    m_stats;  //!< the current statistics.
+		mutable std::mutex            m_mutex;  //!< protects cache and statistics.
+
+		MemoryPool(const MemoryPool &);              // = delete
+		MemoryPool &operator=(const MemoryPool &);   // = delete
+
+		//! Returns \a buffer (with \a flags and \a size) to the pool; never throws.
+		/**
+		 * If the buffer cannot be cached, it is just released.
+		 */
+		void release(const cl::Buffer &buffer, cl_mem_flags flags, size_t size);
+
+		//! Returns a cached buffer with key \a key that can be reused, or m_cache.end(); requires m_mutex to be locked.
+		CacheIterator findReusable(const Key &key);
+
+		//! Enqueues markers for all cached buffers without markers; requires m_mutex to be locked.
+		void fenceReleased();
+
+	public:
+		//! Constructs a memory pool for buffers in \a context with a maximal buffer size of \a maxBufferSize bytes.
+		/**
+		 * If \a counters is not 0, all buffers created by the pool are tracked by \a counters (see DeviceCounters::trackBuffer()),
+		 * which must outlive all calls of allocate(). A released buffer is reused only after all commands enqueued to the
+		 * \a numQueues command queues starting at \a queues before its release have completed; the pool keeps references
+		 * to these queues (null queues are ignored).
+		 */
+		MemoryPool(const cl::Context &context, size_t maxBufferSize, DeviceCounters *counters = 0,
+			const cl::CommandQueue *queues = 0, size_t numQueues = 0);
+
+		//! Destructor. Releases all cached buffers; since leases keep the pool alive, no leases exist anymore.
+		~MemoryPool() { }
+
+		//! Leases a buffer of at least \a size bytes created with memory flags \a flags.
+		/**
+		 * @param[in] size   is the required size of the buffer in bytes.
+		 * @param[in] flags  are the memory flags of the buffer; must not contain host pointer flags.
+		 * @return           a lease for the buffer; the buffer is returned to the pool when the last
+		 *                   shared pointer to the lease is destroyed.
+		 */
+		std::shared_ptr<Lease> allocate(size_t size, cl_mem_flags flags = CL_MEM_READ_WRITE);
+
+		//! Enqueues markers covering all buffers released so far.
+		/**
+		 * Once all commands enqueued before have completed, e.g., after DeviceController::finish(), these
+		 * buffers are reused by the next requests.
+		 */
+		void fence();
+
+		//! Releases cached buffers until at most \a maxCachedBytes bytes are cached.
+		/**
+		 * Buffers in use are not affected. The largest buffers are released first.
+		 */
+		void trim(cl_ulong maxCachedBytes = 0);
+
+		//! Returns the current statistics of the pool.
+		Statistics getStatistics() const;
+
+		//! Resets the hit and miss counters.
+		void resetStatistics();
+
+		//! Returns true if released buffers are cached.
+		bool isEnabled() const { return m_enabled; }
+
+		//! Enables or disables caching of released buffers; disabling also releases all cached buffers.
+		void setEnabled(bool b);
+
+		//! Returns the upper bound on the total size of cached buffers in bytes.
+		cl_ulong getMaxCachedBytes() const { return m_maxCachedBytes; }
+
+		//! Sets the upper bound on the total size of cached buffers to \a maxBytes.
+		/**
+		 * Released buffers that would exceed this bound are not cached but released immediately.
+		 */
+		void setMaxCachedBytes(cl_ulong maxBytes);
+
+		//! Returns the size class for a buffer of \a size bytes.
+		static size_t sizeClass(size_t size);
+	};
+
+}
+
+#endif
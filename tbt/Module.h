@@ -3,6 +3,7 @@
 #define _TBT_MODULE_H
 
 #include "Global.h"
+#include "Timer.h"
 
 
 namespace tbt
@@ -11,7 +12,7 @@ namespace tbt
 	class Module
 	{
 		static cl::Program s_program;  //!< the OpenCL program of the module.
-		LARGE_INTEGER m_timer;         //!< stores high-performance counter.
+		Timer m_timer;                 //!< timer for measuring host-side running times.
 
 	public:
 		//! Constructs a module.
@@ -48,10 +49,14 @@ namespace tbt
 		static double getEventTime(cl::Event ev);
 
 		//! Start timer (for easy measuring of runtime).
-		void startTimer();
+		void startTimer() { m_timer.start(); }
 
-		//! Read current elapsed time (from startTimer() until now).
-		double readTimer();
+		//! Read current elapsed time (from startTimer() until now) in milliseconds.
+		/**
+		 * The time is measured on the host with a monotonic clock (see Timer), so it can be reported
+		 * alongside device event times (see getEventTime()).
+		 */
+		double readTimer() const { return m_timer.elapsed(); }
 	};
 
 }
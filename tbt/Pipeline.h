@@ -0,0 +1,177 @@
+
+#ifndef _TBT_PIPELINE_H
+#define _TBT_PIPELINE_H
+
+#include <tbt/DeviceArray.h>
+
+#include <functional>
+#include <vector>
+
+
+namespace tbt
+{
+
+	//! Streaming pipeline processing host arrays in chunks with overlapped transfers and kernel execution.
+	/**
+	 * A pipeline processes an input host array that does not need to fit into device memory. The input is
+	 * split into chunks of at most getChunkSize() elements. Each chunk is uploaded to the device, processed
+	 * by a user-supplied compute function, and the result is downloaded into the output host array.
+	 * Uploads, kernels and downloads are enqueued to the upload, compute and download queues of the device
+	 * controller (see QueueId) and synchronized by events only, so that the upload of chunk <i>i</i>+1, the
+	 * kernels for chunk <i>i</i>, and the download of chunk <i>i</i>-1 can run concurrently on devices with
+	 * independent copy engines.
+	 *
+	 * The pipeline keeps getDepth() sets of device buffers (2 for double buffering); chunk <i>i</i> uses buffer
+	 * set <i>i</i> mod depth, which is reused as soon as the previous chunk using it has been downloaded.
+	 *
+	 * DMA transfers require page-locked host memory; host arrays allocated with a page-aligned policy
+	 * (see HostAllocPolicy) can be transferred without intermediate copies by most drivers.
+	 *
+	 * \tparam TIn   is the element type of the input array.
+	 * \tparam TOut  is the element type of the output array.
+	 *
+	 * \ingroup memobjects
+	 */
+	template<class TIn, class TOut = TIn>
+	class Pipeline
+	{
+	public:
+		//! Type of the compute function called for each chunk.
+		/**
+		 * The function must enqueue all commands processing the chunk to queue \a queue of \a devCon (without
+		 * waiting for them), using the enqueue methods of DeviceController so that profiling and device counters
+		 * see them. It reads the \a n elements of the chunk from \a in and writes \a n results to \a out;
+		 * \a offset is the position of the chunk in the input array. Commands must not be enqueued to other queues.
+		 */
+		typedef std::function<void(DeviceController *devCon, QueueId queue, DeviceArray<TIn> &in, DeviceArray<TOut> &out, size_t offset, size_t n)> ComputeFunction;
+
+	private:
+		//! The device buffers and events of one pipeline stage.
+		struct Slot {
+			DeviceArray<TIn>  m_in;          //!< device buffer for input chunk.
+			DeviceArray<TOut> m_out;         //!< device buffer for output chunk.
+			cl::Event         m_evUpload;    //!< completion of the upload of the current chunk.
+			cl::Event         m_evCompute;   //!< completion of the kernels for the current chunk.
+			cl::Event         m_evDownload;  //!< completion of the download of the current chunk.
+			bool              m_used;        //!< has the slot been used before (are the events valid)?
+		};
+
+		DeviceController *m_devCon;     //!< the device controller on whose device the pipeline runs.
+		size_t            m_chunkSize;  //!< the (maximal) number of elements per chunk.
+		size_t            m_depth;      //!< the number of buffer sets.
+
+		cl::CommandQueue m_queueUpload;    //!< the queue for host-to-device transfers.
+		cl::CommandQueue m_queueCompute;   //!< the queue for kernels.
+		cl::CommandQueue m_queueDownload;  //!< the queue for device-to-host transfers.
+
+		std::vector<Slot> m_slots;  //!< the buffer sets (allocated on first run).
+
+	public:
+		//! Constructs a pipeline on the device of \a devCon.
+		/**
+		 * @param[in] devCon     is the device controller on whose device chunks are processed.
+		 * @param[in] chunkSize  is the maximal number of elements per chunk.
+		 * @param[in] depth      is the number of buffer sets (at least 2 for overlapping).
+		 */
+		Pipeline(DeviceController *devCon, size_t chunkSize, size_t depth = 2)
+			: m_devCon(devCon), m_chunkSize(chunkSize), m_depth(depth)
+		{
+			if(chunkSize == 0 || depth == 0)
+				throw Error("Pipeline: chunk size and depth must be positive!", Error::ecUnknown);
+
+			m_queueUpload   = devCon->getCommandQueue(qiUpload);
+			m_queueCompute  = devCon->getCommandQueue(qiCompute);
+			m_queueDownload = devCon->getCommandQueue(qiDownload);
+		}
+
+		//! Returns the maximal number of elements per chunk.
+		size_t getChunkSize() const { return m_chunkSize; }
+
+		//! Sets the maximal number of elements per chunk to \a chunkSize (releases the device buffers).
+		void setChunkSize(size_t chunkSize) {
+			if(chunkSize == 0)
+				throw Error("Pipeline: chunk size must be positive!", Error::ecUnknown);
+			m_chunkSize = chunkSize;
+			m_slots.clear();
+		}
+
+		//! Returns the number of buffer sets.
+		size_t getDepth() const { return m_depth; }
+
+		//! Sets the number of buffer sets to \a depth (releases the device buffers).
+		void setDepth(size_t depth) {
+			if(depth == 0)
+				throw Error("Pipeline: depth must be positive!", Error::ecUnknown);
+			m_depth = depth;
+			m_slots.clear();
+		}
+
+		//! Returns the associated device controller.
+		DeviceController *getDeviceController() const { return m_devCon; }
+
+		//! Processes \a input chunk by chunk with \a compute and stores the results in \a output.
+		/**
+		 * The method returns when all results have been stored in \a output. \a input and \a output may
+		 * be the same array if \a TIn and \a TOut are the same type.
+		 *
+		 * @param[in]     input    is the input array.
+		 * @param[in,out] output   is the output array; it is resized to the size of \a input if required.
+		 * @param[in]     compute  is the compute function enqueueing the kernels for a chunk.
+		 */
+		void run(const HostArray<TIn> &input, HostArray<TOut> &output, const ComputeFunction &compute)
+		{
+			const size_t n = input.size();
+			if(output.size() != n)
+				output.resize(n);
+
+			if(m_slots.empty()) {
+				m_slots.resize(m_depth);
+				for(size_t s = 0; s < m_depth; ++s) {
+					m_slots[s].m_in  = DeviceArray<TIn>(m_devCon, m_chunkSize);
+					m_slots[s].m_out = DeviceArray<TOut>(m_devCon, m_chunkSize);
+				}
+			}
+			for(size_t s = 0; s < m_depth; ++s)
+				m_slots[s].m_used = false;
+
+			cl::vector<cl::Event> waitEvents;
+
+			for(size_t offset = 0, chunk = 0; offset < n; offset += m_chunkSize, ++chunk) {
+				Slot &slot = m_slots[chunk % m_depth];
+				const size_t m = (n - offset < m_chunkSize) ? n - offset : m_chunkSize;
+
+				// upload may overwrite the input buffer once the kernels of the previous chunk in this slot are done
+				waitEvents.clear();
+				if(slot.m_used)
+					waitEvents.push_back(slot.m_evCompute);
+				m_devCon->enqueueWriteBuffer(slot.m_in.getBaseBuffer(), false, slot.m_in.getOffset()*sizeof(TIn),
+					m*sizeof(TIn), &input[offset], (slot.m_used) ? &waitEvents : 0, &slot.m_evUpload, qiUpload);
+
+				// kernels need the uploaded chunk and may overwrite the output buffer once it has been downloaded
+				waitEvents.clear();
+				waitEvents.push_back(slot.m_evUpload);
+				if(slot.m_used)
+					waitEvents.push_back(slot.m_evDownload);
+				m_queueCompute.enqueueWaitForEvents(waitEvents);
+				compute(m_devCon, qiCompute, slot.m_in, slot.m_out, offset, m);
+				m_queueCompute.enqueueMarker(&slot.m_evCompute);
+
+				waitEvents.clear();
+				waitEvents.push_back(slot.m_evCompute);
+				m_devCon->enqueueReadBuffer(slot.m_out.getBaseBuffer(), false, slot.m_out.getOffset()*sizeof(TOut),
+					m*sizeof(TOut), &output[offset], &waitEvents, &slot.m_evDownload, qiDownload);
+
+				slot.m_used = true;
+
+				m_queueUpload.flush();
+				m_queueCompute.flush();
+				m_queueDownload.flush();
+			}
+
+			m_queueDownload.finish();
+		}
+	};
+
+}
+
+#endif
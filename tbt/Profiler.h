@@ -0,0 +1,145 @@
+
+#ifndef _TBT_PROFILER_H
+#define _TBT_PROFILER_H
+
+#include <tbt/DeviceController.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+namespace tbt
+{
+
+	//! The category of a profiled command.
+	/**
+	 * \ingroup context
+	 */
+	enum ProfileCategory {
+		pcKernel,    //!< a kernel execution.
+		pcUpload,    //!< a host-to-device transfer (write buffer).
+		pcDownload,  //!< a device-to-host transfer (read buffer).
+		pcCopy,      //!< a device-to-device copy.
+		pcFill,      //!< filling a buffer with a pattern.
+		pcMap,       //!< mapping a buffer into host memory.
+		pcUnmap      //!< unmapping a previously mapped buffer.
+	};
+
+
+	//! Collects timing information of the commands enqueued by device controllers.
+	/**
+	 * A profiler is attached to one or more device controllers with DeviceController::setProfiler(). While
+	 * attached, every kernel launch, transfer, copy, fill, map and unmap enqueued through the device
+	 * controller (including those of device arrays, device structs, mapped arrays and mapped structs) is
+	 * recorded with its name, category, command queue and number of bytes moved.
+	 *
+	 * Recording only keeps the event of a command; the timestamps (queued, submit, start and end) are read
+	 * when the records are requested (getRecords(), printSummary(), writeChromeTrace()), which waits for all
+	 * recorded commands. Whenever many commands are pending, recording also reads the timestamps of those
+	 * that have already completed, so that their events are released. Timestamps are only available if the command queues have been created with
+	 * <tt>CL_QUEUE_PROFILING_ENABLE</tt>; commands without profiling information are dropped
+	 * (see numDropped()).
+	 *
+	 * The records can be written as a trace in the Chrome trace-event format, which can be viewed with
+	 * <tt>chrome://tracing</tt> or Perfetto. Each device appears as a process and each command queue as a
+	 * thread.
+	 *
+	 * All methods are thread-safe.
+	 *
+	 * \ingroup context
+	 */
+	class Profiler
+	{
+	public:
+		//! A profiled command.
+		struct Record {
+			std::string             m_name;      //!< the kernel name or the kind of transfer.
+			ProfileCategory         m_category;  //!< the category of the command.
+			cl::Device              m_device;    //!< the device of the device controller which enqueued the command.
+			QueueId                 m_queue;     //!< the command queue.
+			cl_ulong                m_bytes;     //!< the number of bytes moved (0 for kernels).
+			cl_ulong                m_queued;    //!< device time (in ns) when the command was enqueued.
+			cl_ulong                m_submit;    //!< device time (in ns) when the command was submitted to the device.
+			cl_ulong                m_start;     //!< device time (in ns) when the command started execution.
+			cl_ulong                m_end;       //!< device time (in ns) when the command finished execution.
+
+			//! Returns the execution time (from start to end) in milliseconds.
+			double time() const { return 1.e-6 * (m_end - m_start); }
+		};
+
+	private:
+		//! A recorded command whose timestamps have not been read yet.
+		struct Pending {
+			Record    m_record;  //!< the record (without timestamps).
+			cl::Event m_event;   //!< the event of the command.
+		};
+
+		std::vector<Pending> m_pending;       //!< commands recorded since the last resolve().
+		std::vector<Record>  m_records;       //!< commands with timestamps.
+		size_t               m_numDropped;    //!< number of commands without profiling information.
+		size_t               m_drainAt;       //!< number of pending commands at which completed ones are resolved.
+		mutable std::mutex   m_mutex;         //!< protects all members.
+
+		Profiler(const Profiler &);              // = delete
+		Profiler &operator=(const Profiler &);   // = delete
+
+		//! Reads the timestamps of pending command \a p (waits for it) and moves it to the records.
+		void resolve(Pending &p);
+
+		//! Reads the timestamps of all pending commands (waits for them); requires m_mutex to be locked.
+		void resolve();
+
+		//! Reads the timestamps of the leading pending commands that have completed; requires m_mutex to be locked.
+		void resolveCompleted();
+
+	public:
+		//! Constructs an empty profiler.
+		Profiler() : m_numDropped(0), m_drainAt(1024) { }
+
+		//! Records a command.
+		/**
+		 * This method is called by device controllers; it does not wait for the command.
+		 *
+		 * @param[in] devCon    is the device controller which enqueued the command.
+		 * @param[in] category  is the category of the command.
+		 * @param[in] name      is the kernel name or the kind of transfer.
+		 * @param[in] queue     is the command queue to which the command has been enqueued.
+		 * @param[in] bytes     is the number of bytes moved by the command.
+		 * @param[in] ev        is the event of the command.
+		 */
+		void record(const DeviceController *devCon, ProfileCategory category, const std::string &name,
+			QueueId queue, cl_ulong bytes, const cl::Event &ev);
+
+		//! Returns all records (waits for all recorded commands).
+		std::vector<Record> getRecords();
+
+		//! Returns the number of commands that have been dropped, since no profiling information was available.
+		size_t numDropped();
+
+		//! Removes all records.
+		void clear();
+
+		//! Writes a summary (number of calls, total time and bandwidth) per command name to \a os.
+		std::ostream &printSummary(std::ostream &os = std::cout);
+
+		//! Writes all records in Chrome trace-event format (JSON) to \a os.
+		/**
+		 * Timestamps are relative to the earliest queued timestamp and given in microseconds. Each event
+		 * carries its category, the number of bytes, and its queued and submit timestamps as arguments.
+		 */
+		void writeChromeTrace(std::ostream &os);
+
+		//! Writes all records in Chrome trace-event format (JSON) to file \a fileName.
+		/**
+		 * Throws an error if the file cannot be written.
+		 */
+		void writeChromeTrace(const std::string &fileName);
+
+		//! Returns the name of \a category (e.g., "kernel").
+		static const char *getCategoryName(ProfileCategory category);
+	};
+
+}
+
+#endif
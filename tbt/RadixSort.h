@@ -4,6 +4,7 @@
 
 #include <tbt/Module.h>
 #include <tbt/DeviceArray.h>
+#include <tbt/KernelPool.h>
 
 
 namespace tbt
@@ -11,25 +12,51 @@ namespace tbt
 
 	//! Radix-sort module.
 	/**
+	 * Different radix-sort modules can be run concurrently by different host threads, even on
+	 * the same device; a single module must not be run by several threads at the same time.
+	 *
 	 * \ingroup algorithm
 	 */
 	class RadixSort : public Module
 	{
-		static cl::Kernel  m_kernelCounting;
-		static cl::Kernel  m_kernelPermute;
-
-		static cl::Kernel  m_kernelPrescanSum;
-		static cl::Kernel  m_kernelPrescan;
-		static cl::Kernel  m_kernelPrescanWithOffset;
-
-		static cl::Kernel m_kernelPrescanUpSweep;
-		static cl::Kernel m_kernelPrescanDownSweep;
-
-		static cl::Kernel m_kernelPrescanReduce;
-		static cl::Kernel m_kernelPrescanLocal;
-		static cl::Kernel m_kernelPrescanLocal64;
-		static cl::Kernel m_kernelPrescanBottom;
-		static cl::Kernel m_kernelTester;
+		//! The kernels used by radix sort.
+		/**
+		 * Kernel objects store their arguments, hence each running sort needs its own instance
+		 * which is checked out from the kernel pool.
+		 */
+		struct Kernels {
+			cl::Kernel m_kernelCounting;
+			cl::Kernel m_kernelPermute;
+
+			cl::Kernel m_kernelPrescanSum;
+			cl::Kernel m_kernelPrescan;
+			cl::Kernel m_kernelPrescanWithOffset;
+
+			cl::Kernel m_kernelPrescanUpSweep;
+			cl::Kernel m_kernelPrescanDownSweep;
+
+			cl::Kernel m_kernelPrescanReduce;
+			cl::Kernel m_kernelPrescanLocal;
+			cl::Kernel m_kernelPrescanLocal64;
+			cl::Kernel m_kernelPrescanBottom;
+			cl::Kernel m_kernelTester;
+
+			//! Creates the kernels from \a program.
+			Kernels(const cl::Program &program);
+		};
+
+		static KernelPool<Kernels> s_kernelPool;  //!< kernel instances shared by all radix-sort modules.
+
+		//! The events of the kernels enqueued for one digit pass.
+		struct PassEvents {
+			cl::Event m_evCounting;
+			cl::Event m_evPrescanSum;
+			cl::Event m_evPrescanUpSweep;
+			cl::Event m_evPrescan;
+			cl::Event m_evPrescanDownSweep;
+			cl::Event m_evPrescanWithOffset;
+			cl::Event m_evPermute;
+		};
 
 		cl_uint m_nElements;
 		cl_uint m_numGroups;
@@ -37,51 +64,121 @@ namespace tbt
 		cl_uint m_prescanInterval;
 
 		DeviceController *m_devCon;
-		DeviceArray<cl_uint> *m_array_gcount;
-		DeviceArray<cl_uint> *m_array_psum;
+		DeviceArray<cl_uint> m_array_a;       //!< the array being sorted (shares its buffer until the sort has completed).
+		DeviceArray<cl_uint> m_array_b;       //!< temporary array for odd passes (kept until the sort has completed).
+		DeviceArray<cl_uint> m_array_gcount;  //!< group counters (kept until the sort has completed).
+		DeviceArray<cl_uint> m_array_psum;    //!< prescan sums (kept until the sort has completed).
+
+		PassEvents m_passEvents[4];  //!< the events of the last sort.
+		cl::Event  m_evDone;         //!< completion of the last sort (the permute kernel of the last pass).
+
+		mutable bool   m_timesValid;  //!< have the times of the last sort been read from the events?
+		mutable double m_tKernelCounting;
+		mutable double m_tKernelPrescanSum;
+		mutable double m_tKernelPrescan;
+		mutable double m_tKernelPrescanWithOffset;
+		mutable double m_tKernelPermute;
 
-		double m_tKernelCounting;
-		double m_tKernelPrescanSum;
-		double m_tKernelPrescan;
-		double m_tKernelPrescanWithOffset;
-		double m_tKernelPermute;
+		mutable double m_totalTime;
+		double         m_hostTime;  //!< host-side time of the last run() or runAsync() (in milliseconds).
 
-		double m_totalTime;
+		RadixSort(const RadixSort &);              // = delete
+		RadixSort &operator=(const RadixSort &);   // = delete
 
 	public:
 		//! Constructs a radix-sort module.
-		RadixSort() {
-			m_array_gcount = m_array_psum = 0;
-			m_devCon = 0;
+		RadixSort() : m_devCon(0), m_timesValid(true) {
+			m_tKernelCounting = m_tKernelPrescanSum = m_tKernelPrescan = m_tKernelPrescanWithOffset = m_tKernelPermute = 0.0;
+			m_totalTime = m_hostTime = 0.0;
 		}
 
-		//! Runs radix-sort for array \a a with \a n elements.
-		void run(DeviceArray<cl_uint> &devArray);
+		//! Destructor. Waits for a pending sort, since it uses temporary arrays owned by the module.
+		~RadixSort() { wait(); }
 
-		void run(DeviceArray<cl_uint>::iterator first, DeviceArray<cl_uint>::iterator last);
+		//! Runs radix-sort for array \a a with \a n elements.
+		/**
+		 * All kernels are ordered by events, so the sort also works correctly with out-of-order command queues.
+		 * The method returns when the array has been sorted.
+		 *
+		 * @param[in,out] devArray  is the array to be sorted.
+		 * @param[in]     events    if not 0, specifies events that need to complete before sorting can start
+		 *                          (e.g., the event of a non-blocking load of \a devArray).
+		 */
+		void run(DeviceArray<cl_uint> &devArray, const cl::vector<cl::Event> *events = 0);
+
+		//! Runs radix-sort for the subarray [\a first, \a last) of a device array.
+		/**
+		 * The subarray is sorted in-place using a sub-buffer (see DeviceArray::slice()). Hence, the position
+		 * of \a first in device memory must be a multiple of the device's base address alignment; otherwise,
+		 * an error with code Error::ecMisalignedSubArray is thrown.
+		 */
+		void run(DeviceArray<cl_uint>::iterator first, DeviceArray<cl_uint>::iterator last, const cl::vector<cl::Event> *events = 0);
+
+		//! Enqueues radix-sort for \a devArray and returns without waiting for the sort.
+		/**
+		 * All passes are enqueued to the compute queue at once; the returned event completes when the array
+		 * has been sorted. Hence, a sort can be queued behind a non-blocking load and ahead of a non-blocking
+		 * store (passing the returned event in its wait list) without any host synchronization.
+		 *
+		 * The module keeps temporary arrays until the sort has completed; enqueueing another sort with the
+		 * same module first waits for the pending one (use separate modules for concurrent sorts). The module
+		 * also keeps a copy of \a devArray sharing its buffer object until wait() is called, the next sort
+		 * is enqueued or the module is destroyed; hence, the caller may destroy \a devArray right away.
+		 *
+		 * @param[in,out] devArray  is the array to be sorted.
+		 * @param[in]     events    if not 0, specifies events that need to complete before sorting can start.
+		 * @return        an event that completes when the sort has completed.
+		 */
+		cl::Event runAsync(DeviceArray<cl_uint> &devArray, const cl::vector<cl::Event> *events = 0);
+
+		//! Enqueues radix-sort for the subarray [\a first, \a last) of a device array (see run() and runAsync()).
+		cl::Event runAsync(DeviceArray<cl_uint>::iterator first, DeviceArray<cl_uint>::iterator last, const cl::vector<cl::Event> *events = 0);
+
+		//! Waits until the last sort enqueued by this module has completed and releases the sorted array.
+		void wait();
+
+		//! Returns the event of the last sort (completes when the sort has completed).
+		const cl::Event &getEvent() const { return m_evDone; }
 
 		//! Returns total running time of counting kernels (in milliseconds).
-		double totalTimeKernelCounting         () const { return m_tKernelCounting; }
+		/**
+		 * The timing functions read the profiling information of the last sort on first use (waiting
+		 * for the sort if necessary). If the command queue has not been created with
+		 * CL_QUEUE_PROFILING_ENABLE, they return 0.
+		 */
+		double totalTimeKernelCounting         () const { updateTimes(); return m_tKernelCounting; }
 
 		//! Returns total running time of prescanSum kernels (in milliseconds).
-		double totalTimeKernelPrescanSum       () const { return m_tKernelPrescanSum;  }
+		double totalTimeKernelPrescanSum       () const { updateTimes(); return m_tKernelPrescanSum;  }
 
 		//! Returns total running time of prescan kernels (in milliseconds).
-		double totalTimeKernelPrescan          () const { return m_tKernelPrescan;  }
+		double totalTimeKernelPrescan          () const { updateTimes(); return m_tKernelPrescan;  }
 
 		//! Returns total running time of prescanWithOffset kernels (in milliseconds).
-		double totalTimeKernelPrescanWithOffset() const { return m_tKernelPrescanWithOffset;  }
+		double totalTimeKernelPrescanWithOffset() const { updateTimes(); return m_tKernelPrescanWithOffset;  }
 
 		//! Returns total running time of permute kernels (in milliseconds).
-		double totalTimeKernelPermute          () const { return m_tKernelPermute;  }
+		double totalTimeKernelPermute          () const { updateTimes(); return m_tKernelPermute;  }
 
 		//! Returns total running time of all kernels (in milliseconds).
 		double totalTimeKernels() const {
+			updateTimes();
 			return m_tKernelCounting + m_tKernelPrescanSum + m_tKernelPrescan + m_tKernelPrescanWithOffset + m_tKernelPermute;
 		}
 
-		//! Returns total running time (in milliseconds (including data transfer and kernel launch times).
-		double totalTime() const { return m_totalTime; }
+		//! Returns total running time (in milliseconds), from enqueueing the first kernel until completion of the last kernel.
+		/**
+		 * This includes kernel launch times and the time spent waiting for the events passed to run() or runAsync().
+		 */
+		double totalTime() const { updateTimes(); return m_totalTime; }
+
+		//! Returns the host-side time of the last sort (in milliseconds).
+		/**
+		 * For run(), this is the latency from the call until the array has been sorted; for runAsync(),
+		 * it is the time spent for enqueueing the sort. Unlike the other timing functions, this does
+		 * not require profiling to be enabled.
+		 */
+		double hostTime() const { return m_hostTime; }
 
 
 		static double testKernelPrescanReduce(DeviceArray<cl_uint> &a, DeviceArray<cl_uint> &sum, cl_uint n, cl_uint C);
@@ -90,9 +187,20 @@ namespace tbt
 		static double testKernelTester(DeviceArray<cl_uint> &a, DeviceArray<cl_uint> &sum, cl_uint n, cl_uint C);
 
 	private:
-		void runSingle(DeviceArray<cl_uint> &bufferSrc, DeviceArray<cl_uint> &bufferTgt, cl_uint shift);
+		//! Returns the number of prescan groups (256 or 65536) for \a numCounts group counters on \a devCon.
+		/**
+		 * The choice is based on the measured bandwidth and launch latency of the device (see DeviceController::getCharacteristics());
+		 * if the device has not been characterized, 65536 groups are used for large arrays. The device is never measured here.
+		 */
+		static cl_uint choosePrescanGroups(DeviceController *devCon, cl_uint numCounts);
+
+		void runSingle(Kernels &k, DeviceArray<cl_uint> &bufferSrc, DeviceArray<cl_uint> &bufferTgt, cl_uint shift,
+			const cl::vector<cl::Event> *events, PassEvents &ev);
+
+		void addKernelTimes(const PassEvents &ev) const;
 
-		static void assureKernelsLoaded();
+		//! Reads the times of the last sort from its events (if not done yet).
+		void updateTimes() const;
 	};
 
 }
@@ -0,0 +1,80 @@
+#ifndef _TBT_THREAD_POOL_H
+#define _TBT_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace tbt
+{
+
+	//! Pool of host threads for running tasks in parallel.
+	/**
+	 * The pool runs the tasks of one parallelFor() at a time; the calling thread participates in running the
+	 * tasks, so a pool with <i>k</i> worker threads runs up to <i>k</i>+1 tasks concurrently. Tasks are handed
+	 * out dynamically, so tasks of different lengths are balanced.
+	 *
+	 * The host algorithms use the default pool (see getDefault()), which has one thread per hardware thread.
+	 *
+	 * \ingroup algorithm
+	 */
+	class ThreadPool
+	{
+		std::vector<std::thread> m_threads;  //!< the worker threads.
+
+		std::mutex              m_mutex;      //!< protects the state of the current job.
+		std::condition_variable m_cvWork;     //!< signals a new job (or shutdown) to the workers.
+		std::condition_variable m_cvDone;     //!< signals that all workers have finished the current job.
+		std::mutex              m_runMutex;   //!< serializes calls of parallelFor().
+
+		const std::function<void(size_t)> *m_task;  //!< the task of the current job.
+		size_t              m_numTasks;       //!< the number of tasks of the current job.
+		std::atomic<size_t> m_nextTask;       //!< the next task to be run.
+		size_t              m_numActive;      //!< the number of workers still running tasks of the current job.
+		unsigned int        m_generation;     //!< incremented for each job.
+		bool                m_shutdown;       //!< true if the workers shall terminate.
+		std::exception_ptr  m_exception;      //!< the first exception thrown by a task of the current job.
+
+		ThreadPool(const ThreadPool &);              // = delete
+		ThreadPool &operator=(const ThreadPool &);   // = delete
+
+		//! Runs tasks of the current job until all tasks have been handed out.
+		void runTasks();
+
+		//! The main loop of a worker thread.
+		void workerLoop();
+
+	public:
+		//! Constructs a thread pool with \a numThreads threads (including the calling thread).
+		/**
+		 * @param[in] numThreads  is the number of threads running tasks; if 0, the number of hardware threads is used.
+		 */
+		explicit ThreadPool(unsigned int numThreads = 0);
+
+		//! Destructor. Terminates the worker threads.
+		~ThreadPool();
+
+		//! Returns the number of threads running tasks (the worker threads and the calling thread).
+		unsigned int numThreads() const { return (unsigned int)m_threads.size() + 1; }
+
+		//! Runs \a task(<i>i</i>) for <i>i</i> = 0, ..., \a numTasks-1 in parallel and returns when all tasks have completed.
+		/**
+		 * If tasks throw exceptions, the remaining tasks are still run and the first exception is rethrown.
+		 * Concurrent calls from different host threads are serialized; a task must not call parallelFor()
+		 * of the same pool.
+		 */
+		void parallelFor(size_t numTasks, const std::function<void(size_t)> &task);
+
+		//! Returns the default thread pool (created on first use).
+		static ThreadPool &getDefault();
+	};
+
+}
+
+
+#endif
@@ -0,0 +1,80 @@
+
+#ifndef _TBT_TIMER_H
+#define _TBT_TIMER_H
+
+#include <tbt/tbthc.h>
+
+
+namespace tbt
+{
+
+	//! Monotonic high-resolution timer for measuring host-side running times.
+	/**
+	 * The timer uses the system's monotonic clock with the best available resolution
+	 * (<tt>QueryPerformanceCounter</tt> on Windows, <tt>clock_gettime(CLOCK_MONOTONIC)</tt> on other systems),
+	 * so measured times are not affected by adjustments of the system time. Times are returned in
+	 * nanoseconds or in milliseconds, the unit also used for device event times (see Module::getEventTime()).
+	 *
+	 * \ingroup context
+	 */
+	class Timer
+	{
+		cl_ulong m_start;  //!< the time (in nanoseconds) when the timer was started.
+
+	public:
+		//! Constructs a timer and starts it.
+		Timer() { start(); }
+
+		//! (Re-)starts the timer.
+		void start() { m_start = now(); }
+
+		//! Returns the elapsed time since the timer was started in nanoseconds.
+		cl_ulong elapsedNanoseconds() const { return now() - m_start; }
+
+		//! Returns the elapsed time since the timer was started in milliseconds.
+		double elapsed() const { return 1.e-6 * (now() - m_start); }
+
+		//! Returns the current value of the monotonic clock in nanoseconds.
+		/**
+		 * The value has no defined origin; only differences between two values are meaningful.
+		 */
+		static cl_ulong now();
+	};
+
+
+	//! Measures the time from its construction to its destruction and adds it to a variable.
+	/**
+	 * A scoped timer makes it easy to measure the time spent in a block:
+	 * \code
+	 * double tUpload = 0.0;
+	 * {
+	 *     tbt::ScopedTimer timer(tUpload);
+	 *     devArray.loadBlocking(hostArray);
+	 * }   // tUpload now contains the time of the upload in milliseconds
+	 * \endcode
+	 * Since the time is accumulated, the same variable can be used for several blocks.
+	 *
+	 * \ingroup context
+	 */
+	class ScopedTimer
+	{
+		double &m_total;  //!< the variable to which the elapsed time is added.
+		Timer   m_timer;  //!< the timer started on construction.
+
+		ScopedTimer(const ScopedTimer &);              // = delete
+		ScopedTimer &operator=(const ScopedTimer &);   // = delete
+
+	public:
+		//! Constructs a scoped timer adding the elapsed time (in milliseconds) to \a total on destruction.
+		explicit ScopedTimer(double &total) : m_total(total) { }
+
+		//! Destructor. Adds the elapsed time to the variable passed to the constructor.
+		~ScopedTimer() { m_total += m_timer.elapsed(); }
+
+		//! Returns the time elapsed so far in milliseconds.
+		double elapsed() const { return m_timer.elapsed(); }
+	};
+
+}
+
+#endif
@@ -5,11 +5,20 @@
 
 #include <tbt/tbthc.h>
 
+#include <stdio.h>
+#include <time.h>
+
 
 namespace tbt
 {
 	class DeviceController;
 
+#ifdef _WIN32
+	typedef __time64_t FileTime;  //!< time of last modification of a file.
+#else
+	typedef time_t FileTime;      //!< time of last modification of a file.
+#endif
+
 
 	//! Collection of some static utility functions for file system and kernel caching.
 	class Utility
@@ -29,29 +38,134 @@ namespace tbt
 		 * @param[in] extensions specifies the extensions enabled when compiling the program.
 		 * @return               true if file creation was successful, otherwise false.
 		 */
-		static bool writeProgramInfoFile(const char *fileName, const DeviceController *devCon, cl_uint extensions = 0);
+		static bool writeProgramInfoFile(const char *fileName, const DeviceController *devCon, cl_uint extensions = 0, cl_ulong sourceHash = 0);
 
 		//! Checks the progam info file \a fileName if the cached binary is up-to-date.
 		/**
 		 * @param[in] fileName   is the file name of the info file.
 		 * @param[in] devCon     is the device controller corresponding to the info file.
 		 * @param[in] extensions specifies the extensions that should be enabled when compiling the program.
+		 * @param[in] sourceHash if not 0, the info file must have been written for program sources with this hash value.
 		 * @return               true if the info file could be read successfully and indicates
 		 *                       that the cached binaray is up-to-date; otherwise false is returned.
 		 */
-		static bool checkProgramInfoFile(const char *fileName, const DeviceController *devCon, cl_uint extensions = 0);
+		static bool checkProgramInfoFile(const char *fileName, const DeviceController *devCon, cl_uint extensions = 0, cl_ulong sourceHash = 0);
+
+		//! Registers the programs embedded into the library (only if TBT has been compiled with TBT_EMBED_KERNELS).
+		static void registerEmbeddedPrograms();
+
+		//! Returns the registered source of program \a progName, or 0 if no such source has been registered.
+		static const std::string *findProgramSource(const char *progName);
+
+		//! Creates the program \a progName from a registered binary matching the device of \a devCon (if any).
+		/**
+		 * @param[in] progName    is the name of the program.
+		 * @param[in] devCon      is the device controller for which the program shall be created.
+		 * @param[in] extensions  specifies the extensions enabled when compiling the program.
+		 * @param[out] program    is assigned the built program if a matching binary has been registered.
+		 * @return                true if a matching binary has been found and could be built, false otherwise.
+		 */
+		static bool buildProgramFromRegisteredBinary(const char *progName, const DeviceController *devCon, cl_uint extensions, cl::Program &program);
 
 	public:
-		//! Builds OpenCL program \a progName in the global context.
+		//! Returns the cache directory for the device of \a devCon in \a dir and creates it if necessary.
+		/**
+		 * The directory is a subdirectory of the program cache directory (see Global::getProgramCacheDir()).
+		 *
+		 * @param[in]  devCon  is the device controller.
+		 * @param[out] dir     is assigned the path of the directory.
+		 * @return             true if the directory exists (or could be created), false otherwise.
+		 */
+		static bool getDeviceCacheDir(const DeviceController *devCon, std::string &dir);
+
+		//! Returns the source of program \a progName.
+		/**
+		 * The source is the registered (or embedded) source of \a progName if present, otherwise the contents
+		 * of file \a progName in the directory of the executable. Throws an error with code Error::ecKernelFileNotFound
+		 * if neither exists.
+		 *
+		 * @param[in] progName  is the name of the program.
+		 * @return              the source of the program.
+		 */
+		static std::string getProgramSource(const char *progName);
+
+		//! Returns the binary of \a program (built for a single device).
+		static std::string getProgramBinary(const cl::Program &program);
+
+		//! Builds OpenCL program \a progName in the global context for the global device controller.
 		/**
 		 * @param[in] progName     is the file name of the OpenCL program, relative to the path of the executable.
 		 * @param[in] requiredExt  is a bitvector specifying the OpenCL extensions required to build \a progName.
 		 * @param[in] optionalExt  is a bitvector specifying optional OpenCL extensions; these extensions are not
 		 *                         required to build \a progName, but may be used by conditional compilation.
 		 * @return                 the build program.
+		 *
+		 * The binary is cached in the program cache directory (see Global::setCacheProgramBinaries()). If the
+		 * binary cannot be written, an error with code Error::ecProgramCacheError is thrown, unless the source
+		 * of \a progName has been registered; then the program is just not cached.
+		 *
+		 * This function is thread-safe; concurrent calls are serialized.
 		 */
 		static cl::Program buildProgram(const char *progName, cl_uint requiredExt = 0, cl_uint optionalExt = 0);
 
+		//! Builds OpenCL program \a progName for the device of \a devCon in its context.
+		/**
+		 * Works like buildProgram(const char*,cl_uint,cl_uint), but for any device controller. Kernels of a
+		 * program can only be launched on the devices it has been built for.
+		 *
+		 * @param[in] devCon       is the device controller.
+		 * @param[in] progName     is the file name of the OpenCL program, relative to the path of the executable.
+		 * @param[in] requiredExt  is a bitvector specifying the OpenCL extensions required to build \a progName.
+		 * @param[in] optionalExt  is a bitvector specifying optional OpenCL extensions.
+		 * @return                 the build program.
+		 */
+		static cl::Program buildProgram(DeviceController *devCon, const char *progName, cl_uint requiredExt = 0, cl_uint optionalExt = 0);
+
+		//! Registers \a source as the OpenCL source of program \a progName.
+		/**
+		 * Registered sources take precedence over source files, i.e., buildProgram() will not access the
+		 * file \a progName anymore. This allows to compile kernel sources into an executable.
+		 *
+		 * @param[in] progName  is the file name under which the program is requested by buildProgram().
+		 * @param[in] source    points to the OpenCL source of the program.
+		 * @param[in] length    is the length of \a source in characters.
+		 */
+		static void registerProgramSource(const char *progName, const char *source, size_t length);
+
+		//! Registers a precompiled binary of program \a progName for a specific device.
+		/**
+		 * The binary is only used by buildProgram() for devices with name \a deviceName and driver version
+		 * \a driverVersion if the program is requested with the same extensions. A registered binary is
+		 * used before any cached program binary, so no disk access is required for building the program.
+		 *
+		 * @param[in] progName       is the file name under which the program is requested by buildProgram().
+		 * @param[in] deviceName     is the name of the device (CL_DEVICE_NAME) the binary has been compiled for.
+		 * @param[in] driverVersion  is the driver version (CL_DRIVER_VERSION) the binary has been compiled with.
+		 * @param[in] extensions     specifies the extensions enabled when compiling the binary.
+		 * @param[in] binary         points to the program binary; the memory must stay valid.
+		 * @param[in] size           is the size of the program binary in bytes.
+		 */
+		static void registerProgramBinary(const char *progName, const char *deviceName, const char *driverVersion,
+			cl_uint extensions, const unsigned char *binary, size_t size);
+
+		//! Builds program \a progName and writes its binary as C++-source file \a fileName.
+		/**
+		 * The written file defines a function \a funcName that registers the binary with registerProgramBinary().
+		 * Compiling this file into an executable and calling the function before building the program yields
+		 * a binary bundle for the device of the global device controller.
+		 *
+		 * @param[in] progName     is the file name of the OpenCL program, relative to the path of the executable.
+		 * @param[in] fileName     is the name of the C++-source file to be written.
+		 * @param[in] funcName     is the name of the registration function defined in \a fileName.
+		 * @param[in] requiredExt  is a bitvector specifying the OpenCL extensions required to build \a progName.
+		 * @param[in] optionalExt  is a bitvector specifying optional OpenCL extensions.
+		 */
+		static void writeProgramBinaryBundle(const char *progName, const char *fileName, const char *funcName,
+			cl_uint requiredExt = 0, cl_uint optionalExt = 0);
+
+		//! Returns a 64-bit hash value (FNV-1a) of the \a length characters starting at \a str.
+		static cl_ulong hash(const char *str, size_t length);
+
 		//! Returns the string representation of \a i.
 		/**
 		 * @param[in] i  is the number to be converted to a string.
@@ -59,6 +173,12 @@ namespace tbt
 		 */
 		static std::string toString(cl_uint i);
 
+		//! Writes \a str as JSON string (enclosed in quotes) to \a os.
+		/**
+		 * Quotes and backslashes are escaped; control characters are replaced by spaces.
+		 */
+		static void writeJSONString(std::ostream &os, const std::string &str);
+
 		//! Returns the file path separator of the current system.
 		/**
 		 * @return the file path separator: <tt>'/'</tt> on Linux/Mac systems, and <tt>'\\'</tt> on Windows.
@@ -71,6 +191,15 @@ namespace tbt
 #endif
 		}
 
+		//! Returns the file handle of the file given by file descriptor \a pFile.
+		static int fileNumber(FILE *pFile) {
+#ifdef _WIN32
+			return _fileno(pFile);
+#else
+			return fileno(pFile);
+#endif
+		}
+
 		//! Returns the length (in bytes) of the file given by file handle \a fh.
 		/**
 		 * @param[in] fh  must be a valid file handle.
@@ -83,7 +212,7 @@ namespace tbt
 		 * @param[in] pFile  must be a valid file descriptor.
 		 * @return           the length of the file in bytes.
 		 */
-		static size_t getFileLength(FILE *pFile) { return getFileLength(_fileno(pFile)); }
+		static size_t getFileLength(FILE *pFile) { return getFileLength(fileNumber(pFile)); }
 
 		//! Returns the length (in bytes) of the file \a fileName.
 		/**
@@ -95,23 +224,23 @@ namespace tbt
 		//! Returns the time of last modification for file given by file handle \a fh.
 		/**
 		 * @param[in] fh  must be a valid file handle.
-		 * @return        the last time of modification as __time64_t structure.
+		 * @return        the last time of modification as FileTime.
 		 */
-		static __time64_t getFileModificationTime(int fh);
+		static FileTime getFileModificationTime(int fh);
 
 		//! Returns the time of last modification for file given by file descriptor \a pFile.
 		/**
 		 * @param[in] pFile  must be a valid file descriptor.
-		 * @return           the last time of modification as __time64_t structure.
+		 * @return           the last time of modification as FileTime.
 		 */
-		static __time64_t getFileModificationTime(FILE *pFile) { return getFileModificationTime(_fileno(pFile)); }
+		static FileTime getFileModificationTime(FILE *pFile) { return getFileModificationTime(fileNumber(pFile)); }
 
 		//! Returns the time of last modification for file \a fileName.
 		/**
 		 * @param[in] fileName  must be the file name.
-		 * @return              the last time of modification as __time64_t structure.
+		 * @return              the last time of modification as FileTime.
 		 */
-		static __time64_t getFileModificationTime(const char *fileName);
+		static FileTime getFileModificationTime(const char *fileName);
 
 		//! Returns the full path to the current executable.
 		/**
@@ -133,6 +262,18 @@ namespace tbt
 		 */
 		static void alignedFree(void *ptr);
 
+		//! Frees \a ptr (allocated with alignedMalloc()) once the OpenCL memory object \a memObject has been destroyed.
+		/**
+		 * Memory passed with <tt>CL_MEM_USE_HOST_PTR</tt> must stay valid as long as the memory object exists, which may be
+		 * longer than its creator holds a reference (e.g., if other objects share the memory object or commands are pending).
+		 *
+		 * @return true if the destructor callback could be registered; otherwise, the caller remains responsible for \a ptr.
+		 */
+		static bool alignedFreeWithMemObject(const cl::Memory &memObject, void *ptr);
+
+		//! Returns the page size of the virtual memory system in bytes.
+		static size_t getPageSize();
+
 		static int firstBit(cl_uint bits);
 
 		static std::string printBytes(cl_ulong bytes);
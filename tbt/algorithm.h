@@ -3,11 +3,23 @@
 
 
 #include <tbt/DeviceArray.h>
+#include <tbt/HostArray.h>
+#include <tbt/MappedArray.h>
 
 
 namespace tbt
 {
 
+	//! Selects where an algorithm on host memory is run.
+	/**
+	 * \ingroup algorithm
+	 */
+	enum Backend {
+		beAuto,    //!< on the host if no device is available, the array is small (see Global::setHostAlgorithmThreshold()), or the device does not support its size; otherwise on the device.
+		beHost,    //!< on the host, using the default thread pool (see ThreadPool).
+		beDevice   //!< on the first device of the global context; the array size must be a multiple of 1024.
+	};
+
 	//! Sorts a device array with radix-sort.
 	/**
 	 * @tparam T         is the data type to be sorted. Allowed types are (at the moment) only cl_uint.
@@ -37,6 +49,37 @@ namespace tbt
 	}
 
 
+	//! Sorts a host array with radix-sort.
+	/**
+	 * The host and the device backend produce identical results.
+	 *
+	 * @tparam T          is the data type to be sorted. Allowed types are (at the moment) only cl_uint.
+	 * @param  hostArray  is the host array to be sorted.
+	 * @param  backend    selects whether the array is sorted on the host (see HostRadixSort) or copied to the
+	 *                    first device of the global context and sorted there (see RadixSort).
+	 * \ingroup algorithm
+	 */
+	template<class T>
+	void radixSort(HostArray<T> &hostArray, Backend backend = beAuto) {
+		throw Error("radixSort: data type of host array not supported", Error::ecDataTypeNotSupported);
+	}
+
+	//! Sorts a mapped array with radix-sort.
+	/**
+	 * The host backend sorts the array in host memory, the device backend on the device associated with
+	 * \a mappedArray. The array is mapped to the host afterwards if and only if it has been mapped before.
+	 *
+	 * @tparam T            is the data type to be sorted. Allowed types are (at the moment) only cl_uint.
+	 * @param  mappedArray  is the mapped array to be sorted.
+	 * @param  backend      selects whether the array is sorted on the host or on the device.
+	 * \ingroup algorithm
+	 */
+	template<class T>
+	void radixSort(MappedArray<T> &mappedArray, Backend backend = beAuto) {
+		throw Error("radixSort: data type of mapped array not supported", Error::ecDataTypeNotSupported);
+	}
+
+
 	// specializations
 
 	template<>
@@ -45,6 +88,12 @@ namespace tbt
 	template<>
 	void radixSort<cl_uint>(typename DeviceArray<cl_uint>::iterator first, typename DeviceArray<cl_uint>::iterator last);
 
+	template<>
+	void radixSort<cl_uint>(HostArray<cl_uint> &hostArray, Backend backend);
+
+	template<>
+	void radixSort<cl_uint>(MappedArray<cl_uint> &mappedArray, Backend backend);
+
 }
 
 
@@ -62,7 +62,9 @@
 
 #define __NO_STD_VECTOR             // Use cl::vector instead of STL version
 #define __CL_ENABLE_EXCEPTIONS      // use exceptions
+#ifdef _MSC_VER
 #pragma warning( disable : 4290 )   // avoid useless warnings with Visual C++ and OpenCL exceptions
+#endif
 
 
 #include <CL/cl.hpp>
@@ -44,6 +44,7 @@ int main()
 		a.mapHostToDeviceBlocking();
 
 		tbt::MappedArray<cl_uint> sum(devCon, C);
+		sum.mapHostToDevice();
 		radixSort.testKernelTester(a, sum, n, C);
 
 		double tRed = 0, tLoc = 0, tBot = 0;
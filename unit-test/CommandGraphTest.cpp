@@ -0,0 +1,202 @@
+
+#include "CommandGraphTest.h"
+#include <tbt/CommandGraph.h>
+#include <tbt/DeviceArray.h>
+#include <tbt/KernelPool.h>
+#include <tbt/Profiler.h>
+#include <tbt/Global.h>
+
+using namespace std;
+
+
+bool CommandGraphTest::runTests()
+{
+	try {
+		testReplay();
+		testEvents();
+		testProfiler();
+
+	} catch(cl::Error error) {
+		cout << "OpenCL exception occurred:" << endl;
+		cout << "error code: " << error.err() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+
+	} catch(tbt::Error error) {
+		cout << "TBT exception occurred:" << endl;
+		cout << "error code: " << error.code() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+	}
+
+	return ( numberOfErrors() == 0 );
+}
+
+
+struct CommandGraphTestKernels {
+	cl::Kernel m_kernelAdd;
+	cl::Kernel m_kernelMul;
+
+	CommandGraphTestKernels(const cl::Program &program) : m_kernelAdd(program, "graphAdd"), m_kernelMul(program, "graphMul") { }
+};
+
+static tbt::KernelPool<CommandGraphTestKernels> s_kernels("command-graph-test.cl");
+
+
+//! Records a = ((a + 2) * 3) + 1 for array \a da into \a graph.
+static void recordGraph(tbt::CommandGraph &graph, tbt::DeviceArray<cl_uint> &da)
+{
+	const cl_uint n = (cl_uint)da.size();
+	const size_t globalWork = (n + 63) / 64 * 64;
+	const cl::Program &program = s_kernels.getProgram(da.getDeviceController());
+
+	cl::Kernel k1 = graph.addKernel(program, "graphAdd", globalWork, 64);
+	k1.setArg<cl::Buffer>(0, da);
+	k1.setArg<cl_uint>   (1, n);
+	k1.setArg<cl_uint>   (2, 2);
+
+	cl::Kernel k2 = graph.addKernel(program, "graphMul", globalWork, 64);
+	k2.setArg<cl::Buffer>(0, da);
+	k2.setArg<cl_uint>   (1, n);
+	k2.setArg<cl_uint>   (2, 3);
+
+	// same kernel function as k1, but with its own arguments
+	tbt::KernelPool<CommandGraphTestKernels>::Handle k = s_kernels.acquire(da.getDeviceController());
+	cl::Kernel k3 = graph.addKernel(k->m_kernelAdd, globalWork);
+	k3.setArg<cl::Buffer>(0, da);
+	k3.setArg<cl_uint>   (1, n);
+	k3.setArg<cl_uint>   (2, 1);
+}
+
+
+void CommandGraphTest::testReplay()
+{
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+
+	const size_t n = 100003;
+	tbt::HostArray<cl_uint> ha(n);
+	for(size_t i = 0; i < n; ++i)
+		ha[i] = (cl_uint) i;
+
+	tbt::DeviceArray<cl_uint> da(devCon, n);
+	da.loadBlocking(ha);
+
+	tbt::CommandGraph graph(devCon);
+	recordGraph(graph, da);
+
+	UTASSERT( graph.size() == 3 );
+	UTASSERT( !graph.isFinalized() );
+	graph.finalize();
+	UTASSERT( graph.isFinalized() );
+	cout << "  replay uses " << (graph.usesCommandBuffer() ? "cl_khr_command_buffer" : "pre-bound kernels") << endl;
+
+	// recording after finalize() is an error
+	bool thrown = false;
+	try {
+		graph.addKernel(s_kernels.getProgram(devCon), "graphAdd", 64);
+	} catch(tbt::Error) {
+		thrown = true;
+	}
+	UTASSERT( thrown );
+
+	const int numReplays = 4;
+	{
+		TimedScope timed(*this, "4 replays");
+		for(int r = 0; r < numReplays; ++r)
+			graph.replay();
+		devCon->finish();
+	}
+
+	da.storeBlocking(ha);
+
+	bool ok = true;
+	for(size_t i = 0; i < n; ++i) {
+		cl_uint x = (cl_uint) i;
+		for(int r = 0; r < numReplays; ++r)
+			x = (x + 2) * 3 + 1;
+		if(ha[i] != x)
+			ok = false;
+	}
+	UTASSERT( ok );
+}
+
+
+void CommandGraphTest::testEvents()
+{
+	//-------------------------------------------------------------------------
+	// load -> replay -> store chained by events
+	//-------------------------------------------------------------------------
+
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+
+	const size_t n = 4096;
+	tbt::HostArray<cl_uint> ha(n), hb(n);
+	for(size_t i = 0; i < n; ++i)
+		ha[i] = (cl_uint) (n - i);
+
+	tbt::DeviceArray<cl_uint> da(devCon, n);
+
+	tbt::CommandGraph graph(devCon);
+	recordGraph(graph, da);
+
+	cl::vector<cl::Event> waitList(1);
+	da.load(ha, &waitList[0], tbt::qiUpload);
+
+	cl::Event evGraph;
+	graph.replay(&waitList, &evGraph);
+
+	waitList[0] = evGraph;
+	cl::Event evStore;
+	da.store(hb, &evStore, tbt::qiDownload, &waitList);
+	evStore.wait();
+
+	bool ok = true;
+	for(size_t i = 0; i < n; ++i)
+		if(hb[i] != (ha[i] + 2) * 3 + 1)
+			ok = false;
+	UTASSERT( ok );
+
+	// an empty graph still signals its event
+	tbt::CommandGraph emptyGraph(devCon);
+	cl::Event evEmpty;
+	emptyGraph.replay(0, &evEmpty);
+	evEmpty.wait();
+	UTASSERT( !emptyGraph.usesCommandBuffer() );
+}
+
+
+void CommandGraphTest::testProfiler()
+{
+	//-------------------------------------------------------------------------
+	// replays are seen by an attached profiler
+	//-------------------------------------------------------------------------
+
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+	tbt::DeviceController profCon(devCon->getDevice(), devCon->getContext(), CL_QUEUE_PROFILING_ENABLE);
+
+	tbt::Profiler profiler;
+	profCon.setProfiler(&profiler);
+
+	const size_t n = 10000;
+	tbt::DeviceArray<cl_uint> da(&profCon, n);
+	da.fillBlocking(0);
+
+	tbt::CommandGraph graph(&profCon);
+	recordGraph(graph, da);
+	graph.finalize();
+	profiler.clear();
+
+	cl::Event evGraph;
+	graph.replay(0, &evGraph);
+	evGraph.wait();
+
+	vector<tbt::Profiler::Record> records = profiler.getRecords();
+	const size_t expected = graph.usesCommandBuffer() ? 1 : graph.size();
+	UTASSERT( records.size() == expected );
+	for(size_t i = 0; i < records.size(); ++i)
+		UTASSERT( records[i].m_category == tbt::pcKernel && records[i].m_end >= records[i].m_start );
+
+	profCon.setProfiler(0);
+}
@@ -0,0 +1,21 @@
+
+#ifndef _COMMAND_GRAPH_TEST
+#define _COMMAND_GRAPH_TEST
+
+#include "UnitTest.h"
+
+
+class CommandGraphTest : public UnitTest
+{
+public:
+	CommandGraphTest(bool silent = false) : UnitTest("CommandGraph", silent) { }
+
+	bool runTests();
+
+	void testReplay();
+	void testEvents();
+	void testProfiler();
+};
+
+
+#endif
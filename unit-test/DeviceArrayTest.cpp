@@ -1,7 +1,13 @@
 
 #include "DeviceArrayTest.h"
 #include <tbt/DeviceArray.h>
+#include <tbt/DeviceStruct.h>
+#include <tbt/MappedArray.h>
 #include <tbt/Global.h>
+#include <tbt/Utility.h>
+
+#include <chrono>
+#include <thread>
 
 using namespace std;
 
@@ -11,6 +17,11 @@ bool DeviceArrayTest::runTests()
 	try {
 		testLoadStore();
 		testIterators();
+		testMemoryPool();
+		testSlices();
+		testCopyFill();
+		testQueues();
+		testCounters();
 
 	} catch(cl::Error error) {
 		cout << "OpenCL exception occurred:" << endl;
@@ -264,3 +275,422 @@ void DeviceArrayTest::testIterators()
 	UTASSERT( (cit1 != cit1) == false );
 }
 
+
+void DeviceArrayTest::testMemoryPool()
+{
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+	tbt::MemoryPool &pool = devCon->getMemoryPool();
+
+	pool.trim();
+	pool.resetStatistics();
+
+	//-------------------------------------------------------------------------
+	// Released buffers are reused for arrays of the same size class
+	//-------------------------------------------------------------------------
+
+	const int n = 100000;
+	{
+		tbt::DeviceArray<cl_uint> da(devCon, n);
+		UTASSERT( pool.getStatistics().m_numBuffersInUse == 1 );
+
+		tbt::DeviceArray<cl_uint> daCopy(da);
+		UTASSERT( pool.getStatistics().m_numBuffersInUse == 1 );
+	}
+
+	tbt::MemoryPool::Statistics stats = pool.getStatistics();
+	UTASSERT( stats.m_numMisses == 1 && stats.m_numHits == 0 );
+	UTASSERT( stats.m_numBuffersInUse == 0 && stats.m_numCachedBuffers == 1 );
+	UTASSERT( stats.m_bytesCached == tbt::MemoryPool::sizeClass(n*sizeof(cl_uint)) );
+
+	// the released buffer becomes available once markers enqueued after its release have completed
+	devCon->finish();
+	{
+		tbt::DeviceArray<cl_uint> da(devCon, n-10);
+
+		cl_uint *ptrA = new cl_uint[n-10];
+		for(int i = 0; i < n-10; ++i)
+			ptrA[i] = 7*i;
+		da.loadBlocking(ptrA);
+
+		cl_uint *ptrB = new cl_uint[n-10];
+		da.storeBlocking(ptrB);
+
+		for(int i = 0; i < n-10; ++i)
+			UTASSERT( ptrA[i] == ptrB[i] );
+
+		delete [] ptrA;
+		delete [] ptrB;
+	}
+
+	stats = pool.getStatistics();
+	UTASSERT( stats.m_numHits == 1 && stats.m_numMisses == 1 );
+
+	//-------------------------------------------------------------------------
+	// Buffers released with pending commands are not reused before these complete
+	//-------------------------------------------------------------------------
+
+	pool.trim();
+	pool.resetStatistics();
+	devCon->finish();
+	{
+		cl::UserEvent userEvent(devCon->getContext());
+		cl::vector<cl::Event> waitList;
+		waitList.push_back(userEvent);
+
+		{
+			// the fill on the upload queue cannot start before the user event is set
+			tbt::DeviceArray<cl_uint> da(devCon, n);
+			da.fill(1, 0, tbt::qiUpload, &waitList);
+		}
+
+		{
+			tbt::DeviceArray<cl_uint> da(devCon, n);
+			stats = pool.getStatistics();
+			UTASSERT( stats.m_numHits == 0 && stats.m_numMisses == 2 && stats.m_numCachedBuffers == 1 );
+		}
+
+		userEvent.setStatus(CL_COMPLETE);
+		devCon->finish();
+
+		tbt::DeviceArray<cl_uint> da(devCon, n);
+		stats = pool.getStatistics();
+		UTASSERT( stats.m_numHits == 1 && stats.m_numMisses == 2 );
+	}
+
+	//-------------------------------------------------------------------------
+	// Releasing enqueues no markers; finish() fences all released buffers
+	//-------------------------------------------------------------------------
+
+	pool.trim();
+	pool.resetStatistics();
+	{
+		tbt::DeviceArray<cl_uint> a(devCon, n), b(devCon, 2*n);
+	}
+	devCon->finish();
+	{
+		tbt::DeviceArray<cl_uint> a(devCon, n), b(devCon, 2*n);
+		stats = pool.getStatistics();
+		UTASSERT( stats.m_numHits == 2 && stats.m_numMisses == 2 && stats.m_numCachedBuffers == 0 );
+	}
+
+	//-------------------------------------------------------------------------
+	// Device arrays may outlive their device controller
+	//-------------------------------------------------------------------------
+
+	{
+		tbt::DeviceController *tmpCon = new tbt::DeviceController(devCon->getDevice(), devCon->getContext());
+		tbt::DeviceArray<cl_uint> da(tmpCon, n);
+		da.fillBlocking(3);
+
+		tbt::DeviceArray<cl_uint> slice = da.slice(da.begin() + 16, da.end());
+		delete tmpCon;
+	}
+
+	//-------------------------------------------------------------------------
+	// trim() releases cached buffers
+	//-------------------------------------------------------------------------
+
+	pool.trim();
+	stats = pool.getStatistics();
+	UTASSERT( stats.m_numCachedBuffers == 0 && stats.m_bytesCached == 0 );
+
+	//-------------------------------------------------------------------------
+	// Size classes
+	//-------------------------------------------------------------------------
+
+	UTASSERT( tbt::MemoryPool::sizeClass(1)    == 256 );
+	UTASSERT( tbt::MemoryPool::sizeClass(513)  == 640 );
+	UTASSERT( tbt::MemoryPool::sizeClass(1024) == 1024 );
+	UTASSERT( tbt::MemoryPool::sizeClass(1025) == 1280 );
+}
+
+
+void DeviceArrayTest::testSlices()
+{
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+
+	const size_t n = 65536;
+	tbt::HostArray<cl_uint> ha(n);
+	for(size_t i = 0; i < n; ++i)
+		ha[i] = i;
+
+	tbt::DeviceArray<cl_uint> da(devCon, n);
+	da.loadBlocking(ha);
+
+	//-------------------------------------------------------------------------
+	// Slice starting at an aligned position (sub-buffer)
+	//-------------------------------------------------------------------------
+
+	const size_t align = (devCon->getMemBaseAddrAlign() >> 3) / sizeof(cl_uint);
+	const size_t first = 4*align, last = n - align;
+
+	tbt::DeviceArray<cl_uint> slice = da.slice(da.begin() + first, da.begin() + last);
+	UTASSERT( slice.size() == (tbt::index_t)(last-first) );
+	UTASSERT( slice.getOffset() == 0 );
+
+	tbt::HostArray<cl_uint> hb(last-first);
+	slice.storeBlocking(hb);
+	for(size_t i = 0; i < last-first; ++i)
+		UTASSERT( hb[i] == first+i );
+
+	// nested slice is again a sub-buffer of the original buffer
+	tbt::DeviceArray<cl_uint> slice2 = slice.slice(align, 2*align);
+	UTASSERT( slice2.size() == (tbt::index_t)align );
+	UTASSERT( slice2.getOffset() == 0 );
+
+	tbt::HostArray<cl_uint> hc(align);
+	slice2.storeBlocking(hc);
+	for(size_t i = 0; i < align; ++i)
+		UTASSERT( hc[i] == first+align+i );
+
+	//-------------------------------------------------------------------------
+	// Slice starting at a misaligned position (offset)
+	//-------------------------------------------------------------------------
+
+	if(align > 1) {
+		tbt::DeviceArray<cl_uint> sliceOff = da.slice(1, 101);
+		UTASSERT( sliceOff.size() == 100 );
+		UTASSERT( sliceOff.getOffset() == 1 );
+
+		tbt::HostArray<cl_uint> hd(100);
+		for(size_t i = 0; i < 100; ++i)
+			hd[i] = 1000000 + i;
+		sliceOff.loadBlocking(hd);
+
+		da.storeBlocking(ha);
+		UTASSERT( ha[0] == 0 && ha[101] == 101 );
+		for(size_t i = 0; i < 100; ++i)
+			UTASSERT( ha[1+i] == 1000000 + i );
+
+		// the buffer object does not start at the slice, so passing the slice to a kernel is an error
+		cl::Kernel kernel(tbt::Utility::buildProgram("command-graph-test.cl"), "graphAdd");
+		bool thrown = false;
+		try {
+			kernel.setArg<cl::Buffer>(0, sliceOff);
+		} catch(tbt::Error error) {
+			thrown = (error.code() == tbt::Error::ecMisalignedSubArray);
+		}
+		UTASSERT( thrown );
+		UTASSERT( sliceOff.getBaseBuffer()() == da.getBuffer()() );
+	}
+}
+
+
+void DeviceArrayTest::testCopyFill()
+{
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+
+	//-------------------------------------------------------------------------
+	// Copy whole arrays and subarrays on the device
+	//-------------------------------------------------------------------------
+
+	const size_t n = 30001;
+	tbt::HostArray<cl_uint> ha(n);
+	for(size_t i = 0; i < n; ++i)
+		ha[i] = 5*i;
+
+	tbt::DeviceArray<cl_uint> da(devCon, n), db(devCon, n);
+	{
+		TimedScope timed(*this, "load and copy");
+		da.loadBlocking(ha);
+		db.copyBlocking(da);
+	}
+
+	tbt::HostArray<cl_uint> hb(n);
+	db.storeBlocking(hb);
+	for(size_t i = 0; i < n; ++i)
+		UTASSERT( hb[i] == 5*i );
+
+	cl::Event eventCopy;
+	db.copy(db.begin() + 10, db.begin() + 110, da.begin() + 1000, &eventCopy);
+	eventCopy.wait();
+
+	db.storeBlocking(hb);
+	UTASSERT( hb[9] == 5*9 && hb[110] == 5*110 );
+	for(size_t i = 0; i < 100; ++i)
+		UTASSERT( hb[10+i] == 5*(1000+i) );
+
+	//-------------------------------------------------------------------------
+	// Fill with 4-byte, 1-byte and 8-byte values, with clEnqueueFillBuffer (if
+	// supported) and with the fill kernel
+	//-------------------------------------------------------------------------
+
+	for(int forceKernel = 0; forceKernel < 2; ++forceKernel) {
+		devCon->setForceFillKernel(forceKernel != 0);
+
+		{
+			TimedScope timed(*this, forceKernel ? "fill (kernel)" : "fill");
+			da.fillBlocking(0xdeadbeefu);
+		}
+		da.storeBlocking(ha);
+		for(size_t i = 0; i < n; ++i)
+			UTASSERT( ha[i] == 0xdeadbeefu );
+
+		cl::Event eventFill;
+		da.fill(da.begin() + 7, da.begin() + 20, 3, &eventFill);
+		eventFill.wait();
+
+		da.storeBlocking(ha);
+		UTASSERT( ha[6] == 0xdeadbeefu && ha[20] == 0xdeadbeefu );
+		for(size_t i = 7; i < 20; ++i)
+			UTASSERT( ha[i] == 3 );
+
+		tbt::DeviceArray<cl_uchar> dc(devCon, 1001);
+		dc.fillBlocking(0x7f);
+
+		tbt::HostArray<cl_uchar> hc(1001);
+		dc.storeBlocking(hc);
+		for(size_t i = 0; i < 1001; ++i)
+			UTASSERT( hc[i] == 0x7f );
+
+		tbt::DeviceArray<cl_ulong> dd(devCon, 777);
+		dd.fillBlocking(0x0123456789abcdefull);
+
+		tbt::HostArray<cl_ulong> hd(777);
+		dd.storeBlocking(hd);
+		for(size_t i = 0; i < 777; ++i)
+			UTASSERT( hd[i] == 0x0123456789abcdefull );
+	}
+	devCon->setForceFillKernel(false);
+
+	//-------------------------------------------------------------------------
+	// The fill kernel is built for each device (and context) and counted
+	//-------------------------------------------------------------------------
+
+	cl::vector<cl::Device> devices(1, devCon->getDevice());
+	tbt::DeviceController otherCon(devCon->getDevice(), cl::Context(devices));
+
+	for(int d = 0; d <= tbt::numDeviceControllers(); ++d) {
+		tbt::DeviceController *fillCon = (d < tbt::numDeviceControllers()) ? tbt::getDeviceController(d) : &otherCon;
+		fillCon->setForceFillKernel(true);
+
+		tbt::DeviceArray<cl_uint> df(fillCon, 1000);
+		cl_ulong numKernels = fillCon->getCounterValues().m_numKernels;
+		df.fillBlocking(9);
+		UTASSERT( fillCon->getCounterValues().m_numKernels == numKernels + 1 );
+
+		tbt::HostArray<cl_uint> hf(1000);
+		df.storeBlocking(hf);
+		for(size_t i = 0; i < 1000; ++i)
+			UTASSERT( hf[i] == 9 );
+
+		fillCon->setForceFillKernel(false);
+	}
+}
+
+
+void DeviceArrayTest::testQueues()
+{
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+
+	const size_t n = 100000;
+	tbt::HostArray<cl_uint> ha(n), hb(n);
+	for(size_t i = 0; i < n; ++i)
+		ha[i] = 5*i;
+
+	//-------------------------------------------------------------------------
+	// Upload, copy and download in different queues, synchronized by events
+	//-------------------------------------------------------------------------
+
+	tbt::DeviceArray<cl_uint> a(devCon, n), b(devCon, n);
+
+	cl::Event evLoad;
+	a.load(ha, &evLoad, tbt::qiUpload);
+	devCon->flush(tbt::qiUpload);
+	evLoad.wait();
+
+	b.copy(a);
+	b.fill(b.begin(), b.begin()+10, 7);
+	devCon->finish(tbt::qiCompute);
+
+	b.storeBlocking(hb, tbt::qiDownload);
+	for(size_t i = 0; i < 10; ++i)
+		UTASSERT( hb[i] == 7 );
+	for(size_t i = 10; i < n; ++i)
+		UTASSERT( hb[i] == 5*i );
+
+	//-------------------------------------------------------------------------
+	// finish() waits for all queues
+	//-------------------------------------------------------------------------
+
+	a.fillBlocking(0);
+	a.load(a.begin(), a.begin()+n/2, ha.begin(), 0, tbt::qiUpload);
+	a.load(a.begin()+n/2, a.end(), ha.begin()+n/2, 0, tbt::qiDownload);
+	devCon->finish();
+
+	a.storeBlocking(hb);
+	for(size_t i = 0; i < n; ++i)
+		UTASSERT( hb[i] == 5*i );
+}
+
+
+void DeviceArrayTest::testCounters()
+{
+	tbt::DeviceController *globalCon = tbt::getDeviceController();
+	tbt::DeviceController devCon(globalCon->getDevice(), globalCon->getContext());
+
+	tbt::DeviceCounters::Values v = devCon.getCounterValues();
+	UTASSERT( v.m_bytesLoaded == 0 && v.m_bytesStored == 0 && v.m_bytesMapped == 0 && v.m_numKernels == 0 );
+	UTASSERT( v.m_liveBufferBytes == 0 && v.m_highWaterMark == 0 );
+
+	const size_t n = 1 << 16;
+	const size_t bytes = n*sizeof(cl_uint);
+	tbt::HostArray<cl_uint> ha(n);
+
+	//-------------------------------------------------------------------------
+	// Transfers and kernels
+	//-------------------------------------------------------------------------
+
+	{
+		tbt::DeviceArray<cl_uint> a(&devCon, n);
+		v = devCon.getCounterValues();
+		UTASSERT( v.m_liveBufferBytes >= bytes );
+		UTASSERT( v.m_highWaterMark == v.m_liveBufferBytes );
+
+		a.loadBlocking(ha);
+		a.load(ha);
+		a.storeBlocking(ha);
+
+		tbt::DeviceStruct<cl_uint> s(&devCon);
+		cl_uint x = 1;
+		s.loadBlocking(x);
+
+		// fill may launch a kernel, depending on the OpenCL version
+		a.fillBlocking(0);
+
+		v = devCon.getCounterValues();
+		UTASSERT( v.m_bytesLoaded == 2*bytes + sizeof(cl_uint) );
+		UTASSERT( v.m_bytesStored == bytes );
+		UTASSERT( v.m_bytesMapped == 0 );
+		UTASSERT( v.m_numKernels <= 1 );
+
+		tbt::MappedArray<cl_uint> ma(&devCon, n);
+		v = devCon.getCounterValues();
+		UTASSERT( v.m_bytesMapped == bytes );
+	}
+
+	// the array is cached by the memory pool, the mapped array and struct are released; destructor
+	// callbacks may be called asynchronously by the OpenCL runtime, so give them some time
+	devCon.finish();
+	const cl_ulong cached = devCon.getMemoryPool().getStatistics().m_bytesCached;
+	for(int i = 0; i < 100 && devCon.getCounterValues().m_liveBufferBytes != cached; ++i)
+		this_thread::sleep_for(chrono::milliseconds(10));
+
+	v = devCon.getCounterValues();
+	UTASSERT( v.m_liveBufferBytes == cached );
+	UTASSERT( v.m_highWaterMark >= 2*bytes + sizeof(cl_uint) );
+
+	devCon.getMemoryPool().trim();
+	for(int i = 0; i < 100 && devCon.getCounterValues().m_liveBufferBytes != 0; ++i)
+		this_thread::sleep_for(chrono::milliseconds(10));
+	UTASSERT( devCon.getCounterValues().m_liveBufferBytes == 0 );
+
+	//-------------------------------------------------------------------------
+	// Reset
+	//-------------------------------------------------------------------------
+
+	devCon.resetCounters();
+	v = devCon.getCounterValues();
+	UTASSERT( v.m_bytesLoaded == 0 && v.m_bytesStored == 0 && v.m_bytesMapped == 0 && v.m_numKernels == 0 );
+	UTASSERT( v.m_highWaterMark == v.m_liveBufferBytes );
+}
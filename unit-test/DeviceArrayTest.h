@@ -14,6 +14,11 @@ public:
 
 	void testLoadStore();
 	void testIterators();
+	void testMemoryPool();
+	void testSlices();
+	void testCopyFill();
+	void testQueues();
+	void testCounters();
 };
 
 
@@ -0,0 +1,107 @@
+#include "DeviceControllerTest.h"
+#include <tbt/DeviceArray.h>
+#include <tbt/Global.h>
+#include <tbt/Utility.h>
+
+#include <fstream>
+#include <stdio.h>
+
+using namespace std;
+
+
+bool DeviceControllerTest::runTests()
+{
+	try {
+		testCharacteristics();
+		testContendedCharacterization();
+
+	} catch(cl::Error error) {
+		cout << "OpenCL exception occurred:" << endl;
+		cout << "error code: " << error.err() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+
+	} catch(tbt::Error error) {
+		cout << "TBT exception occurred:" << endl;
+		cout << "error code: " << error.code() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+	}
+
+	return ( numberOfErrors() == 0 );
+}
+
+
+void DeviceControllerTest::testCharacteristics()
+{
+	tbt::DeviceController *globalCon = tbt::getDeviceController();
+	tbt::DeviceController devCon(globalCon->getDevice(), globalCon->getContext());
+
+	// the characteristics are invalid until the device has been characterized
+	UTASSERT( !devCon.getCharacteristics().isValid() );
+
+	// the characteristics are determined once; the micro-benchmarks are not counted
+	{
+		TimedScope timed(*this, "characterize");
+		devCon.characterize();
+	}
+	const tbt::DeviceCharacteristics &c = devCon.getCharacteristics();
+	UTASSERT( c.isValid() );
+	UTASSERT( c.m_globalBandwidth > 0 && c.m_localBandwidth > 0 && c.m_atomicsThroughput > 0 && c.m_launchLatency > 0 );
+	devCon.characterize();
+	UTASSERT( &devCon.getCharacteristics() == &c );
+	UTASSERT( devCon.getCounterValues().m_numKernels == 0 );
+
+	// the bandwidth estimate grows with the number of work-items up to the saturation point
+	UTASSERT( c.getBandwidth(c.m_saturationWorkItems) == c.m_globalBandwidth );
+	UTASSERT( c.getBandwidth(2*c.m_saturationWorkItems) == c.m_globalBandwidth );
+	UTASSERT( c.getBandwidth(1) <= c.m_globalBandwidth );
+
+	// round trip through a file
+	string fileName = tbt::Utility::getExePath() + "characteristics-test.info";
+	UTASSERT( c.save(fileName.c_str(), &devCon) );
+
+	tbt::DeviceCharacteristics c2;
+	UTASSERT( !c2.isValid() );
+	UTASSERT( c2.load(fileName.c_str(), &devCon) );
+	UTASSERT( c2.isValid() && c2.m_saturationWorkItems == c.m_saturationWorkItems );
+
+	remove(fileName.c_str());
+	UTASSERT( !c2.load(fileName.c_str(), &devCon) );
+}
+
+
+void DeviceControllerTest::testContendedCharacterization()
+{
+	tbt::DeviceController *globalCon = tbt::getDeviceController();
+
+	string dir;
+	if(!tbt::globalConfig.getCacheProgramBinaries() || !tbt::Utility::getDeviceCacheDir(globalCon, dir))
+		return;
+	string fileName = dir + tbt::Utility::getPathSeparator() + "characteristics.info";
+
+	//-------------------------------------------------------------------------
+	// Characterizing does not wait for pending commands and does not cache
+	// results measured while commands are pending
+	//-------------------------------------------------------------------------
+
+	tbt::DeviceController devCon(globalCon->getDevice(), globalCon->getContext());
+	tbt::DeviceArray<cl_uint> da(&devCon, 1024);
+
+	cl::UserEvent userEvent(devCon.getContext());
+	cl::vector<cl::Event> waitList;
+	waitList.push_back(userEvent);
+	da.fill(1, 0, tbt::qiCompute, &waitList);
+
+	// the cache file is written again by the next uncontended characterization
+	remove(fileName.c_str());
+
+	devCon.characterize();
+	UTASSERT( devCon.getCharacteristics().isValid() );
+	UTASSERT( !ifstream(fileName.c_str()) );
+
+	userEvent.setStatus(CL_COMPLETE);
+	devCon.finish();
+}
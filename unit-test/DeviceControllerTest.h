@@ -0,0 +1,19 @@
+#ifndef _DEVICE_CONTROLLER_TEST
+#define _DEVICE_CONTROLLER_TEST
+
+#include "UnitTest.h"
+
+
+class DeviceControllerTest : public UnitTest
+{
+public:
+	DeviceControllerTest(bool silent = false) : UnitTest("DeviceController", silent) { }
+
+	bool runTests();
+
+	void testCharacteristics();
+	void testContendedCharacterization();
+};
+
+
+#endif
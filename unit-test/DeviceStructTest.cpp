@@ -50,8 +50,11 @@ void DeviceStructTest::testLoadStore()
 
 	tbt::DeviceStruct<Data> ds(devCon);
 
-	ds.loadBlocking (v1);
-	ds.storeBlocking(v2);
+	{
+		TimedScope timed(*this, "load and store");
+		ds.loadBlocking (v1);
+		ds.storeBlocking(v2);
+	}
 
 	UTASSERT( v2.m_n    == 2500    );
 	UTASSERT( v2.m_x    == 24.2f   );
@@ -0,0 +1,162 @@
+
+#include "HostArrayTest.h"
+#include <tbt/HostArray.h>
+#include <tbt/Utility.h>
+#include <string>
+
+using namespace std;
+
+
+bool HostArrayTest::runTests()
+{
+	testCopyMove();
+	testResize();
+	testAllocPolicies();
+
+	return ( numberOfErrors() == 0 );
+}
+
+
+static tbt::HostArray<cl_uint> createSequence(size_t n)
+{
+	tbt::HostArray<cl_uint> ha(n);
+	for(size_t i = 0; i < n; ++i)
+		ha[i] = (cl_uint) i;
+	return ha;
+}
+
+
+void HostArrayTest::testCopyMove()
+{
+	//-------------------------------------------------------------------------
+	// Copy and move construction
+	//-------------------------------------------------------------------------
+
+	const size_t n = 1000;
+	tbt::HostArray<cl_uint> a = createSequence(n);
+	UTASSERT( a.size() == n && a[n-1] == n-1 );
+
+	const cl_uint *p = a.data();
+	tbt::HostArray<cl_uint> b(std::move(a));
+	UTASSERT( b.data() == p && b.size() == n );
+	UTASSERT( a.size() == 0 && a.data() == 0 );
+
+	tbt::HostArray<cl_uint> c(b);
+	UTASSERT( c.data() != b.data() && c.size() == n );
+	for(size_t i = 0; i < n; ++i)
+		UTASSERT( c[i] == i );
+
+	//-------------------------------------------------------------------------
+	// Copy and move assignment, swap
+	//-------------------------------------------------------------------------
+
+	tbt::HostArray<cl_uint> d(2*n);
+	const cl_uint *q = d.data();
+	d = c;
+	UTASSERT( d.data() == q && d.size() == n && d.capacity() == 2*n );
+	for(size_t i = 0; i < n; ++i)
+		UTASSERT( d[i] == i );
+
+	a = std::move(d);
+	UTASSERT( a.data() == q && d.size() == 0 && d.capacity() == 0 );
+
+	swap(a, d);
+	UTASSERT( d.data() == q && a.data() == 0 );
+
+	// copying trivially copyable elements uses memcpy
+	const size_t m = 1 << 22;
+	tbt::HostArray<cl_uint> big = createSequence(m), bigCopy;
+	{
+		TimedScope timed(*this, "copy 2^22 elements");
+		bigCopy = big;
+	}
+	UTASSERT( bigCopy.size() == m && bigCopy[0] == 0 && bigCopy[m-1] == m-1 );
+
+	//-------------------------------------------------------------------------
+	// Non-trivial element type
+	//-------------------------------------------------------------------------
+
+	tbt::HostArray<string> s(3);
+	s[0] = "abc"; s[2] = "xyz";
+	tbt::HostArray<string> t(s);
+	s = tbt::HostArray<string>(1);
+	UTASSERT( t[0] == "abc" && t[1].empty() && t[2] == "xyz" );
+	UTASSERT( s.size() == 1 && s[0].empty() );
+}
+
+
+void HostArrayTest::testResize()
+{
+	const size_t n = 500;
+	tbt::HostArray<cl_uint> a = createSequence(n);
+
+	a.reserve(4*n);
+	UTASSERT( a.capacity() == 4*n && a.size() == n );
+	for(size_t i = 0; i < n; ++i)
+		UTASSERT( a[i] == i );
+
+	// growing within capacity does not reallocate
+	const cl_uint *p = a.data();
+	a.resize(3*n);
+	UTASSERT( a.data() == p && a.size() == 3*n );
+
+	a.resize(n/2);
+	UTASSERT( a.data() == p && a.size() == n/2 && a[n/2-1] == n/2-1 );
+
+	a.shrinkToFit();
+	UTASSERT( a.capacity() == n/2 );
+	for(size_t i = 0; i < n/2; ++i)
+		UTASSERT( a[i] == i );
+
+	a.resize(2*n);
+	UTASSERT( a.size() == 2*n && a.capacity() >= 2*n && a[0] == 0 );
+
+	a.clear();
+	UTASSERT( a.empty() && a.capacity() >= 2*n );
+
+	tbt::HostArray<string> s(2);
+	s[1] = "abc";
+	s.resize(100);
+	UTASSERT( s[1] == "abc" && s[99].empty() );
+}
+
+
+void HostArrayTest::testAllocPolicies()
+{
+	const size_t pageSize = tbt::Utility::getPageSize();
+	const size_t n = 300000;
+
+	tbt::HostAllocPolicy policies[] = {
+		tbt::HostAllocPolicy(),
+		tbt::HostAllocPolicy(tbt::hmPageAligned),
+		tbt::HostAllocPolicy(tbt::hmHugePages),
+		tbt::HostAllocPolicy(tbt::hmPageAligned, 0),
+		tbt::HostAllocPolicy(tbt::hmPageAligned, -1, 4)
+	};
+
+	for(int k = 0; k < 5; ++k) {
+		tbt::HostArray<cl_uint> a(n, policies[k]);
+		UTASSERT( a.getPolicy().m_kind == policies[k].m_kind );
+
+		size_t alignment = (policies[k].usesPages()) ? pageSize : 64;
+		UTASSERT( ((size_t)a.data() & (alignment-1)) == 0 );
+
+		// first-touch initialization sets the memory to zero
+		if(policies[k].m_firstTouchThreads > 0) {
+			UTASSERT( a[0] == 0 && a[n/2] == 0 && a[n-1] == 0 );
+		}
+
+		for(size_t i = 0; i < n; ++i)
+			a[i] = (cl_uint) i;
+
+		// copies and reallocations keep the policy
+		tbt::HostArray<cl_uint> b(a);
+		UTASSERT( b.getPolicy().m_kind == policies[k].m_kind );
+		UTASSERT( ((size_t)b.data() & (alignment-1)) == 0 );
+
+		b.resize(2*n);
+		UTASSERT( ((size_t)b.data() & (alignment-1)) == 0 );
+		for(size_t i = 0; i < n; ++i)
+			UTASSERT( b[i] == i );
+	}
+}
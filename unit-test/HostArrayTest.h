@@ -0,0 +1,21 @@
+
+#ifndef _HOST_ARRAY_TEST
+#define _HOST_ARRAY_TEST
+
+#include "UnitTest.h"
+
+
+class HostArrayTest : public UnitTest
+{
+public:
+	HostArrayTest(bool silent = false) : UnitTest("HostArray", silent) { }
+
+	bool runTests();
+
+	void testCopyMove();
+	void testResize();
+	void testAllocPolicies();
+};
+
+
+#endif
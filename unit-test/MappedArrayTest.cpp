@@ -0,0 +1,341 @@
+
+#include "MappedArrayTest.h"
+#include <tbt/MappedArray.h>
+#include <tbt/Global.h>
+
+using namespace std;
+
+
+bool MappedArrayTest::runTests()
+{
+	try {
+		testMapUnmap();
+		testScopedMapping();
+		testStrategies();
+		testDeviceArrayTransfers();
+		testSharedBuffer();
+		testWaitEvents();
+
+	} catch(cl::Error error) {
+		cout << "OpenCL exception occurred:" << endl;
+		cout << "error code: " << error.err() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+
+	} catch(tbt::Error error) {
+		cout << "TBT exception occurred:" << endl;
+		cout << "error code: " << error.code() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+	}
+
+	return ( numberOfErrors() == 0 );
+}
+
+
+void MappedArrayTest::testMapUnmap()
+{
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+
+	//-------------------------------------------------------------------------
+	// Host -> device -> host with device-side modification
+	//-------------------------------------------------------------------------
+
+	const size_t n = 40000;
+	tbt::MappedArray<cl_uint> ma(devCon, n);
+	UTASSERT( ma.isMapped() );
+
+	for(size_t i = 0; i < n; ++i)
+		ma[i] = 3*i;
+
+	tbt::DeviceArray<cl_uint> da(devCon, n);
+	{
+		TimedScope timed(*this, "unmap and copy");
+		cl::Event eventUnmap;
+		ma.mapHostToDevice(&eventUnmap);
+		UTASSERT( !ma.isMapped() );
+
+		da.copyBlocking(ma);
+	}
+
+	ma.fillBlocking(11);
+
+	{
+		TimedScope timed(*this, "map for reading");
+		ma.mapDeviceToHostBlocking(tbt::mmRead);
+	}
+	UTASSERT( ma.isMapped() );
+	for(size_t i = 0; i < n; ++i)
+		UTASSERT( ma[i] == 11 );
+
+	tbt::HostArray<cl_uint> ha(n);
+	da.storeBlocking(ha);
+	for(size_t i = 0; i < n; ++i)
+		UTASSERT( ha[i] == 3*i );
+
+	// mapping twice is a no-op
+	cl::Event eventMap;
+	ma.mapDeviceToHost(&eventMap);
+	eventMap.wait();
+	UTASSERT( ma.isMapped() && ma[n-1] == 11 );
+}
+
+
+void MappedArrayTest::testScopedMapping()
+{
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+
+	const size_t n = 10000;
+	tbt::HostArray<cl_uint> ha(n);
+	for(size_t i = 0; i < n; ++i)
+		ha[i] = i;
+
+	tbt::DeviceArray<cl_uint> da(devCon, n);
+	da.loadBlocking(ha);
+
+	//-------------------------------------------------------------------------
+	// Read a subrange
+	//-------------------------------------------------------------------------
+
+	{
+		tbt::ScopedMapping<cl_uint> m(da, 100, 300, tbt::mmRead);
+		UTASSERT( m.isMapped() && m.size() == 200 );
+		for(size_t i = 0; i < 200; ++i)
+			UTASSERT( m[i] == 100+i );
+	}
+
+	//-------------------------------------------------------------------------
+	// Overwrite a subrange
+	//-------------------------------------------------------------------------
+
+	{
+		tbt::ScopedMapping<cl_uint> m(da, 50, 60, tbt::mmWriteInvalidate);
+		for(cl_uint *p = m.begin(); p != m.end(); ++p)
+			*p = 0xffffffffu;
+	}
+
+	da.storeBlocking(ha);
+	UTASSERT( ha[49] == 49 && ha[60] == 60 );
+	for(size_t i = 50; i < 60; ++i)
+		UTASSERT( ha[i] == 0xffffffffu );
+
+	//-------------------------------------------------------------------------
+	// Explicit unmap with event
+	//-------------------------------------------------------------------------
+
+	tbt::ScopedMapping<cl_uint> m(da, tbt::mmReadWrite);
+	m[0] = 42;
+
+	cl::Event eventUnmap;
+	m.unmap(&eventUnmap);
+	eventUnmap.wait();
+	UTASSERT( !m.isMapped() );
+
+	da.storeBlocking(ha);
+	UTASSERT( ha[0] == 42 );
+}
+
+
+void MappedArrayTest::testStrategies()
+{
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+
+	tbt::MappingStrategy expected = (devCon->getHostUnifiedMemory() || devCon->getType() == CL_DEVICE_TYPE_CPU) ?
+		tbt::msUseHostPtr : tbt::msAllocHostPtr;
+
+	tbt::MappedArray<cl_uint> maAuto(devCon, 100);
+	UTASSERT( maAuto.getStrategy() == expected );
+
+	//-------------------------------------------------------------------------
+	// Both strategies must work on any device
+	//-------------------------------------------------------------------------
+
+	const size_t n = 12345;
+	tbt::MappingStrategy strategies[2] = { tbt::msUseHostPtr, tbt::msAllocHostPtr };
+
+	for(int s = 0; s < 2; ++s) {
+		tbt::MappedArray<cl_uint> ma(devCon, n, CL_MEM_READ_WRITE, strategies[s]);
+		UTASSERT( ma.getStrategy() == strategies[s] );
+
+		for(size_t i = 0; i < n; ++i)
+			ma[i] = 7*i;
+
+		ma.mapHostToDeviceBlocking();
+
+		tbt::DeviceArray<cl_uint> da(devCon, n);
+		da.copyBlocking(ma);
+		ma.fillBlocking(5);
+
+		ma.mapDeviceToHostBlocking(tbt::mmRead);
+		for(size_t i = 0; i < n; ++i)
+			UTASSERT( ma[i] == 5 );
+
+		tbt::HostArray<cl_uint> ha(n);
+		da.storeBlocking(ha);
+		for(size_t i = 0; i < n; ++i)
+			UTASSERT( ha[i] == 7*i );
+	}
+}
+
+
+void MappedArrayTest::testDeviceArrayTransfers()
+{
+	//-------------------------------------------------------------------------
+	// DeviceArray load/store from/to mapped arrays, mapped and unmapped
+	//-------------------------------------------------------------------------
+
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+
+	const size_t n = 5000;
+	tbt::MappingStrategy strategies[2] = { tbt::msUseHostPtr, tbt::msAllocHostPtr };
+
+	for(int s = 0; s < 2; ++s) {
+		tbt::MappedArray<cl_uint> ma(devCon, n, CL_MEM_READ_WRITE, strategies[s]);
+		tbt::DeviceArray<cl_uint> da(devCon, n);
+		tbt::HostArray<cl_uint> ha(n);
+
+		// mapped: the data is transferred from/to host memory
+		for(size_t i = 0; i < n; ++i)
+			ma[i] = (cl_uint)(2*i);
+		da.loadBlocking(ma);
+
+		da.storeBlocking(ha);
+		bool ok = true;
+		for(size_t i = 0; i < n; ++i)
+			if(ha[i] != 2*i)
+				ok = false;
+		UTASSERT( ok );
+
+		da.fillBlocking(9);
+		da.storeBlocking(ma);
+		ok = true;
+		for(size_t i = 0; i < n; ++i)
+			if(ma[i] != 9)
+				ok = false;
+		UTASSERT( ok );
+
+		// unmapped: the data is copied from/to the buffer object of the mapped array
+		for(size_t i = 0; i < n; ++i)
+			ma[i] = (cl_uint)(3*i);
+		ma.mapHostToDeviceBlocking();
+		UTASSERT( !ma.isMapped() );
+
+		cl::vector<cl::Event> waitList(1);
+		da.load(ma, &waitList[0]);
+		da.store(ha, &waitList[0], tbt::qiCompute, &waitList);
+		waitList[0].wait();
+		ok = true;
+		for(size_t i = 0; i < n; ++i)
+			if(ha[i] != 3*i)
+				ok = false;
+		UTASSERT( ok );
+
+		da.fillBlocking(4);
+		da.storeBlocking(ma);
+		UTASSERT( !ma.isMapped() );
+
+		ma.mapDeviceToHostBlocking(tbt::mmRead);
+		ok = true;
+		for(size_t i = 0; i < n; ++i)
+			if(ma[i] != 4)
+				ok = false;
+		UTASSERT( ok );
+	}
+}
+
+
+void MappedArrayTest::testSharedBuffer()
+{
+	//-------------------------------------------------------------------------
+	// A slice keeps the host memory of a zero-copy mapped array alive
+	//-------------------------------------------------------------------------
+
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+
+	const size_t n = 20000;
+	tbt::DeviceArray<cl_uint> shared;
+	{
+		tbt::MappedArray<cl_uint> ma(devCon, n, CL_MEM_READ_WRITE, tbt::msUseHostPtr);
+		for(size_t i = 0; i < n; ++i)
+			ma[i] = (cl_uint)(5*i);
+		ma.mapHostToDeviceBlocking();
+
+		shared = ma.slice(0, n);
+	}
+
+	// reuse freed host memory (if any) before reading the slice
+	tbt::HostArray<cl_uint> garbage(4*n);
+	garbage.fill(0xabababab);
+
+	tbt::HostArray<cl_uint> ha(n);
+	shared.storeBlocking(ha);
+
+	bool ok = true;
+	for(size_t i = 0; i < n; ++i)
+		if(ha[i] != 5*i)
+			ok = false;
+	UTASSERT( ok );
+}
+
+
+void MappedArrayTest::testWaitEvents()
+{
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+
+	const size_t n = 10000;
+	tbt::MappedArray<cl_uint> ma(devCon, n);
+	for(size_t i = 0; i < n; ++i)
+		ma[i] = 5*i;
+
+	//-------------------------------------------------------------------------
+	// Unmap waiting for a user event
+	//-------------------------------------------------------------------------
+
+	cl::UserEvent userUnmap(devCon->getContext());
+	cl::vector<cl::Event> waitList;
+	waitList.push_back(userUnmap);
+
+	cl::Event eventUnmap;
+	ma.mapHostToDevice(&eventUnmap, &waitList);
+	UTASSERT( !ma.isMapped() );
+	UTASSERT( eventUnmap.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() > CL_COMPLETE );
+
+	userUnmap.setStatus(CL_COMPLETE);
+	eventUnmap.wait();
+
+	//-------------------------------------------------------------------------
+	// Map waiting for a user event
+	//-------------------------------------------------------------------------
+
+	cl::UserEvent userMap(devCon->getContext());
+	waitList.clear();
+	waitList.push_back(userMap);
+
+	cl::Event eventMap;
+	ma.mapDeviceToHost(&eventMap, tbt::mmRead, &waitList);
+	UTASSERT( eventMap.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() > CL_COMPLETE );
+
+	userMap.setStatus(CL_COMPLETE);
+	eventMap.wait();
+	UTASSERT( ma.isMapped() );
+	for(size_t i = 0; i < n; ++i)
+		UTASSERT( ma[i] == 5*i );
+
+	//-------------------------------------------------------------------------
+	// Mapping an already mapped array still waits for the events
+	//-------------------------------------------------------------------------
+
+	cl::UserEvent userMarker(devCon->getContext());
+	waitList.clear();
+	waitList.push_back(userMarker);
+
+	cl::Event eventMarker;
+	ma.mapDeviceToHost(&eventMarker, tbt::mmRead, &waitList);
+	UTASSERT( eventMarker.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() > CL_COMPLETE );
+
+	userMarker.setStatus(CL_COMPLETE);
+	eventMarker.wait();
+	UTASSERT( ma.isMapped() );
+}
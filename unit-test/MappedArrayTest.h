@@ -0,0 +1,24 @@
+
+#ifndef _MAPPED_ARRAY_TEST
+#define _MAPPED_ARRAY_TEST
+
+#include "UnitTest.h"
+
+
+class MappedArrayTest : public UnitTest
+{
+public:
+	MappedArrayTest(bool silent = false) : UnitTest("MappedArray", silent) { }
+
+	bool runTests();
+
+	void testMapUnmap();
+	void testScopedMapping();
+	void testStrategies();
+	void testDeviceArrayTransfers();
+	void testSharedBuffer();
+	void testWaitEvents();
+};
+
+
+#endif
@@ -78,13 +78,20 @@ void MappedStructTest::doTestMapMemory(tbt::DeviceController *devCon)
 	ms->m_d[1] = 25;
 	ms->m_d[2] = 35;
 
-	ms.mapHostToDeviceBlocking();
+	const string type = (sizeof(FLOAT) == sizeof(cl_double)) ? " (double)" : " (float)";
+	{
+		TimedScope timed(*this, "map host to device" + type);
+		ms.mapHostToDeviceBlocking();
+	}
 
 	MappedStructTestModule<FLOAT> test;
 	test.run(ms);
 	devCon->finish();
 
-	ms.mapDeviceToHostBlocking();
+	{
+		TimedScope timed(*this, "map device to host" + type);
+		ms.mapDeviceToHostBlocking();
+	}
 
 	float xRes = x * x;
 	FLOAT yRes = y;
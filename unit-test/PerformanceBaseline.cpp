@@ -0,0 +1,93 @@
+#include "PerformanceBaseline.h"
+#include "UnitTest.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+
+bool PerformanceBaseline::load(const string &fileName)
+{
+	ifstream is(fileName.c_str());
+	if(!is)
+		return false;
+
+	string line;
+	while(getline(is, line)) {
+		if(line.empty() || line[0] == '#')
+			continue;
+
+		size_t tab1 = line.find('\t');
+		size_t tab2 = (tab1 != string::npos) ? line.find('\t', tab1+1) : string::npos;
+		if(tab2 == string::npos)
+			continue;
+
+		istringstream time(line.substr(tab2+1));
+		double ms;
+		if(time >> ms)
+			m_times[line.substr(0, tab1)][line.substr(tab1+1, tab2-tab1-1)] = ms;
+	}
+
+	return true;
+}
+
+
+bool PerformanceBaseline::save(const string &fileName) const
+{
+	ofstream os(fileName.c_str());
+	if(!os)
+		return false;
+
+	os << "# device\tunit/operation\ttime [ms]" << endl;
+	for(map<string, map<string,double> >::const_iterator itD = m_times.begin(); itD != m_times.end(); ++itD)
+		for(map<string,double>::const_iterator it = itD->second.begin(); it != itD->second.end(); ++it)
+			os << itD->first << '\t' << it->first << '\t' << setprecision(6) << it->second << endl;
+
+	return true;
+}
+
+
+unsigned int PerformanceBaseline::check(const string &device, const UnitTest &unit, double tolerance, double minDiff, ostream &os) const
+{
+	map<string, map<string,double> >::const_iterator itD = m_times.find(device);
+
+	unsigned int nRegressions = 0;
+	const map<string,double> &timings = unit.timings();
+
+	ios_base::fmtflags flags = os.flags();
+	streamsize precision = os.precision();
+
+	for(map<string,double>::const_iterator it = timings.begin(); it != timings.end(); ++it) {
+		string key = unit.name() + "/" + it->first;
+
+		map<string,double>::const_iterator itB;
+		if(itD == m_times.end() || (itB = itD->second.find(key)) == itD->second.end()) {
+			os << "  " << key << ": " << fixed << setprecision(3) << it->second << " ms (no baseline)" << endl;
+			continue;
+		}
+
+		double base = itB->second;
+		bool slower = it->second > base * (1.0 + tolerance) && it->second - base > minDiff;
+
+		os << "  " << key << ": " << fixed << setprecision(3) << it->second << " ms (baseline " << base << " ms, "
+		   << showpos << setprecision(1) << ((base > 0.0) ? 100.0 * (it->second - base) / base : 0.0) << noshowpos << "%)"
+		   << (slower ? "  SLOWDOWN!" : "") << endl;
+
+		if(slower)
+			++nRegressions;
+	}
+
+	os.flags(flags);
+	os.precision(precision);
+	return nRegressions;
+}
+
+
+void PerformanceBaseline::update(const string &device, const UnitTest &unit)
+{
+	const map<string,double> &timings = unit.timings();
+	for(map<string,double>::const_iterator it = timings.begin(); it != timings.end(); ++it)
+		m_times[device][unit.name() + "/" + it->first] = it->second;
+}
@@ -0,0 +1,37 @@
+#ifndef _PERFORMANCE_BASELINE_H
+#define _PERFORMANCE_BASELINE_H
+
+#include <iostream>
+#include <map>
+#include <string>
+
+class UnitTest;
+
+
+// Stores the baseline times (in ms) of the timed operations of unit tests per device name.
+//
+// The baseline file contains one line "device<TAB>unit/operation<TAB>time" per operation;
+// empty lines and lines starting with '#' are ignored.
+class PerformanceBaseline
+{
+	std::map<std::string, std::map<std::string,double> > m_times;  // device name -> unit/operation -> time
+
+public:
+	// loads the baseline from file fileName; returns false if the file cannot be read
+	bool load(const std::string &fileName);
+
+	// saves the baseline to file fileName; returns false if the file cannot be written
+	bool save(const std::string &fileName) const;
+
+	// compares the timings of unit with the baseline for device and writes slowdowns to os
+	//
+	// An operation is a regression if it is slower than its baseline by more than the relative tolerance
+	// and by more than minDiff ms. Returns the number of regressions.
+	unsigned int check(const std::string &device, const UnitTest &unit, double tolerance, double minDiff, std::ostream &os = std::cout) const;
+
+	// replaces the baseline of device with the timings of unit
+	void update(const std::string &device, const UnitTest &unit);
+};
+
+
+#endif
@@ -0,0 +1,96 @@
+
+#include "PipelineTest.h"
+#include <tbt/Pipeline.h>
+#include <tbt/KernelPool.h>
+#include <tbt/Global.h>
+
+using namespace std;
+
+
+bool PipelineTest::runTests()
+{
+	try {
+		testPipeline();
+
+	} catch(cl::Error error) {
+		cout << "OpenCL exception occurred:" << endl;
+		cout << "error code: " << error.err() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+
+	} catch(tbt::Error error) {
+		cout << "TBT exception occurred:" << endl;
+		cout << "error code: " << error.code() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+	}
+
+	return ( numberOfErrors() == 0 );
+}
+
+
+struct PipelineTestKernels {
+	cl::Kernel m_kernelTransform;
+
+	PipelineTestKernels(const cl::Program &program) : m_kernelTransform(program, "pipelineTransform") { }
+};
+
+static tbt::KernelPool<PipelineTestKernels> s_kernels("pipeline-test.cl");
+
+
+void PipelineTest::testPipeline()
+{
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+
+	tbt::Pipeline<cl_uint>::ComputeFunction transform =
+		[](tbt::DeviceController *devCon, tbt::QueueId queue, tbt::DeviceArray<cl_uint> &in, tbt::DeviceArray<cl_uint> &out, size_t offset, size_t n)
+	{
+		tbt::KernelPool<PipelineTestKernels>::Handle k = s_kernels.acquire(devCon);
+
+		k->m_kernelTransform.setArg(0, in.getBuffer());
+		k->m_kernelTransform.setArg(1, out.getBuffer());
+		k->m_kernelTransform.setArg(2, (cl_uint)n);
+		k->m_kernelTransform.setArg(3, (cl_uint)offset);
+
+		size_t wgSize = 64;
+		devCon->enqueue1DRangeKernel(k->m_kernelTransform, (n + wgSize - 1) / wgSize * wgSize, wgSize, 0, 0, queue);
+	};
+
+	const size_t n = 1000003;
+	tbt::HostArray<cl_uint> input(n, tbt::HostAllocPolicy(tbt::hmPageAligned));
+	for(size_t i = 0; i < n; ++i)
+		input[i] = (cl_uint) i;
+
+	//-------------------------------------------------------------------------
+	// Double buffering with partial last chunk
+	//-------------------------------------------------------------------------
+
+	tbt::Pipeline<cl_uint> pipeline(devCon, 65536);
+	tbt::HostArray<cl_uint> output;
+	pipeline.run(input, output, transform);
+
+	{
+		TimedScope timed(*this, "double buffering");
+		pipeline.run(input, output, transform);
+	}
+
+	UTASSERT( output.size() == n );
+	for(size_t i = 0; i < n; ++i)
+		UTASSERT( output[i] == 3*i + i/65536*65536 );
+
+	//-------------------------------------------------------------------------
+	// Deeper pipeline, in-place processing
+	//-------------------------------------------------------------------------
+
+	pipeline.setDepth(4);
+	pipeline.setChunkSize(100000);
+	{
+		TimedScope timed(*this, "depth 4, in-place");
+		pipeline.run(input, input, transform);
+	}
+
+	for(size_t i = 0; i < n; ++i)
+		UTASSERT( input[i] == 3*i + i/100000*100000 );
+}
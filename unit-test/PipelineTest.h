@@ -0,0 +1,19 @@
+
+#ifndef _PIPELINE_TEST
+#define _PIPELINE_TEST
+
+#include "UnitTest.h"
+
+
+class PipelineTest : public UnitTest
+{
+public:
+	PipelineTest(bool silent = false) : UnitTest("Pipeline", silent) { }
+
+	bool runTests();
+
+	void testPipeline();
+};
+
+
+#endif
@@ -0,0 +1,163 @@
+
+#include "ProfilerTest.h"
+#include <tbt/Profiler.h>
+#include <tbt/DeviceArray.h>
+#include <tbt/RadixSort.h>
+#include <tbt/Global.h>
+
+#include <sstream>
+
+using namespace std;
+
+
+bool ProfilerTest::runTests()
+{
+	try {
+		testRecords();
+		testChromeTrace();
+
+	} catch(cl::Error error) {
+		cout << "OpenCL exception occurred:" << endl;
+		cout << "error code: " << error.err() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+
+	} catch(tbt::Error error) {
+		cout << "TBT exception occurred:" << endl;
+		cout << "error code: " << error.code() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+	}
+
+	return ( numberOfErrors() == 0 );
+}
+
+
+void ProfilerTest::testRecords()
+{
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+	tbt::DeviceController profCon(devCon->getDevice(), devCon->getContext(), CL_QUEUE_PROFILING_ENABLE);
+
+	tbt::Profiler profiler;
+	profCon.setProfiler(&profiler);
+	UTASSERT( profCon.getProfiler() == &profiler );
+
+	const size_t n = 1 << 16;
+	tbt::HostArray<cl_uint> ha(n);
+	for(size_t i = 0; i < n; ++i)
+		ha[i] = (cl_uint) (n - i);
+
+	tbt::DeviceArray<cl_uint> a(&profCon, n), b(&profCon, n);
+	a.loadBlocking(ha, tbt::qiUpload);
+	b.fillBlocking(7);
+	b.copyBlocking(a);
+	b.storeBlocking(ha, tbt::qiDownload);
+
+	vector<tbt::Profiler::Record> records = profiler.getRecords();
+	UTASSERT( records.size() == 4 );
+	UTASSERT( profiler.numDropped() == 0 );
+
+	if(records.size() == 4) {
+		UTASSERT( records[0].m_category == tbt::pcUpload   && records[0].m_queue == tbt::qiUpload );
+		UTASSERT( records[1].m_category == tbt::pcFill     && records[1].m_queue == tbt::qiCompute );
+		UTASSERT( records[2].m_category == tbt::pcCopy );
+		UTASSERT( records[3].m_category == tbt::pcDownload && records[3].m_queue == tbt::qiDownload );
+
+		for(size_t i = 0; i < records.size(); ++i) {
+			UTASSERT( records[i].m_bytes == n*sizeof(cl_uint) );
+			UTASSERT( records[i].m_device() == profCon.getDevice()() );
+			UTASSERT( records[i].m_queued <= records[i].m_submit );
+			UTASSERT( records[i].m_submit <= records[i].m_start );
+			UTASSERT( records[i].m_start  <= records[i].m_end );
+		}
+	}
+
+	// completed commands are resolved while recording, without losing or reordering records
+	profiler.clear();
+	const size_t numFills = 3000;
+	{
+		TimedScope timed(*this, "3000 profiled fills");
+		for(size_t i = 0; i < numFills; ++i)
+			b.fill((cl_uint)i);
+		profCon.finish();
+	}
+
+	records = profiler.getRecords();
+	UTASSERT( records.size() == numFills );
+	bool ordered = true;
+	for(size_t i = 1; i < records.size(); ++i)
+		if(records[i].m_category != tbt::pcFill || records[i-1].m_end > records[i].m_end)
+			ordered = false;
+	UTASSERT( ordered );
+
+	// kernels are recorded with their function names
+	profiler.clear();
+	tbt::RadixSort radixSort;
+	radixSort.run(a);
+
+	records = profiler.getRecords();
+	UTASSERT( !records.empty() );
+
+	bool foundPermute = false;
+	for(size_t i = 0; i < records.size(); ++i) {
+		UTASSERT( records[i].m_category == tbt::pcKernel );
+		if(records[i].m_name == "radixPermute_gpu")
+			foundPermute = true;
+	}
+	UTASSERT( foundPermute );
+
+	// detached profilers do not record anything
+	profCon.setProfiler(0);
+	profiler.clear();
+	a.loadBlocking(ha);
+	UTASSERT( profiler.getRecords().empty() );
+
+	//-------------------------------------------------------------------------
+	// Commands without profiling information are dropped
+	//-------------------------------------------------------------------------
+
+	tbt::DeviceController plainCon(devCon->getDevice(), devCon->getContext(), 0);
+	plainCon.setProfiler(&profiler);
+
+	tbt::DeviceArray<cl_uint> c(&plainCon, n);
+	c.loadBlocking(ha);
+	UTASSERT( profiler.getRecords().empty() );
+	UTASSERT( profiler.numDropped() == 1 );
+}
+
+
+void ProfilerTest::testChromeTrace()
+{
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+	tbt::DeviceController profCon(devCon->getDevice(), devCon->getContext(), CL_QUEUE_PROFILING_ENABLE);
+
+	tbt::Profiler profiler;
+	profCon.setProfiler(&profiler);
+
+	const size_t n = 4096;
+	tbt::HostArray<cl_uint> ha(n);
+	tbt::DeviceArray<cl_uint> a(&profCon, n);
+	a.fillBlocking(1);
+	a.storeBlocking(ha);
+
+	ostringstream os;
+	profiler.writeChromeTrace(os);
+	string trace = os.str();
+
+	UTASSERT( trace.find("\"traceEvents\"") != string::npos );
+	UTASSERT( trace.find("\"process_name\"") != string::npos );
+	UTASSERT( trace.find("\"cat\":\"fill\"") != string::npos );
+	UTASSERT( trace.find("\"cat\":\"download\"") != string::npos );
+	UTASSERT( trace.find("\"ph\":\"X\"") != string::npos );
+	UTASSERT( trace.find("\"bytes\":16384") != string::npos );
+
+	ostringstream summary;
+	profiler.printSummary(summary);
+	UTASSERT( summary.str().find("fill buffer") != string::npos );
+
+	// the formatting flags of the streams are restored
+	UTASSERT( !(os.flags() & ios_base::fixed) && os.precision() == 6 );
+	UTASSERT( !(summary.flags() & ios_base::fixed) && summary.precision() == 6 );
+}
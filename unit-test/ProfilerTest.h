@@ -0,0 +1,20 @@
+
+#ifndef _PROFILER_TEST
+#define _PROFILER_TEST
+
+#include "UnitTest.h"
+
+
+class ProfilerTest : public UnitTest
+{
+public:
+	ProfilerTest(bool silent = false) : UnitTest("Profiler", silent) { }
+
+	bool runTests();
+
+	void testRecords();
+	void testChromeTrace();
+};
+
+
+#endif
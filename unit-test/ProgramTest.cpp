@@ -0,0 +1,206 @@
+#include "ProgramTest.h"
+#include <tbt/Utility.h>
+#include <tbt/DeviceArray.h>
+#include <tbt/Global.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+
+static int makeDirectory(const char *dirName)    { return _mkdir(dirName); }
+static int removeDirectory(const char *dirName)  { return _rmdir(dirName); }
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int makeDirectory(const char *dirName)    { return mkdir(dirName, 0777); }
+static int removeDirectory(const char *dirName)  { return rmdir(dirName); }
+#endif
+
+using namespace std;
+
+
+static const char s_programSource[] =
+	"__kernel void programTestScale(__global uint *a, uint n, uint c)\n"
+	"{\n"
+	"	uint i = get_global_id(0);\n"
+	"	if(i < n)\n"
+	"		a[i] *= c;\n"
+	"}\n";
+
+
+bool ProgramTest::runTests()
+{
+	try {
+		testRegisteredSource();
+		testUnwritableCache();
+		testBinaryBundle();
+
+	} catch(cl::Error error) {
+		cout << "OpenCL exception occurred:" << endl;
+		cout << "error code: " << error.err() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+
+	} catch(tbt::Error error) {
+		cout << "TBT exception occurred:" << endl;
+		cout << "error code: " << error.code() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+	}
+
+	return ( numberOfErrors() == 0 );
+}
+
+
+//! Runs programTestScale of \a program with factor \a c and returns true if the result is correct.
+static bool runScale(const cl::Program &program, cl_uint c)
+{
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+
+	const cl_uint n = 1000;
+	tbt::HostArray<cl_uint> ha(n);
+	for(cl_uint i = 0; i < n; ++i)
+		ha[i] = i;
+
+	tbt::DeviceArray<cl_uint> da(devCon, n);
+	da.loadBlocking(ha);
+
+	cl::Kernel kernel(program, "programTestScale");
+	kernel.setArg<cl::Buffer>(0, da);
+	kernel.setArg<cl_uint>   (1, n);
+	kernel.setArg<cl_uint>   (2, c);
+
+	cl::Event ev;
+	devCon->enqueue1DRangeKernel(kernel, (n + 63) / 64 * 64, 64, 0, &ev);
+	ev.wait();
+
+	da.storeBlocking(ha);
+
+	for(cl_uint i = 0; i < n; ++i)
+		if(ha[i] != c * i)
+			return false;
+
+	return true;
+}
+
+
+void ProgramTest::testRegisteredSource()
+{
+	// there is no file with this name, so the program can only be built from the registered source
+	tbt::Utility::registerProgramSource("program-test.cl", s_programSource, sizeof(s_programSource)-1);
+	UTASSERT( tbt::Utility::getProgramSource("program-test.cl") == s_programSource );
+
+	cl::Program program;
+	{
+		TimedScope timed(*this, "build registered source");
+		program = tbt::Utility::buildProgram("program-test.cl");
+	}
+	UTASSERT( runScale(program, 3) );
+
+	// unknown programs are reported as missing kernel files
+	bool thrown = false;
+	try {
+		tbt::Utility::getProgramSource("program-test-missing.cl");
+	} catch(tbt::Error error) {
+		thrown = (error.code() == tbt::Error::ecKernelFileNotFound);
+	}
+	UTASSERT( thrown );
+}
+
+
+void ProgramTest::testUnwritableCache()
+{
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+
+	// a directory with the name of the cached binary blocks writing the cache entry
+	string oldCacheDir = tbt::globalConfig.getProgramCacheDir();
+	string cacheDir = tbt::Utility::getExePath() + "program-test-cache";
+	tbt::globalConfig.setProgramCacheDir(cacheDir);
+
+	string deviceDir;
+	UTASSERT( tbt::Utility::getDeviceCacheDir(devCon, deviceDir) );
+	string blocked = deviceDir + tbt::Utility::getPathSeparator() + "program-test-cache.cl.bin";
+	makeDirectory(blocked.c_str());
+
+	// programs with registered sources are built without caching
+	tbt::Utility::registerProgramSource("program-test-cache.cl", s_programSource, sizeof(s_programSource)-1);
+
+	cl::Program program;
+	bool thrown = false;
+	try {
+		program = tbt::Utility::buildProgram("program-test-cache.cl");
+	} catch(tbt::Error) {
+		thrown = true;
+	}
+	UTASSERT( !thrown );
+	if(!thrown)
+		UTASSERT( runScale(program, 7) );
+
+	removeDirectory(blocked.c_str());
+	removeDirectory(deviceDir.c_str());
+	removeDirectory(cacheDir.c_str());
+	tbt::globalConfig.setProgramCacheDir(oldCacheDir);
+}
+
+
+void ProgramTest::testBinaryBundle()
+{
+	//-------------------------------------------------------------------------
+	// register source -> write bundle -> register binary -> build and run
+	//-------------------------------------------------------------------------
+
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+
+	string fileName = tbt::Utility::getExePath() + "program-test-bundle.cpp";
+	tbt::Utility::writeProgramBinaryBundle("program-test.cl", fileName.c_str(), "registerProgramTest");
+
+	ifstream is(fileName.c_str());
+	UTASSERT( is.good() );
+	stringstream ss;
+	ss << is.rdbuf();
+	is.close();
+	remove(fileName.c_str());
+
+	string bundle = ss.str();
+	UTASSERT( bundle.find("void registerProgramTest()") != string::npos );
+
+	// extract the binary and the extensions from the generated source
+	static vector<unsigned char> binary;  // registered binaries must stay valid
+	binary.clear();
+
+	size_t first = bundle.find("] = {");
+	size_t last  = bundle.find("};", first);
+	UTASSERT( first != string::npos && last != string::npos );
+	if(first == string::npos || last == string::npos)
+		return;
+
+	istringstream bytes(bundle.substr(first + 5, last - first - 5));
+	unsigned int byte;
+	char comma;
+	while(bytes >> byte >> comma)
+		binary.push_back((unsigned char)byte);
+	UTASSERT( !binary.empty() );
+
+	size_t extPos = bundle.find(", s_binary, sizeof(s_binary))");
+	size_t extFirst = bundle.find_last_of("\t", extPos);
+	cl_uint extensions = (cl_uint)strtoul(bundle.substr(extFirst + 1, extPos - extFirst - 1).c_str(), 0, 10);
+
+	// the binary is registered under a name without source, so building can only use the binary
+	tbt::Utility::registerProgramBinary("program-test-binary.cl", devCon->getName().c_str(), devCon->getDriverVersion().c_str(),
+		extensions, &binary[0], binary.size());
+
+	cl::Program program;
+	{
+		TimedScope timed(*this, "build registered binary");
+		program = tbt::Utility::buildProgram("program-test-binary.cl");
+	}
+	UTASSERT( runScale(program, 5) );
+}
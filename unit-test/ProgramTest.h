@@ -0,0 +1,20 @@
+#ifndef _PROGRAM_TEST
+#define _PROGRAM_TEST
+
+#include "UnitTest.h"
+
+
+class ProgramTest : public UnitTest
+{
+public:
+	ProgramTest(bool silent = false) : UnitTest("Program", silent) { }
+
+	bool runTests();
+
+	void testRegisteredSource();
+	void testUnwritableCache();
+	void testBinaryBundle();
+};
+
+
+#endif
@@ -0,0 +1,331 @@
+
+#include "RadixSortTest.h"
+#include <tbt/RadixSort.h>
+#include <tbt/HostRadixSort.h>
+#include <tbt/MappedArray.h>
+#include <tbt/algorithm.h>
+#include <tbt/HostArray.h>
+#include <tbt/Global.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+bool RadixSortTest::runTests()
+{
+	try {
+		testSort();
+		testConcurrentSort();
+		testOutOfOrderSort();
+		testAsyncSort();
+		testHostSort();
+
+	} catch(cl::Error error) {
+		cout << "OpenCL exception occurred:" << endl;
+		cout << "error code: " << error.err() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+
+	} catch(tbt::Error error) {
+		cout << "TBT exception occurred:" << endl;
+		cout << "error code: " << error.code() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+	}
+
+	return ( numberOfErrors() == 0 );
+}
+
+
+bool RadixSortTest::sortAndCheck(size_t n, unsigned int seed, tbt::DeviceController *devCon, const char *operation)
+{
+	if(devCon == 0)
+		devCon = tbt::getDeviceController();
+
+	tbt::HostArray<cl_uint> ha(n);
+	for(size_t i = 0; i < n; ++i) {
+		seed = 1664525u * seed + 1013904223u;
+		ha[i] = seed;
+	}
+
+	// the sort must wait for the non-blocking load
+	tbt::DeviceArray<cl_uint> da(devCon, n);
+	cl::vector<cl::Event> waitList(1);
+	da.load(ha, &waitList[0]);
+
+	tbt::RadixSort radixSort;
+	radixSort.run(da, &waitList);
+	if(operation != 0)
+		utTime(operation, radixSort.hostTime());
+
+	da.storeBlocking(ha);
+
+	for(size_t i = 1; i < n; ++i)
+		if(ha[i-1] > ha[i])
+			return false;
+
+	return true;
+}
+
+
+void RadixSortTest::testSort()
+{
+	// the first sort builds the program, hence only subsequent sorts are timed
+	UTASSERT( sortAndCheck(1 << 16, 1) );
+	UTASSERT( sortAndCheck(1 << 20, 2, 0, "sort 2^20") );
+	UTASSERT( sortAndCheck(1 << 16, 3, 0, "sort 2^16") );
+
+	//-------------------------------------------------------------------------
+	// The kernels are built for each device (and context) used
+	//-------------------------------------------------------------------------
+
+	for(int d = 1; d < tbt::numDeviceControllers(); ++d)
+		UTASSERT( sortAndCheck(1 << 16, 4 + d, tbt::getDeviceController(d)) );
+
+	cl::Device device = tbt::getDeviceController()->getDevice();
+	cl::vector<cl::Device> devices(1, device);
+	tbt::DeviceController otherCon(device, cl::Context(devices));
+	UTASSERT( sortAndCheck(1 << 16, 4, &otherCon) );
+}
+
+
+void RadixSortTest::testConcurrentSort()
+{
+	//-------------------------------------------------------------------------
+	// Several host threads sorting different arrays on the same device
+	//-------------------------------------------------------------------------
+
+	const int numThreads = 8;
+	const int numRounds  = 4;
+
+	vector<int> ok(numThreads, 1);
+	vector<thread> threads;
+
+	for(int t = 0; t < numThreads; ++t)
+		threads.push_back(thread([this,t,&ok]() {
+			try {
+				for(int r = 0; r < numRounds; ++r)
+					if(!sortAndCheck(1 << 18, 100*t + r))
+						ok[t] = 0;
+			} catch(...) {
+				ok[t] = 0;
+			}
+		}));
+
+	for(int t = 0; t < numThreads; ++t) {
+		threads[t].join();
+		UTASSERT( ok[t] != 0 );
+	}
+}
+
+
+void RadixSortTest::testOutOfOrderSort()
+{
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+
+	if((devCon->getSupportedCommandQueueProperties() & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) == 0) {
+		cout << "  out-of-order queues not supported, skipping test." << endl;
+		return;
+	}
+
+	tbt::DeviceController oooCon(devCon->getDevice(), devCon->getContext(),
+		CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE | CL_QUEUE_PROFILING_ENABLE);
+	UTASSERT( oooCon.isOutOfOrder() );
+
+	UTASSERT( sortAndCheck(1 << 16, 3, &oooCon) );
+	UTASSERT( sortAndCheck(1 << 20, 4, &oooCon) );
+}
+
+
+void RadixSortTest::testAsyncSort()
+{
+	//-------------------------------------------------------------------------
+	// load -> sort -> store chained by events without host synchronization
+	//-------------------------------------------------------------------------
+
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+	const size_t n = 1 << 18;
+
+	tbt::HostArray<cl_uint> ha(n), hb(n);
+	unsigned int seed = 5;
+	for(size_t i = 0; i < n; ++i) {
+		seed = 1664525u * seed + 1013904223u;
+		ha[i] = seed;
+	}
+
+	tbt::DeviceArray<cl_uint> da(devCon, n);
+	cl::vector<cl::Event> waitList(1);
+	da.load(ha, &waitList[0]);
+
+	tbt::RadixSort radixSort;
+	waitList[0] = radixSort.runAsync(da, &waitList);
+
+	cl::Event evStore;
+	da.store(hb, &evStore, tbt::qiCompute, &waitList);
+	evStore.wait();
+
+	bool sorted = true;
+	for(size_t i = 1; i < n; ++i)
+		if(hb[i-1] > hb[i])
+			sorted = false;
+	UTASSERT( sorted );
+
+	// timing functions must not fail, even if profiling is not enabled
+	UTASSERT( radixSort.totalTimeKernels() >= 0.0 );
+	UTASSERT( radixSort.totalTime() >= 0.0 );
+
+	// a second sort with the same module waits for the first one
+	radixSort.runAsync(da);
+	radixSort.runAsync(da);
+	radixSort.wait();
+	da.storeBlocking(hb);
+
+	sorted = true;
+	for(size_t i = 1; i < n; ++i)
+		if(hb[i-1] > hb[i])
+			sorted = false;
+	UTASSERT( sorted );
+
+	// the module keeps the array alive, so the caller's array may be destroyed before the sort completes
+	{
+		tbt::DeviceArray<cl_uint> dc(devCon, n);
+		dc.loadBlocking(ha);
+		waitList[0] = radixSort.runAsync(dc);
+	}
+	tbt::DeviceArray<cl_uint> dd(devCon, n);
+	dd.fill(0, 0, tbt::qiUpload);
+	radixSort.wait();
+	devCon->finish();
+	dd.storeBlocking(hb);
+
+	bool filled = true;
+	for(size_t i = 0; i < n; ++i)
+		if(hb[i] != 0)
+			filled = false;
+	UTASSERT( filled );
+
+	// sorting a subarray uses a temporary sub-buffer, which is kept until the sort has completed
+	da.loadBlocking(ha);
+	waitList[0] = radixSort.runAsync(da.begin(), da.end());
+	da.store(hb, &evStore, tbt::qiCompute, &waitList);
+	evStore.wait();
+
+	sorted = true;
+	for(size_t i = 1; i < n; ++i)
+		if(hb[i-1] > hb[i])
+			sorted = false;
+	UTASSERT( sorted );
+}
+
+
+void RadixSortTest::testHostSort()
+{
+	//-------------------------------------------------------------------------
+	// host radix-sort of arbitrary sizes compared to std::sort
+	//-------------------------------------------------------------------------
+
+	const size_t sizes[] = { 0, 1, 1000, 65537, 1 << 16, 1 << 20 };
+	unsigned int seed = 7;
+
+	for(size_t s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s) {
+		const size_t n = sizes[s];
+
+		tbt::HostArray<cl_uint> ha(n), hb(n);
+		vector<cl_uint> ref(n);
+		for(size_t i = 0; i < n; ++i) {
+			seed = 1664525u * seed + 1013904223u;
+			ha[i] = hb[i] = ref[i] = (s % 2 == 0) ? seed : (seed & 0xffff);  // also skip passes with a single digit
+		}
+		sort(ref.begin(), ref.end());
+
+		tbt::HostRadixSort hostSort;
+		hostSort.run(ha);
+		if(n == (1 << 20))
+			utTime("host sort 2^20", hostSort.hostTime());
+
+		tbt::radixSort(hb, tbt::beHost);
+
+		bool equal = true;
+		for(size_t i = 0; i < n; ++i)
+			if(ha[i] != ref[i] || hb[i] != ref[i])
+				equal = false;
+		UTASSERT( equal );
+	}
+
+	//-------------------------------------------------------------------------
+	// host and device backend give identical results
+	//-------------------------------------------------------------------------
+
+	const size_t n = 1 << 16;
+	tbt::HostArray<cl_uint> hHost(n), hDevice(n), hAuto(n);
+	for(size_t i = 0; i < n; ++i) {
+		seed = 1664525u * seed + 1013904223u;
+		hHost[i] = hDevice[i] = hAuto[i] = seed;
+	}
+
+	tbt::radixSort(hHost,   tbt::beHost);
+	tbt::radixSort(hDevice, tbt::beDevice);
+	tbt::radixSort(hAuto);
+
+	bool equal = true;
+	for(size_t i = 0; i < n; ++i)
+		if(hHost[i] != hDevice[i] || hHost[i] != hAuto[i])
+			equal = false;
+	UTASSERT( equal );
+
+	//-------------------------------------------------------------------------
+	// mapped arrays keep their mapping state with both backends
+	//-------------------------------------------------------------------------
+
+	tbt::DeviceController *devCon = tbt::getDeviceController();
+	tbt::Backend backends[] = { tbt::beHost, tbt::beDevice };
+
+	for(int b = 0; b < 2; ++b) {
+		for(int m = 0; m < 2; ++m) {
+			tbt::MappedArray<cl_uint> ma(devCon, n);
+			for(size_t i = 0; i < n; ++i)
+				ma[i] = hDevice[n-1-i];
+
+			bool mapped = (m == 0);
+			if(!mapped)
+				ma.mapHostToDeviceBlocking();
+
+			tbt::radixSort(ma, backends[b]);
+			UTASSERT( ma.isMapped() == mapped );
+
+			if(!mapped)
+				ma.mapDeviceToHostBlocking(tbt::mmRead);
+
+			equal = true;
+			for(size_t i = 0; i < n; ++i)
+				if(ma[i] != hDevice[i])
+					equal = false;
+			UTASSERT( equal );
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// the device backend rejects sizes that are not a multiple of 1024
+	//-------------------------------------------------------------------------
+
+	tbt::HostArray<cl_uint> odd(1000);
+	for(size_t i = 0; i < odd.size(); ++i)
+		odd[i] = (cl_uint)(odd.size() - i);
+
+	bool thrown = false;
+	try {
+		tbt::radixSort(odd, tbt::beDevice);
+	} catch(tbt::Error) {
+		thrown = true;
+	}
+	UTASSERT( thrown );
+	UTASSERT( odd[0] == 1000 && odd[999] == 1 );
+
+	tbt::radixSort(odd);
+	UTASSERT( odd[0] == 1 && odd[999] == 1000 );
+}
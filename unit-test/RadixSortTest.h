@@ -0,0 +1,28 @@
+
+#ifndef _RADIX_SORT_TEST
+#define _RADIX_SORT_TEST
+
+#include "UnitTest.h"
+
+namespace tbt { class DeviceController; }
+
+
+class RadixSortTest : public UnitTest
+{
+public:
+	RadixSortTest(bool silent = false) : UnitTest("RadixSort", silent) { }
+
+	bool runTests();
+
+	void testSort();
+	void testConcurrentSort();
+	void testOutOfOrderSort();
+	void testAsyncSort();
+	void testHostSort();
+
+private:
+	bool sortAndCheck(size_t n, unsigned int seed, tbt::DeviceController *devCon = 0, const char *operation = 0);
+};
+
+
+#endif
@@ -0,0 +1,117 @@
+#include "ThreadPoolTest.h"
+#include <tbt/ThreadPool.h>
+#include <tbt/Error.h>
+
+#include <atomic>
+#include <vector>
+
+using namespace std;
+
+
+bool ThreadPoolTest::runTests()
+{
+	try {
+		testParallelFor();
+		testExceptions();
+
+	} catch(cl::Error error) {
+		cout << "OpenCL exception occurred:" << endl;
+		cout << "error code: " << error.err() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+
+	} catch(tbt::Error error) {
+		cout << "TBT exception occurred:" << endl;
+		cout << "error code: " << error.code() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+	}
+
+	return ( numberOfErrors() == 0 );
+}
+
+
+void ThreadPoolTest::testParallelFor()
+{
+	tbt::ThreadPool pool(4);
+	UTASSERT( pool.numThreads() == 4 );
+
+	// every task is run exactly once, also in repeated jobs
+	const size_t n = 10000;
+	vector<atomic<int> > runs(n);
+
+	for(int r = 0; r < 10; ++r) {
+		for(size_t i = 0; i < n; ++i)
+			runs[i] = 0;
+
+		{
+			TimedScope timed(*this, "parallelFor with 10000 tasks");
+			pool.parallelFor(n, [&](size_t i) { ++runs[i]; });
+		}
+
+		bool once = true;
+		for(size_t i = 0; i < n; ++i)
+			if(runs[i] != 1)
+				once = false;
+		UTASSERT( once );
+	}
+
+	// no tasks, a single task, and a pool without worker threads
+	int count = 0;
+	pool.parallelFor(0, [&](size_t) { ++count; });
+	UTASSERT( count == 0 );
+	pool.parallelFor(1, [&](size_t) { ++count; });
+	UTASSERT( count == 1 );
+
+	tbt::ThreadPool single(1);
+	UTASSERT( single.numThreads() == 1 );
+	single.parallelFor(100, [&](size_t) { ++count; });
+	UTASSERT( count == 101 );
+
+	UTASSERT( tbt::ThreadPool::getDefault().numThreads() >= 1 );
+	UTASSERT( &tbt::ThreadPool::getDefault() == &tbt::ThreadPool::getDefault() );
+}
+
+
+void ThreadPoolTest::testExceptions()
+{
+	tbt::ThreadPool pool(4);
+
+	// the remaining tasks are still run, and the exception is passed to the caller
+	atomic<int> count(0);
+	bool caught = false;
+	try {
+		pool.parallelFor(100, [&](size_t i) {
+			++count;
+			if(i == 50)
+				throw tbt::Error("task failed");
+		});
+	} catch(tbt::Error) {
+		caught = true;
+	}
+	UTASSERT( caught );
+	UTASSERT( count == 100 );
+
+	// the pool is still usable
+	count = 0;
+	pool.parallelFor(100, [&](size_t) { ++count; });
+	UTASSERT( count == 100 );
+
+	// a pool without worker threads behaves the same and rethrows the first exception
+	tbt::ThreadPool single(1);
+	count = 0;
+	size_t failed = 0;
+	try {
+		single.parallelFor(100, [&](size_t i) {
+			++count;
+			if(i == 10 || i == 20)
+				throw tbt::Error(i == 10 ? "first" : "second");
+		});
+	} catch(tbt::Error &err) {
+		failed = (err.what() == "first") ? 10 : 20;
+	}
+	UTASSERT( failed == 10 );
+	UTASSERT( count == 100 );
+}
@@ -0,0 +1,19 @@
+#ifndef _THREAD_POOL_TEST
+#define _THREAD_POOL_TEST
+
+#include "UnitTest.h"
+
+
+class ThreadPoolTest : public UnitTest
+{
+public:
+	ThreadPoolTest(bool silent = false) : UnitTest("ThreadPool", silent) { }
+
+	bool runTests();
+
+	void testParallelFor();
+	void testExceptions();
+};
+
+
+#endif
@@ -0,0 +1,82 @@
+
+#include "TimerTest.h"
+#include <tbt/Timer.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace std;
+
+
+bool TimerTest::runTests()
+{
+	try {
+		testTimer();
+		testScopedTimer();
+
+	} catch(cl::Error error) {
+		cout << "OpenCL exception occurred:" << endl;
+		cout << "error code: " << error.err() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+
+	} catch(tbt::Error error) {
+		cout << "TBT exception occurred:" << endl;
+		cout << "error code: " << error.code() << endl;
+		cout << "message:    " << error.what() << endl;
+
+		return false;
+	}
+
+	return ( numberOfErrors() == 0 );
+}
+
+
+void TimerTest::testTimer()
+{
+	// the clock is monotonic
+	cl_ulong t0 = tbt::Timer::now();
+	bool monotonic = true;
+	{
+		TimedScope timed(*this, "100000 calls of now()");
+		for(int i = 0; i < 100000; ++i) {
+			cl_ulong t1 = tbt::Timer::now();
+			if(t1 < t0)
+				monotonic = false;
+			t0 = t1;
+		}
+	}
+	UTASSERT( monotonic );
+
+	tbt::Timer timer;
+	this_thread::sleep_for(chrono::milliseconds(20));
+
+	cl_ulong ns = timer.elapsedNanoseconds();
+	double   ms = timer.elapsed();
+	UTASSERT( ns >= 19000000 );
+	UTASSERT( ms >= 19.0 && ms < 2000.0 );
+	UTASSERT( ms >= 1.e-6 * ns );
+
+	timer.start();
+	UTASSERT( timer.elapsed() < ms );
+}
+
+
+void TimerTest::testScopedTimer()
+{
+	double total = 0.0;
+	{
+		tbt::ScopedTimer timer(total);
+		this_thread::sleep_for(chrono::milliseconds(10));
+	}
+	UTASSERT( total >= 9.0 );
+
+	// scoped timers accumulate
+	double first = total;
+	{
+		tbt::ScopedTimer timer(total);
+		this_thread::sleep_for(chrono::milliseconds(10));
+	}
+	UTASSERT( total >= first + 9.0 );
+}
@@ -0,0 +1,20 @@
+
+#ifndef _TIMER_TEST
+#define _TIMER_TEST
+
+#include "UnitTest.h"
+
+
+class TimerTest : public UnitTest
+{
+public:
+	TimerTest(bool silent = false) : UnitTest("Timer", silent) { }
+
+	bool runTests();
+
+	void testTimer();
+	void testScopedTimer();
+};
+
+
+#endif
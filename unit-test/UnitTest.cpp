@@ -14,3 +14,15 @@ void UnitTest::utAssert(bool expr, const char *strExpr, const char *strFile, uns
 
 	m_nErrors++;
 }
+
+
+void UnitTest::utTime(const string &operation, double ms)
+{
+	lock_guard<mutex> lock(m_timingsMutex);
+
+	map<string,double>::iterator it = m_timings.find(operation);
+	if(it == m_timings.end())
+		m_timings[operation] = ms;
+	else if(ms < it->second)
+		it->second = ms;
+}
@@ -1,7 +1,10 @@
-
 #ifndef _UNIT_TEST_H
 #define _UNIT_TEST_H
 
+#include <tbt/Timer.h>
+
+#include <map>
+#include <mutex>
 #include <string>
 
 
@@ -13,6 +16,9 @@ class UnitTest
 	bool         m_silent;
 	unsigned int m_nErrors;
 
+	std::map<std::string,double> m_timings;       // minimal time (in ms) per timed operation
+	std::mutex                   m_timingsMutex;
+
 public:
 	UnitTest(const std::string &name, bool silent = false) : m_name(name), m_silent(silent), m_nErrors(0) { }
 
@@ -25,8 +31,29 @@ public:
 
 	unsigned int numberOfErrors() const { return m_nErrors; }
 
+	// returns the timed operations and their times in ms (the minimum if an operation has been timed several times)
+	const std::map<std::string,double> &timings() const { return m_timings; }
+
 protected:
 	void utAssert(bool expr, const char *strExpr, const char *strFile, unsigned int line);
+
+	// records time ms (in milliseconds) for operation; thread-safe
+	void utTime(const std::string &operation, double ms);
+
+	// records the time from construction to destruction for an operation
+	class TimedScope
+	{
+		UnitTest    &m_test;
+		std::string  m_operation;
+		tbt::Timer   m_timer;
+
+		TimedScope(const TimedScope &);              // = delete
+		TimedScope &operator=(const TimedScope &);   // = delete
+
+	public:
+		TimedScope(UnitTest &test, const std::string &operation) : m_test(test), m_operation(operation) { }
+		~TimedScope() { m_test.utTime(m_operation, m_timer.elapsed()); }
+	};
 };
 
 
@@ -0,0 +1,19 @@
+
+__kernel
+void graphAdd(__global uint *a, uint n, uint value)
+{
+	uint i = get_global_id(0);
+
+	if(i < n)
+		a[i] += value;
+}
+
+
+__kernel
+void graphMul(__global uint *a, uint n, uint factor)
+{
+	uint i = get_global_id(0);
+
+	if(i < n)
+		a[i] *= factor;
+}
@@ -0,0 +1,9 @@
+
+__kernel
+void pipelineTransform(__global const uint *in, __global uint *out, uint n, uint offset)
+{
+	uint i = get_global_id(0);
+
+	if(i < n)
+		out[i] = 3*in[i] + offset;
+}
@@ -1,21 +1,101 @@
-
 #include <iostream>
+#include <string>
+#include <vector>
+#include "TimerTest.h"
+#include "ThreadPoolTest.h"
+#include "HostArrayTest.h"
+#include "DeviceControllerTest.h"
 #include "DeviceArrayTest.h"
+#include "ProgramTest.h"
 #include "DeviceStructTest.h"
 #include "MappedStructTest.h"
+#include "MappedArrayTest.h"
+#include "PipelineTest.h"
+#include "CommandGraphTest.h"
+#include "ProfilerTest.h"
+#include "RadixSortTest.h"
+#include "PerformanceBaseline.h"
 #include <tbt/Global.h>
+#include <tbt/Utility.h>
 
 
 using namespace std;
 
 
-int main()
+int main(int argc, char *argv[])
 {
-	bool ok = true;
+	cl_device_type deviceType = CL_DEVICE_TYPE_GPU;
+
+	// performance regression mode
+	bool   perfMode       = false;
+	bool   updateBaseline = false;
+	string baselineFile;
+	double tolerance      = 0.2;
+	double minDiff        = 0.5;
+
+	for(int i = 1; i < argc; ++i) {
+		string cmd = argv[i];
+
+		if(cmd == "-h" || cmd == "--help") {
+			cout << "Call with: unit-test options-list" << endl;
+			cout << "\navailable options:" << endl;
+			cout << "\n-d, --device {CPU,GPU}\n  specifies the device used: CPU or GPU (default GPU)" << endl;
+			cout << "\n--perf\n  compare the times of timed operations with the baseline of the device; slowdowns count as errors" << endl;
+			cout << "\n--update-baseline\n  store the times of timed operations as new baseline of the device" << endl;
+			cout << "\n--baseline file\n  the baseline file (default \"perf-baseline.txt\" beside the executable)" << endl;
+			cout << "\n--tolerance percent\n  allowed slowdown relative to the baseline (default 20)" << endl;
+			cout << "\n--min-diff ms\n  slowdowns of at most ms milliseconds are ignored (default 0.5)" << endl;
+			cout << "\n-h, --help\n  display this help and exit" << endl;
+			return 0;
+
+		} else if(cmd == "--perf") {
+			perfMode = true;
+
+		} else if(cmd == "--update-baseline") {
+			updateBaseline = true;
+
+		} else if(cmd == "-d" || cmd == "--device" || cmd == "--baseline" || cmd == "--tolerance" || cmd == "--min-diff") {
+			if(++i >= argc) {
+				cerr << "Missing argument for option " << cmd << endl;
+				return 1;
+			}
+			string arg = argv[i];
+
+			if(cmd == "--baseline")
+				baselineFile = arg;
+			else if(cmd == "--tolerance")
+				tolerance = 0.01 * atof(arg.c_str());
+			else if(cmd == "--min-diff")
+				minDiff = atof(arg.c_str());
+			else if(arg == "CPU" || arg == "cpu")
+				deviceType = CL_DEVICE_TYPE_CPU;
+			else if(arg == "GPU" || arg == "gpu")
+				deviceType = CL_DEVICE_TYPE_GPU;
+			else {
+				cerr << "Unknown device type " << arg << endl;
+				return 1;
+			}
+
+		} else {
+			cerr << "Unknown option: " << cmd << endl;
+			return 1;
+		}
+	}
 
 	//tbt::globalConfig.setCacheProgramBinaries(false);
 
-	tbt::createContext(CL_DEVICE_TYPE_GPU);
+	try {
+		tbt::createContext(deviceType);
+
+	} catch(cl::Error error) {
+		cerr << "Could not create an OpenCL context: " << error.what() << " (error code " << error.err() << ")" << endl;
+		return 1;
+
+	} catch(tbt::Error error) {
+		cerr << "Could not create an OpenCL context: " << error.what() << endl;
+		return 1;
+	}
+
 	cout << "Platform:" << endl;
 	tbt::displayPlatformInfo(cout) << endl;
 
@@ -23,24 +103,81 @@ int main()
 	tbt::DeviceController *devCon = tbt::getDeviceController();
 	devCon->displayInfo() << endl;
 
+	if(baselineFile.empty())
+		baselineFile = tbt::Utility::getExePath() + "perf-baseline.txt";
 
-	DeviceArrayTest devArrayTest;
-	cout << "Testing unit " << devArrayTest.name() << "..." << endl;
-	ok = ok && devArrayTest.runTests();
+	PerformanceBaseline baseline;
+	if(perfMode || updateBaseline) {
+		if(!baseline.load(baselineFile) && perfMode)
+			cout << "No baseline file " << baselineFile << " found." << endl;
+	}
 
-	DeviceStructTest devStructTest;
-	cout << "Testing unit " << devStructTest.name() << "..." << endl;
-	ok = ok && devStructTest.runTests();
 
+	TimerTest        timerTest;
+	ThreadPoolTest   threadPoolTest;
+	HostArrayTest    hostArrayTest;
+	DeviceControllerTest devConTest;
+	DeviceArrayTest  devArrayTest;
+	ProgramTest      programTest;
+	DeviceStructTest devStructTest;
 	MappedStructTest mappedStructTest;
-	cout << "Testing unit " << mappedStructTest.name() << "..." << endl;
-	ok = ok && mappedStructTest.runTests();
+	MappedArrayTest  mappedArrayTest;
+	PipelineTest     pipelineTest;
+	CommandGraphTest commandGraphTest;
+	ProfilerTest     profilerTest;
+	RadixSortTest    radixSortTest;
+
+	vector<UnitTest*> units;
+	units.push_back(&timerTest);
+	units.push_back(&threadPoolTest);
+	units.push_back(&hostArrayTest);
+	units.push_back(&devConTest);
+	units.push_back(&devArrayTest);
+	units.push_back(&programTest);
+	units.push_back(&devStructTest);
+	units.push_back(&mappedStructTest);
+	units.push_back(&mappedArrayTest);
+	units.push_back(&pipelineTest);
+	units.push_back(&commandGraphTest);
+	units.push_back(&profilerTest);
+	units.push_back(&radixSortTest);
 
+	// all units are run, even if a unit fails
+	unsigned int nFailedUnits = 0, nErrors = 0, nRegressions = 0;
+	for(size_t i = 0; i < units.size(); ++i) {
+		UnitTest *unit = units[i];
 
-	if(ok)
+		cout << "Testing unit " << unit->name() << "..." << endl;
+		if(!unit->runTests()) {
+			// a unit aborted by an exception may not have recorded an error
+			++nFailedUnits;
+			nErrors += (unit->numberOfErrors() > 0) ? unit->numberOfErrors() : 1;
+		}
+
+		if(perfMode)
+			nRegressions += baseline.check(devCon->getName(), *unit, tolerance, minDiff);
+		if(updateBaseline)
+			baseline.update(devCon->getName(), *unit);
+	}
+
+	if(updateBaseline) {
+		if(baseline.save(baselineFile))
+			cout << "Baseline written to " << baselineFile << "." << endl;
+		else
+			cout << "Could not write baseline file " << baselineFile << "!" << endl;
+	}
+
+	if(nFailedUnits == 0)
 		cout << "no errors occured." << endl;
 	else
-		cout << "there were " << devArrayTest.numberOfErrors() << " errors!" << endl;
+		cout << nFailedUnits << " units failed, there were " << nErrors << " errors!" << endl;
+
+	if(perfMode) {
+		if(nRegressions == 0)
+			cout << "no performance regressions." << endl;
+		else
+			cout << "there were " << nRegressions << " performance regressions!" << endl;
+	}
 
-	return 0;
+	return (nFailedUnits == 0 && nRegressions == 0) ? 0 : 1;
 }